@@ -0,0 +1,277 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Compression ratio, write and read throughput of variables rewritten with a
+// matrix of chunking and compression settings.
+//
+// Usage: bench_compression [--json path] [--directory path] file variable...
+//
+// Each variable is written in a diskless file, persisted on close to measure
+// its size, then read back from memory: once entirely (scan) and slice by
+// slice along the first dimension (slice). The file is persisted in a
+// temporary directory, unless a directory is given.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <netcdf4_cxx/file.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Chunking and compression settings
+struct Setting {
+  std::string chunking;
+  std::vector<size_t> chunk_sizes;  // empty: contiguous or netCDF default
+  bool contiguous;
+  bool shuffle;
+  int level;
+};
+
+// Measures of a setting
+struct Result {
+  std::string variable;
+  Setting setting;
+  size_t size;
+  double ratio;
+  double write;
+  double scan;
+  double slice;
+};
+
+// Variable loaded in memory
+struct Sample {
+  std::string name;
+  netcdf::type::Primitive type;
+  size_t type_size;
+  std::vector<std::string> dimensions;
+  std::vector<size_t> shape;
+  std::vector<char> data;
+};
+
+static Sample Load(const netcdf::File& file, const std::string& name) {
+  std::shared_ptr<netcdf::Variable> variable = file.FindVariableByPath(name);
+  if (!variable) throw std::invalid_argument(name + ": variable not found");
+  netcdf::type::Generic type = variable->GetDataType();
+  if (!type.IsPrimitive() ||
+      type.GetPrimitive() == netcdf::type::Primitive::kString)
+    throw std::invalid_argument(name + ": only numeric variables are handled");
+
+  Sample result{variable->GetShortName(), type.GetPrimitive(), type.GetSize(),
+                {}, variable->GetShape(), {}};
+  for (auto& item : variable->GetDimensions())
+    result.dimensions.push_back(item.GetShortName());
+  size_t size = result.type_size;
+  for (auto& item : result.shape) size *= item;
+  result.data.resize(size);
+  if (size != 0)
+    netcdf::Check(nc_get_var(variable->nc_id(), variable->id(),
+                             result.data.data()));
+  return result;
+}
+
+// Chunks of about the given number of bytes, keeping the proportions of the
+// shape
+static std::vector<size_t> Balanced(const Sample& sample, const size_t bytes) {
+  const double elements = std::max<double>(1, sample.data.size()) /
+                          static_cast<double>(sample.type_size);
+  const double factor = std::min(
+      1.0, std::pow(static_cast<double>(bytes) / sample.type_size / elements,
+                    1.0 / static_cast<double>(sample.shape.size())));
+  std::vector<size_t> result;
+  for (auto& item : sample.shape) {
+    const double size = std::round(static_cast<double>(item) * factor);
+    result.push_back(std::max<size_t>(1, static_cast<size_t>(size)));
+  }
+  return result;
+}
+
+// Chunks holding one slice along the first dimension
+static std::vector<size_t> Slices(const Sample& sample) {
+  std::vector<size_t> result(sample.shape);
+  for (auto& item : result) item = std::max<size_t>(1, item);
+  result[0] = 1;
+  return result;
+}
+
+static std::vector<Setting> GetSettings(const Sample& sample) {
+  std::vector<Setting> result{{"contiguous", {}, true, false, 0}};
+  std::vector<std::pair<std::string, std::vector<size_t>>> chunks{
+      {"default", {}}};
+  if (!sample.shape.empty()) {
+    chunks.emplace_back("slice", Slices(sample));
+    chunks.emplace_back("64KiB", Balanced(sample, 64 << 10));
+    chunks.emplace_back("1MiB", Balanced(sample, 1 << 20));
+  }
+  for (auto& chunk : chunks) {
+    for (auto level : {0, 1, 4, 9}) {
+      for (auto shuffle : {false, true}) {
+        if (level == 0 && shuffle) continue;
+        result.push_back({chunk.first, chunk.second, false, shuffle, level});
+      }
+    }
+  }
+  return result;
+}
+
+static std::string ToString(const std::vector<size_t>& values) {
+  std::string result;
+  for (auto& item : values) {
+    if (!result.empty()) result += "x";
+    result += std::to_string(item);
+  }
+  return result.empty() ? "-" : result;
+}
+
+static Result Run(const Sample& sample, const Setting& setting,
+                  const std::string& path) {
+  Result result{sample.name, setting, 0, 0, 0, 0, 0};
+  const size_t bytes = sample.data.size();
+
+  benchmark::Timer timer;
+  {
+    netcdf::File file(path, "w", true, true, true);
+    std::vector<netcdf::Dimension> dimensions;
+    for (size_t ix = 0; ix < sample.shape.size(); ++ix)
+      dimensions.push_back(
+          file.AddDimension(sample.dimensions[ix], sample.shape[ix]));
+    netcdf::Variable variable = file.AddVariable(
+        sample.name, netcdf::type::Generic(file, sample.type), dimensions);
+    if (setting.contiguous)
+      variable.SetContiguous();
+    else if (!setting.chunk_sizes.empty())
+      variable.SetChunking(setting.chunk_sizes);
+    if (setting.level != 0 || setting.shuffle)
+      variable.SetDeflate(setting.shuffle, setting.level);
+    if (bytes != 0)
+      netcdf::Check(
+          nc_put_var(variable.nc_id(), variable.id(), sample.data.data()));
+    file.Close();
+  }
+  result.write = benchmark::Throughput(bytes, timer.Elapsed());
+  result.size = benchmark::GetFileSize(path);
+  result.ratio =
+      result.size != 0 ? static_cast<double>(bytes) / result.size : 0;
+
+  netcdf::File file(path, "r", false, true);
+  std::shared_ptr<netcdf::Variable> variable = file.FindVariable(sample.name);
+  std::vector<char> buffer(sample.data.size());
+
+  timer.Reset();
+  if (bytes != 0)
+    netcdf::Check(nc_get_var(variable->nc_id(), variable->id(), buffer.data()));
+  result.scan = benchmark::Throughput(bytes, timer.Elapsed());
+
+  if (!sample.shape.empty() && bytes != 0) {
+    std::vector<size_t> start(sample.shape.size(), 0);
+    std::vector<size_t> count(sample.shape);
+    count[0] = 1;
+    // At most 16 slices, spread over the first dimension
+    const size_t step = std::max<size_t>(1, sample.shape[0] / 16);
+    size_t read = 0;
+    timer.Reset();
+    for (size_t ix = 0; ix < sample.shape[0]; ix += step) {
+      start[0] = ix;
+      netcdf::Check(nc_get_vara(variable->nc_id(), variable->id(),
+                                start.data(), count.data(), buffer.data()));
+      read += bytes / sample.shape[0];
+    }
+    result.slice = benchmark::Throughput(read, timer.Elapsed());
+  }
+  return result;
+}
+
+static void WriteJson(FILE* stream, const std::vector<Result>& results) {
+  fprintf(stream, "[\n");
+  for (size_t ix = 0; ix < results.size(); ++ix) {
+    const Result& item = results[ix];
+    fprintf(stream,
+            "  {\"variable\": \"%s\", \"chunking\": \"%s\", "
+            "\"chunk_sizes\": \"%s\", \"shuffle\": %s, \"level\": %d, "
+            "\"size\": %zu, \"ratio\": %.4f, \"write_mbs\": %.2f, "
+            "\"scan_mbs\": %.2f, \"slice_mbs\": %.2f}%s\n",
+            item.variable.c_str(), item.setting.chunking.c_str(),
+            ToString(item.setting.chunk_sizes).c_str(),
+            item.setting.shuffle ? "true" : "false", item.setting.level,
+            item.size, item.ratio, item.write, item.scan, item.slice,
+            ix + 1 < results.size() ? "," : "");
+  }
+  fprintf(stream, "]\n");
+}
+
+int main(int argc, char** argv) {
+  std::string json;
+  std::string directory;
+  std::vector<std::string> arguments;
+  for (int ix = 1; ix < argc; ++ix) {
+    if (strcmp(argv[ix], "--json") == 0 && ix + 1 < argc)
+      json = argv[++ix];
+    else if (strcmp(argv[ix], "--directory") == 0 && ix + 1 < argc)
+      directory = argv[++ix];
+    else
+      arguments.push_back(argv[ix]);
+  }
+  if (arguments.size() < 2) {
+    fprintf(stderr,
+            "usage: %s [--json path] [--directory path] file variable...\n",
+            argv[0]);
+    return 1;
+  }
+
+  benchmark::TempDirectory temp;
+  const std::string path = directory.empty()
+                               ? temp.Path("bench_compression.nc")
+                               : directory + "/bench_compression.nc";
+  std::vector<Result> results;
+  try {
+    netcdf::File file(arguments[0]);
+    printf("%-16s %-10s %-16s %-7s %5s %12s %7s %10s %10s %10s\n",
+           "variable", "chunking", "chunk sizes", "shuffle", "level",
+           "size (B)", "ratio", "write MB/s", "scan MB/s", "slice MB/s");
+    for (size_t ix = 1; ix < arguments.size(); ++ix) {
+      const Sample sample = Load(file, arguments[ix]);
+      for (auto& setting : GetSettings(sample)) {
+        results.push_back(Run(sample, setting, path));
+        const Result& item = results.back();
+        printf("%-16s %-10s %-16s %-7s %5d %12zu %7.2f %10.1f %10.1f %10.1f\n",
+               item.variable.c_str(), setting.chunking.c_str(),
+               ToString(setting.chunk_sizes).c_str(),
+               setting.shuffle ? "yes" : "no", setting.level, item.size,
+               item.ratio, item.write, item.scan, item.slice);
+      }
+    }
+  } catch (std::exception& error) {
+    fprintf(stderr, "%s\n", error.what());
+    remove(path.c_str());
+    return 1;
+  }
+  remove(path.c_str());
+
+  if (!json.empty()) {
+    FILE* stream = json == "-" ? stdout : fopen(json.c_str(), "w");
+    if (stream == nullptr) {
+      fprintf(stderr, "%s: unable to create the file\n", json.c_str());
+      return 1;
+    }
+    WriteJson(stream, results);
+    if (stream != stdout) fclose(stream);
+  }
+  return 0;
+}
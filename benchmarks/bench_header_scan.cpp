@@ -0,0 +1,108 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Cost of listing the metadata of many classic files: opening each file with
+// the netCDF library and walking its dimensions, variables and attributes,
+// against decoding the header read with classic::Header::Scan.
+//
+// The files are generated in a temporary directory. The time reported is the
+// time needed to process all the files. The results are written in JSON on
+// the standard output.
+//
+// Usage: bench_header_scan [--files count] [--filter substring]
+//                          [--repetitions count] [--min-time seconds]
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <netcdf4_cxx/classic.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Write a classic file with a few dimensions, variables and attributes
+static void Generate(const std::string& path, const size_t index) {
+  netcdf::File file(path, "w", true, false, false,
+                    netcdf::Format::kClassicNetCdf3);
+  auto time = file.AddUnlimitedDimension("time");
+  auto lat = file.AddDimension("lat", 180);
+  auto lon = file.AddDimension("lon", 360);
+  file.AddAttribute("title").WriteText("granule " + std::to_string(index));
+  file.AddAttribute("Conventions").WriteText("CF-1.6");
+  for (auto& name : {"t2m", "u10", "v10", "msl"}) {
+    auto variable =
+        file.AddVariable(name, netcdf::type::Short(file),
+                         std::vector<netcdf::Dimension>({time, lat, lon}));
+    variable.AddAttribute("units").WriteText("1");
+    variable.AddAttribute("scale_factor")
+        .Write(netcdf::type::Double(file), std::vector<double>{0.01});
+    variable.AddAttribute("add_offset")
+        .Write(netcdf::type::Double(file), std::vector<double>{0});
+  }
+}
+
+static size_t ParseFiles(int argc, char** argv) {
+  for (int ix = 1; ix + 1 < argc; ++ix) {
+    if (strcmp(argv[ix], "--files") == 0)
+      return std::max(1L, atol(argv[ix + 1]));
+  }
+  return 1000;
+}
+
+int main(int argc, char** argv) {
+  benchmark::TempDirectory directory;
+  benchmark::Suite suite(argc, argv);
+  std::vector<std::string> paths;
+
+  const size_t files = ParseFiles(argc, argv);
+  for (size_t ix = 0; ix < files; ++ix) {
+    paths.push_back(directory.Path("granule_" + std::to_string(ix) + ".nc"));
+    Generate(paths.back(), ix);
+  }
+  const std::string prefix = "header/" + std::to_string(files) + "/";
+
+  suite.Add(prefix + "nc_open", [&paths] {
+    size_t result = 0;
+    for (auto& path : paths) {
+      netcdf::File file(path);
+      result += file.GetDimensions().size();
+      result += file.GetAttributes().size();
+      for (auto& variable : file.GetVariables()) {
+        result += variable.GetShape().size();
+        result += variable.GetAttributes().size();
+      }
+    }
+    return result;
+  });
+  suite.Add(prefix + "scan", [&paths] {
+    size_t result = 0;
+    for (auto& path : paths) {
+      auto header = netcdf::classic::Header::Scan(path);
+      result += header.dimensions().size();
+      result += header.attributes().size();
+      for (auto& variable : header.variables()) {
+        result += variable.GetRank();
+        result += variable.attributes.size();
+      }
+    }
+    return result;
+  });
+
+  suite.Run(stdout);
+  return 0;
+}
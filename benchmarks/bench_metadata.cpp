@@ -0,0 +1,171 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Scaling of the metadata operations with the number of objects of a file:
+// open, walk of the group tree (list or lazy), lookups by name (group,
+// variable, data type, common parent) and scan of the attributes.
+//
+// The files are generated in a temporary directory. Each one holds about N
+// variables, spread over groups of at most 100 variables nested under an
+// "ensemble" group, with four attributes per variable. The results are
+// written in JSON on the standard output.
+//
+// Usage: bench_metadata [--scales 10,1000,100000] [--filter substring]
+//                       [--repetitions count] [--min-time seconds]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <netcdf4_cxx/file.hpp>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Maximum number of variables per group
+static const size_t kVariablesPerGroup = 100;
+
+// Number of groups holding the variables
+static size_t GetGroups(const size_t variables) {
+  return std::max<size_t>(
+      1, (variables + kVariablesPerGroup - 1) / kVariablesPerGroup);
+}
+
+static std::string GroupName(const size_t index) {
+  return "member_" + std::to_string(index);
+}
+
+static std::string VariableName(const size_t index) {
+  return "var_" + std::to_string(index);
+}
+
+// Write a file holding the given number of variables
+static void Generate(const std::string& path, const size_t variables) {
+  netcdf::File file(path, "w");
+  netcdf::Dimension x = file.AddDimension("x", 1);
+  netcdf::type::Float type(file);
+  netcdf::type::Opaque opaque(file, "blob_t", 8);
+  netcdf::Group ensemble = file.AddGroup("ensemble");
+
+  const size_t groups = GetGroups(variables);
+  for (size_t ix = 0; ix < groups; ++ix) {
+    netcdf::Group group = ensemble.AddGroup(GroupName(ix));
+    const size_t count =
+        std::min(kVariablesPerGroup, variables - ix * kVariablesPerGroup);
+    for (size_t jx = 0; jx < count; ++jx) {
+      netcdf::Variable variable =
+          group.AddVariable(VariableName(jx), type, {x});
+      variable.AddAttribute("units").WriteText("K");
+      variable.AddAttribute("long_name").WriteText(VariableName(jx));
+      variable.AddAttribute("scale_factor")
+          .Write(type, std::vector<float>{1});
+      variable.AddAttribute("add_offset").Write(type, std::vector<float>{0});
+    }
+  }
+}
+
+static std::vector<size_t> ParseScales(int argc, char** argv) {
+  std::vector<size_t> result{10, 1000, 100000};
+  for (int ix = 1; ix + 1 < argc; ++ix) {
+    if (strcmp(argv[ix], "--scales") != 0) continue;
+    result.clear();
+    const char* text = argv[ix + 1];
+    char* end = nullptr;
+    while (*text != '\0') {
+      const size_t value = strtoul(text, &end, 10);
+      if (end == text) break;
+      if (value != 0) result.push_back(value);
+      text = *end == ',' ? end + 1 : end;
+    }
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  benchmark::TempDirectory directory;
+  benchmark::Suite suite(argc, argv);
+  std::vector<std::shared_ptr<netcdf::File>> files;
+
+  for (auto scale : ParseScales(argc, argv)) {
+    const std::string path =
+        directory.Path("metadata_" + std::to_string(scale) + ".nc");
+    Generate(path, scale);
+    files.push_back(std::make_shared<netcdf::File>(path));
+    const netcdf::File& file = *files.back();
+    const netcdf::Group ensemble = *file.FindGroup("ensemble");
+    const size_t groups = GetGroups(scale);
+    const size_t last_variable = scale - (groups - 1) * kVariablesPerGroup - 1;
+    const netcdf::Group first = *ensemble.FindGroup(GroupName(0));
+    const netcdf::Group last = *ensemble.FindGroup(GroupName(groups - 1));
+    const std::string prefix = "metadata/" + std::to_string(scale) + "/";
+
+    suite.Add(prefix + "open", [path] {
+      netcdf::File file(path);
+      return static_cast<size_t>(file.nc_id() != 0);
+    });
+    suite.Add(prefix + "walk", [&file] { return file.Walk().size(); });
+    suite.Add(prefix + "walk_lazy", [&file] {
+      size_t result = 0;
+      for (auto it = file.Tree().begin(); it != file.Tree().end(); ++it) {
+        ++result;
+      }
+      return result;
+    });
+    suite.Add(prefix + "find_group", [ensemble, groups] {
+      return static_cast<size_t>(
+          ensemble.FindGroup(GroupName(groups - 1)) != nullptr);
+    });
+    suite.Add(prefix + "find_variable", [last, last_variable] {
+      return static_cast<size_t>(
+          last.FindVariable(VariableName(last_variable)) != nullptr);
+    });
+    suite.Add(prefix + "find_variable_by_path", [&file, groups] {
+      return static_cast<size_t>(
+          file.FindVariableByPath("/ensemble/" + GroupName(groups - 1) + "/" +
+                                  VariableName(0)) != nullptr);
+    });
+    suite.Add(prefix + "find_data_type", [last] {
+      return static_cast<size_t>(last.FindDataType("blob_t") != nullptr);
+    });
+    suite.Add(prefix + "common_parent", [first, last] {
+      return static_cast<size_t>(first.GetCommonParent(last) != nullptr);
+    });
+    suite.Add(prefix + "attribute_scan", [&file] {
+      size_t result = 0;
+      for (auto& group : file.Walk()) {
+        for (auto& variable : group.GetVariables()) {
+          result += variable.GetAttributes().size();
+        }
+      }
+      return result;
+    });
+    suite.Add(prefix + "attribute_scan_lazy", [&file] {
+      size_t result = 0;
+      file.Visit([&result](const netcdf::Group& group) {
+        group.VisitVariables([&result](const netcdf::Variable& variable) {
+          result += variable.GetNumberOfAttributes();
+          return true;
+        });
+        return netcdf::VisitAction::kContinue;
+      });
+      return result;
+    });
+  }
+
+  suite.Run(stdout);
+  return 0;
+}
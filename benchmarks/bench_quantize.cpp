@@ -0,0 +1,139 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Compression ratio and throughput of the quantization algorithms applied on
+// a float field written with the deflate filter.
+//
+// Usage: bench_quantize [directory] [rows] [columns]
+//
+// The file is written in a temporary directory, unless a directory is given.
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <cmath>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/quantize.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Setting measured
+struct Setting {
+  const char* name;
+  netcdf::QuantizeMode mode;
+  int nsd;
+  bool library;  // quantization done by the netCDF library
+};
+
+// Smooth field with a noisy mantissa, like a physical field computed in
+// single precision
+static std::valarray<float> GetField(const size_t rows, const size_t columns) {
+  std::valarray<float> result(rows * columns);
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(0, 0.01);
+  for (size_t ix = 0; ix < rows; ++ix) {
+    for (size_t jx = 0; jx < columns; ++jx) {
+      result[ix * columns + jx] = static_cast<float>(
+          280 + 15 * std::sin(ix * 0.01) * std::cos(jx * 0.02) +
+          noise(generator));
+    }
+  }
+  return result;
+}
+
+// Write the field and return the elapsed time. The quantization done by
+// this library is included in the measure.
+static double Write(const std::string& path, const std::valarray<float>& field,
+                    const size_t rows, const size_t columns,
+                    const Setting& setting) {
+  benchmark::Timer timer;
+  netcdf::File file(path, "w");
+  netcdf::Dimension x = file.AddDimension("x", rows);
+  netcdf::Dimension y = file.AddDimension("y", columns);
+  netcdf::type::Float type(file);
+  netcdf::Variable variable = file.AddVariable("field", type, {x, y});
+  variable.SetChunking({std::min<size_t>(rows, 256), columns});
+  variable.SetDeflate(true, 4);
+  if (setting.mode == netcdf::QuantizeMode::kNone) {
+    variable.Write(netcdf::Hyperslab(), field);
+  } else if (setting.library) {
+    variable.SetQuantize(setting.mode, setting.nsd);
+    variable.Write(netcdf::Hyperslab(), field);
+  } else {
+    variable.QuantizeAndWrite(netcdf::Hyperslab(), field, setting.mode,
+                              setting.nsd);
+  }
+  file.Close();
+  return timer.Elapsed();
+}
+
+int main(int argc, char** argv) {
+  benchmark::TempDirectory directory;
+  const size_t rows = argc > 2 ? strtoul(argv[2], nullptr, 10) : 2048;
+  const size_t columns = argc > 3 ? strtoul(argv[3], nullptr, 10) : 2048;
+  const std::string path = argc > 1
+                               ? std::string(argv[1]) + "/bench_quantize.nc"
+                               : directory.Path("bench_quantize.nc");
+  const std::valarray<float> field = GetField(rows, columns);
+  const size_t bytes = field.size() * sizeof(float);
+
+  const std::vector<Setting> settings{
+      {"none", netcdf::QuantizeMode::kNone, 0, false},
+      {"BitGroom nsd=3", netcdf::QuantizeMode::kBitGroom, 3, false},
+      {"BitGroom nsd=4", netcdf::QuantizeMode::kBitGroom, 4, false},
+      {"GranularBR nsd=3", netcdf::QuantizeMode::kGranularBitRound, 3, false},
+      {"GranularBR nsd=4", netcdf::QuantizeMode::kGranularBitRound, 4, false},
+      {"BitRound nsb=8", netcdf::QuantizeMode::kBitRound, 8, false},
+      {"BitRound nsb=12", netcdf::QuantizeMode::kBitRound, 12, false},
+      {"BitRound nsb=16", netcdf::QuantizeMode::kBitRound, 16, false},
+      {"BitGroom nsd=3", netcdf::QuantizeMode::kBitGroom, 3, true},
+      {"GranularBR nsd=3", netcdf::QuantizeMode::kGranularBitRound, 3, true},
+      {"BitRound nsb=12", netcdf::QuantizeMode::kBitRound, 12, true}};
+
+  printf("%-18s %-8s %10s %10s %14s %14s\n", "setting", "by", "size (MB)",
+         "ratio", "quantize MB/s", "write MB/s");
+  for (auto& setting : settings) {
+    // Throughput of the quantization done by this library
+    double quantize = 0;
+    if (setting.mode != netcdf::QuantizeMode::kNone && !setting.library) {
+      std::valarray<float> values(field);
+      benchmark::Timer timer;
+      netcdf::Quantize(&values[0], values.size(), setting.mode, setting.nsd,
+                       NC_FILL_FLOAT);
+      quantize = benchmark::Throughput(bytes, timer.Elapsed());
+    }
+
+    double elapsed;
+    try {
+      elapsed = Write(path, field, rows, columns, setting);
+    } catch (std::runtime_error& error) {
+      printf("%-18s %-8s %s\n", setting.name, "netcdf", error.what());
+      continue;
+    }
+    const size_t size = benchmark::GetFileSize(path);
+    printf("%-18s %-8s %10.2f %10.2f %14.1f %14.1f\n", setting.name,
+           setting.library ? "netcdf" : "library",
+           static_cast<double>(size) / (1 << 20),
+           size != 0 ? static_cast<double>(bytes) / size : 0, quantize,
+           benchmark::Throughput(bytes, elapsed));
+  }
+  remove(path.c_str());
+  return 0;
+}
@@ -0,0 +1,124 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+// Crossover between the strided reads of the netCDF library and the reads
+// of the box enclosing the values selected, for a growing step along both
+// dimensions of a 2048 x 2048 grid of floats stored in a classic file, and
+// contiguously or by chunks of 256 x 256 values in a netCDF-4 file.
+//
+// For each step, three reads are timed: nc_get_vars (vars), nc_get_vara of
+// the enclosing box followed by the selection of the values (box), and
+// Variable::Read choosing between both with the cost model (read). The
+// adaptive read should follow the faster of the two others. The results are
+// written in JSON on the standard output.
+//
+// Usage: bench_strided [--filter substring] [--repetitions count]
+//                      [--min-time seconds]
+#include <netcdf.h>
+#include <algorithm>
+#include <memory>
+#include <netcdf4_cxx/file.hpp>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+
+static const size_t kSize = 2048;
+
+// Write the grid in a file
+static void Generate(const std::string& path, const netcdf::Format format,
+                     const bool chunked) {
+  netcdf::File file(path, "w", true, false, false, format);
+  auto y = file.AddDimension("y", kSize);
+  auto x = file.AddDimension("x", kSize);
+  auto variable = file.AddVariable("grid", netcdf::type::Float(file),
+                                   std::vector<netcdf::Dimension>({y, x}));
+  if (format == netcdf::Format::kNetCdf4) {
+    if (chunked)
+      variable.SetChunking(std::vector<size_t>({256, 256}));
+    else
+      variable.SetContiguous();
+  }
+  std::valarray<float> values(kSize * kSize);
+  for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix % 1000;
+  variable.Write(values);
+}
+
+int main(int argc, char** argv) {
+  benchmark::TempDirectory directory;
+  benchmark::Suite suite(argc, argv);
+
+  struct Layout {
+    std::string name;
+    netcdf::Format format;
+    bool chunked;
+  };
+  std::vector<Layout> layouts(
+      {{"classic", netcdf::Format::kClassicNetCdf3, false},
+       {"contiguous", netcdf::Format::kNetCdf4, false},
+       {"chunked", netcdf::Format::kNetCdf4, true}});
+
+  std::vector<std::shared_ptr<netcdf::File>> files;
+  for (auto& layout : layouts) {
+    const std::string path = directory.Path(layout.name + ".nc");
+    Generate(path, layout.format, layout.chunked);
+    files.push_back(std::make_shared<netcdf::File>(path));
+    auto variable = *files.back()->FindVariable("grid");
+
+    for (ptrdiff_t step : {2, 4, 8, 16, 32, 64}) {
+      // A block of 512 x 512 values selected
+      const size_t end = std::min(512 * static_cast<size_t>(step), kSize);
+      netcdf::Hyperslab hyperslab(std::vector<size_t>({0, 0}),
+                                  std::vector<size_t>({end, end}),
+                                  std::vector<ptrdiff_t>({step, step}));
+      const std::string prefix =
+          "strided/" + layout.name + "/" + std::to_string(step) + "/";
+
+      suite.Add(prefix + "vars", [variable, hyperslab] {
+        std::vector<float> values(hyperslab.GetSize());
+        netcdf::Check(nc_get_vars_float(
+            variable.nc_id(), variable.id(), &hyperslab.start()[0],
+            &hyperslab.GetSizeList()[0], &hyperslab.step()[0], &values[0]));
+        return hyperslab.GetSize() * sizeof(float);
+      });
+      suite.Add(prefix + "box", [variable, hyperslab] {
+        const size_t count = hyperslab.GetSize(0);
+        const size_t step = hyperslab.step()[0];
+        std::vector<size_t> start({0, 0});
+        std::vector<size_t> size({(count - 1) * step + 1,
+                                  (count - 1) * step + 1});
+        std::vector<float> box(size[0] * size[1]);
+        netcdf::Check(nc_get_vara_float(variable.nc_id(), variable.id(),
+                                        &start[0], &size[0], &box[0]));
+        std::vector<float> values(count * count);
+        for (size_t ix = 0; ix < count; ++ix) {
+          for (size_t jx = 0; jx < count; ++jx) {
+            values[ix * count + jx] = box[ix * step * size[1] + jx * step];
+          }
+        }
+        return hyperslab.GetSize() * sizeof(float);
+      });
+      suite.Add(prefix + "read", [variable, hyperslab] {
+        variable.Read<float>(hyperslab);
+        return hyperslab.GetSize() * sizeof(float);
+      });
+    }
+  }
+
+  suite.Run(stdout);
+  return 0;
+}
@@ -0,0 +1,205 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Micro and macro benchmarks of the read and write hot paths: reads of
+// contiguous, strided and chunked variables, Hyperslab handling, unpacking of
+// packed values, attribute lookups, Any arithmetic and query evaluation.
+//
+// The inputs are generated, with a fixed seed, in a temporary directory. The
+// results are written in JSON on the standard output.
+//
+// Usage: bench_suite [--filter substring] [--repetitions count]
+//                    [--min-time seconds]
+#include <stdio.h>
+#include <cmath>
+#include <netcdf4_cxx/any.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/query.hpp>
+#include <netcdf4_cxx/scale_missing.hpp>
+#include <random>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#include "benchmark.hpp"
+
+// Shape of the variables generated
+static const size_t kRows = 1024;
+static const size_t kColumns = 1024;
+
+// Number of attributes defined on the variable "attributes"
+static const size_t kAttributes = 256;
+
+// Write the inputs of the benchmarks
+static void Generate(const std::string& path) {
+  netcdf::File file(path, "w");
+  netcdf::Dimension x = file.AddDimension("x", kRows);
+  netcdf::Dimension y = file.AddDimension("y", kColumns);
+  netcdf::type::Double double_type(file);
+  netcdf::type::Short short_type(file);
+
+  std::mt19937 generator(42);
+  std::normal_distribution<double> noise(0, 1);
+  std::valarray<double> values(kRows * kColumns);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = 280 + 10 * std::sin(ix * 1e-3) + noise(generator);
+  }
+
+  netcdf::Variable contiguous =
+      file.AddVariable("contiguous", double_type, {x, y});
+  contiguous.SetContiguous();
+  contiguous.AddAttribute("units").WriteText("K");
+  contiguous.Write(netcdf::Hyperslab(), values);
+
+  netcdf::Variable chunked = file.AddVariable("chunked", double_type, {x, y});
+  chunked.SetChunking({64, 64});
+  chunked.AddAttribute("units").WriteText("K");
+  chunked.Write(netcdf::Hyperslab(), values);
+
+  // Every 97th value is missing
+  netcdf::Variable packed = file.AddVariable("packed", short_type, {x, y});
+  packed.AddAttribute("scale_factor")
+      .Write(double_type, std::vector<double>{0.01});
+  packed.AddAttribute("add_offset")
+      .Write(double_type, std::vector<double>{280});
+  packed.AddAttribute("_FillValue")
+      .Write(short_type, std::vector<short>{-32768});
+  packed.AddAttribute("units").WriteText("K");
+  std::valarray<short> raw(values.size());
+  for (size_t ix = 0; ix < raw.size(); ++ix) {
+    raw[ix] = ix % 97 == 0
+                  ? -32768
+                  : static_cast<short>(std::round((values[ix] - 280) * 100));
+  }
+  packed.Write(netcdf::Hyperslab(), raw);
+
+  netcdf::Variable attributes = file.AddVariable("attributes", short_type, {x});
+  for (size_t ix = 0; ix < kAttributes; ++ix) {
+    attributes.AddAttribute("attribute_" + std::to_string(ix))
+        .Write(double_type, std::vector<double>{static_cast<double>(ix)});
+  }
+}
+
+template <typename T>
+static size_t Bytes(const std::valarray<T>& values) {
+  return values.size() * sizeof(T);
+}
+
+int main(int argc, char** argv) {
+  benchmark::TempDirectory directory;
+  const std::string path = directory.Path("inputs.nc");
+  Generate(path);
+
+  netcdf::File file(path);
+  const netcdf::Variable contiguous = *file.FindVariable("contiguous");
+  const netcdf::Variable chunked = *file.FindVariable("chunked");
+  const netcdf::Variable packed = *file.FindVariable("packed");
+  const netcdf::Variable attributes = *file.FindVariable("attributes");
+  const std::vector<size_t> shape{kRows, kColumns};
+  const netcdf::Hyperslab strided(std::vector<size_t>{0, 0}, shape,
+                                  std::vector<ptrdiff_t>{4, 4});
+  const netcdf::Hyperslab row(std::vector<size_t>{kRows / 2, 0},
+                              std::vector<size_t>{kRows / 2 + 1, kColumns});
+  const netcdf::Hyperslab column(std::vector<size_t>{0, kColumns / 2},
+                                 std::vector<size_t>{kRows, kColumns / 2 + 1});
+  netcdf::Query query;
+  const std::valarray<double> values = contiguous.Read<double>();
+
+  benchmark::Suite suite(argc, argv);
+
+  // Reads
+  suite.Add("read/contiguous/full",
+            [&] { return Bytes(contiguous.Read<double>()); });
+  suite.Add("read/contiguous/strided",
+            [&] { return Bytes(contiguous.Read<double>(strided)); });
+  suite.Add("read/contiguous/column",
+            [&] { return Bytes(contiguous.Read<double>(column)); });
+  suite.Add("read/chunked/full",
+            [&] { return Bytes(chunked.Read<double>()); });
+  suite.Add("read/chunked/row",
+            [&] { return Bytes(chunked.Read<double>(row)); });
+  suite.Add("read/chunked/column",
+            [&] { return Bytes(chunked.Read<double>(column)); });
+
+  // Hyperslab handling
+  suite.Add("hyperslab/define", [&] {
+    size_t result = 0;
+    for (size_t ix = 0; ix < 1000; ++ix) {
+      netcdf::Hyperslab hyperslab(std::vector<size_t>{ix % kRows, 0},
+                                  std::vector<size_t>{kRows, kColumns},
+                                  std::vector<ptrdiff_t>{1, 2});
+      result += hyperslab.GetSize() + hyperslab.OnlyAdjacent();
+    }
+    return result;
+  });
+
+  // Unpacking
+  suite.Add("unpack/mask_and_deflate", [&] {
+    std::valarray<double> result = values;
+    packed.GetScaleMissing().MaskAndDeflate(result, 0.0);
+    return Bytes(result);
+  });
+  suite.Add("unpack/read_mask_and_scale",
+            [&] { return Bytes(packed.ReadMaskAndScale<double>()); });
+  suite.Add("unpack/read_unpacked",
+            [&] { return Bytes(packed.ReadUnpacked<double>()); });
+  suite.Add("unpack/read_packed", [&] {
+    netcdf::PackedArray<short> result = packed.ReadPacked<short>();
+    return Bytes(result.Unpack<float>());
+  });
+  suite.Add("unpack/scale_missing", [&] {
+    return static_cast<size_t>(netcdf::ScaleMissing(packed).HasScaleOffset());
+  });
+
+  // Attributes
+  suite.Add("attributes/find", [&] {
+    size_t result = 0;
+    for (size_t ix = 0; ix < kAttributes; ix += 16) {
+      result += attributes.FindAttribute("attribute_" + std::to_string(ix)) !=
+                nullptr;
+    }
+    return result;
+  });
+  suite.Add("attributes/find_ignore_case", [&] {
+    return static_cast<size_t>(
+        attributes.FindAttribute("ATTRIBUTE_255", true) != nullptr);
+  });
+
+  // Any arithmetic
+  suite.Add("any/arithmetic", [&] {
+    // x * y + x / 2 - y
+    const netcdf::Any x(values);
+    const netcdf::Any y(values);
+    netcdf::Any result(x);
+    netcdf::Any half(x);
+    result *= y;
+    half /= netcdf::Any(2.0);
+    result += half;
+    result -= y;
+    return Bytes(result.Cast<std::valarray<double>>());
+  });
+
+  // Query evaluation
+  suite.Add("query/variable",
+            [&] { return Bytes(query.Evaluate(file, "${contiguous}")); });
+  suite.Add("query/expression", [&] {
+    return Bytes(query.Evaluate(
+        file, "sqrt(${contiguous} * ${chunked}) - ${packed} * 0.5"));
+  });
+
+  suite.Run(stdout);
+  return 0;
+}
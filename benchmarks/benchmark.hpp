@@ -0,0 +1,235 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/system/error_code.hpp>
+#include <chrono>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+/**
+ * Measure the elapsed time
+ */
+class Timer {
+ public:
+  /**
+   * Start the measurement
+   */
+  Timer() : start_(Clock::now()) {}
+
+  /**
+   * Restart the measurement
+   */
+  void Reset() { start_ = Clock::now(); }
+
+  /**
+   * Get the time elapsed since the start of the measurement
+   *
+   * @return the elapsed time in seconds
+   */
+  double Elapsed() const {
+    return std::chrono::duration<double>(Clock::now() - start_).count();
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start_;
+};
+
+/**
+ * Get the size of a file
+ *
+ * @param path path to the file
+ * @return the size of the file in bytes
+ */
+inline size_t GetFileSize(const std::string& path) {
+  FILE* stream = fopen(path.c_str(), "rb");
+  if (stream == nullptr) return 0;
+  fseek(stream, 0, SEEK_END);
+  const long result = ftell(stream);
+  fclose(stream);
+  return result < 0 ? 0 : static_cast<size_t>(result);
+}
+
+/**
+ * Get the throughput of a process
+ *
+ * @param bytes number of bytes processed
+ * @param seconds elapsed time
+ * @return the throughput in MB/s
+ */
+inline double Throughput(const size_t bytes, const double seconds) {
+  return seconds > 0 ? static_cast<double>(bytes) / seconds / (1 << 20) : 0;
+}
+
+/**
+ * Temporary directory holding the inputs of the benchmarks, removed with its
+ * content on destruction
+ */
+class TempDirectory {
+ public:
+  /**
+   * Create the directory
+   */
+  TempDirectory()
+      : path_(boost::filesystem::temp_directory_path() /
+              boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(path_);
+  }
+
+  /**
+   * Remove the directory
+   */
+  ~TempDirectory() {
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(path_, ec);
+  }
+
+  /**
+   * Get the path to a file of the directory
+   *
+   * @param name name of the file
+   * @return the path to the file
+   */
+  std::string Path(const std::string& name) const {
+    return (path_ / name).native();
+  }
+
+ private:
+  boost::filesystem::path path_;
+};
+
+/**
+ * Set of benchmarks measured one after the other.
+ *
+ * Each benchmark is a function processing its input once and returning the
+ * number of bytes processed. The function is first called until a minimum
+ * time is spent to calibrate the number of iterations of a repetition, then
+ * the repetitions are timed. The results are written in JSON, in the order
+ * of registration, with a fixed layout so that the output of two builds can
+ * be compared line by line.
+ */
+class Suite {
+ public:
+  /**
+   * Benchmark function: returns the number of bytes processed
+   */
+  using Function = std::function<size_t()>;
+
+  /**
+   * Create a suite from the command line options: --filter <substring>,
+   * --repetitions <count>, --min-time <seconds>
+   *
+   * @param argc number of arguments
+   * @param argv arguments
+   */
+  Suite(int argc, char** argv) : filter_(), repetitions_(10), min_time_(0.05) {
+    for (int ix = 1; ix < argc; ++ix) {
+      if (strcmp(argv[ix], "--filter") == 0 && ix + 1 < argc)
+        filter_ = argv[++ix];
+      else if (strcmp(argv[ix], "--repetitions") == 0 && ix + 1 < argc)
+        repetitions_ = std::max(1, atoi(argv[++ix]));
+      else if (strcmp(argv[ix], "--min-time") == 0 && ix + 1 < argc)
+        min_time_ = atof(argv[++ix]);
+    }
+  }
+
+  /**
+   * Register a benchmark
+   *
+   * @param name name of the benchmark
+   * @param function function measured
+   */
+  void Add(const std::string& name, Function function) {
+    if (filter_.empty() || name.find(filter_) != std::string::npos)
+      cases_.push_back(Case{name, std::move(function)});
+  }
+
+  /**
+   * Run the benchmarks and write the results
+   *
+   * @param stream stream receiving the results
+   */
+  void Run(FILE* stream) {
+    fprintf(stream, "{\n  \"repetitions\": %d,\n  \"benchmarks\": [\n",
+            repetitions_);
+    for (size_t ix = 0; ix < cases_.size(); ++ix) {
+      Measure(cases_[ix], stream, ix + 1 == cases_.size());
+      fflush(stream);
+    }
+    fprintf(stream, "  ]\n}\n");
+  }
+
+ private:
+  struct Case {
+    std::string name;
+    Function function;
+  };
+
+  std::vector<Case> cases_;
+  std::string filter_;
+  int repetitions_;
+  double min_time_;
+  volatile size_t sink_ = 0;
+
+  void Measure(const Case& item, FILE* stream, const bool last) {
+    // Calibration of the number of iterations of a repetition
+    size_t iterations = 1;
+    size_t bytes = 0;
+    while (true) {
+      Timer timer;
+      for (size_t ix = 0; ix < iterations; ++ix) bytes = item.function();
+      if (timer.Elapsed() >= min_time_ || iterations >= (1U << 30)) break;
+      iterations *= 2;
+    }
+    sink_ = sink_ + bytes;
+
+    std::vector<double> times;
+    for (int ix = 0; ix < repetitions_; ++ix) {
+      Timer timer;
+      for (size_t jx = 0; jx < iterations; ++jx) sink_ = item.function();
+      times.push_back(timer.Elapsed() * 1e9 / static_cast<double>(iterations));
+    }
+    std::sort(times.begin(), times.end());
+    const double median = times.size() % 2 == 1
+                              ? times[times.size() / 2]
+                              : (times[times.size() / 2 - 1] +
+                                 times[times.size() / 2]) *
+                                    0.5;
+    const double mean = std::accumulate(times.begin(), times.end(), 0.0) /
+                        static_cast<double>(times.size());
+    fprintf(stream,
+            "    {\"name\": \"%s\", \"iterations\": %zu, "
+            "\"min_ns\": %.1f, \"median_ns\": %.1f, \"mean_ns\": %.1f, "
+            "\"bytes\": %zu, \"median_mbs\": %.2f}%s\n",
+            item.name.c_str(), iterations, times.front(), median, mean, bytes,
+            Throughput(bytes, median * 1e-9), last ? "" : ",");
+  }
+};
+
+}  // namespace benchmark
@@ -0,0 +1,102 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Write a synthetic dataset for performance testing.
+//
+// Usage: generate_dataset [options] path
+//   --seed N          seed of the pseudo-random values (0)
+//   --groups N        number of groups (4)
+//   --variables N     number of variables per group (4)
+//   --times N         number of records (24)
+//   --rows N          number of latitudes (720)
+//   --columns N       number of longitudes (1440)
+//   --fill-ratio X    fraction of the values missing (0.05)
+//   --noise X         relative amplitude of the noise (0.05)
+//   --level N         deflate level, 0 to disable compression (1)
+//   --no-shuffle      turn off the shuffle filter
+//   --chunk T,R,C     chunk sizes (1,180,360)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "benchmark.hpp"
+#include "generator.hpp"
+
+static std::vector<size_t> ParseChunk(const char* text) {
+  std::vector<size_t> result;
+  char* end = nullptr;
+  while (*text != '\0') {
+    result.push_back(strtoul(text, &end, 10));
+    if (end == text) break;
+    text = *end == ',' ? end + 1 : end;
+  }
+  return result;
+}
+
+int main(int argc, char** argv) {
+  benchmark::DatasetOptions options;
+  std::string path;
+  for (int ix = 1; ix < argc; ++ix) {
+    const bool has_value = ix + 1 < argc;
+    if (strcmp(argv[ix], "--seed") == 0 && has_value)
+      options.seed = strtoull(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--groups") == 0 && has_value)
+      options.groups = strtoul(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--variables") == 0 && has_value)
+      options.variables = strtoul(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--times") == 0 && has_value)
+      options.times = strtoul(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--rows") == 0 && has_value)
+      options.rows = strtoul(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--columns") == 0 && has_value)
+      options.columns = strtoul(argv[++ix], nullptr, 10);
+    else if (strcmp(argv[ix], "--fill-ratio") == 0 && has_value)
+      options.fill_ratio = atof(argv[++ix]);
+    else if (strcmp(argv[ix], "--noise") == 0 && has_value)
+      options.noise = atof(argv[++ix]);
+    else if (strcmp(argv[ix], "--level") == 0 && has_value)
+      options.deflate_level = atoi(argv[++ix]);
+    else if (strcmp(argv[ix], "--no-shuffle") == 0)
+      options.shuffle = false;
+    else if (strcmp(argv[ix], "--chunk") == 0 && has_value)
+      options.chunk = ParseChunk(argv[++ix]);
+    else if (argv[ix][0] != '-' && path.empty())
+      path = argv[ix];
+    else {
+      fprintf(stderr, "%s: unknown option\n", argv[ix]);
+      return 1;
+    }
+  }
+  if (path.empty()) {
+    fprintf(stderr, "usage: %s [options] path\n", argv[0]);
+    return 1;
+  }
+
+  try {
+    const double elapsed = benchmark::DatasetGenerator(options).Generate(path);
+    const size_t size = benchmark::GetFileSize(path);
+    printf("%s: %zu bytes written (%zu bytes of values) in %.2f s, %.1f MB/s, "
+           "compression ratio %.2f\n",
+           path.c_str(), size, options.GetSize(), elapsed,
+           benchmark::Throughput(options.GetSize(), elapsed),
+           size != 0 ? static_cast<double>(options.GetSize()) / size : 0);
+  } catch (std::exception& error) {
+    fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  return 0;
+}
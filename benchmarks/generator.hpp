@@ -0,0 +1,237 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <netcdf4_cxx/cf.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/packing.hpp>
+#include <stdexcept>
+#include <string>
+#include <valarray>
+#include <vector>
+
+#include "benchmark.hpp"
+
+namespace benchmark {
+
+/**
+ * Description of a synthetic dataset
+ */
+struct DatasetOptions {
+  uint64_t seed = 0;           //!< seed of the pseudo-random values
+  size_t groups = 4;           //!< number of groups
+  size_t variables = 4;        //!< number of variables per group
+  size_t times = 24;           //!< number of records (unlimited dimension)
+  size_t rows = 720;           //!< number of latitudes
+  size_t columns = 1440;       //!< number of longitudes
+  double fill_ratio = 0.05;    //!< fraction of the values missing
+  double noise = 0.05;         //!< amplitude of the noise, relative to the
+                               //!< signal: the larger, the less compressible
+  int deflate_level = 1;       //!< deflate level, 0 to disable compression
+  bool shuffle = true;         //!< turn on the shuffle filter
+  std::vector<size_t> chunk{1, 180, 360};  //!< chunk sizes (time, lat, lon)
+
+  /**
+   * Get the size of the values generated
+   *
+   * @return the number of bytes written, before compression
+   */
+  size_t GetSize() const {
+    return groups * variables * times * rows * columns * sizeof(short);
+  }
+};
+
+/**
+ * Write synthetic datasets shaped like the outputs of a forecast system:
+ * coordinates in the root group, a group per member holding packed int16
+ * variables with a _FillValue, along an unlimited time dimension, chunked
+ * and compressed.
+ *
+ * The values only depend on the seed and on their position: a smooth field
+ * moving with time, plus a noise, packed with the scale_factor and the
+ * add_offset defined by the CF conventions, with blocks of missing values.
+ * The dataset is written record by record: a single record of a variable is
+ * held in memory.
+ */
+class DatasetGenerator {
+ public:
+  /**
+   * Create a new generator
+   *
+   * @param options description of the dataset
+   */
+  explicit DatasetGenerator(const DatasetOptions& options) : options_(options) {
+    if (options_.chunk.size() != 3)
+      throw std::invalid_argument("chunk sizes must be given for 3 dimensions");
+    if (options_.rows == 0 || options_.columns == 0)
+      throw std::invalid_argument("the grid must not be empty");
+  }
+
+  /**
+   * Write the dataset
+   *
+   * @param path path to the file created
+   * @return the elapsed time, in seconds
+   */
+  double Generate(const std::string& path) const {
+    Timer timer;
+    netcdf::File file(path, "w");
+    netcdf::Dimension time = file.AddUnlimitedDimension("time");
+    netcdf::Dimension lat = file.AddDimension("lat", options_.rows);
+    netcdf::Dimension lon = file.AddDimension("lon", options_.columns);
+    netcdf::type::Double double_type(file);
+    netcdf::type::Float float_type(file);
+    netcdf::type::Short short_type(file);
+
+    netcdf::Variable time_var = file.AddVariable("time", double_type, {time});
+    time_var.AddAttribute("units").WriteText("hours since 2000-01-01");
+    WriteCoordinate(file.AddVariable("lat", float_type, {lat}), -90, 90,
+                    options_.rows, "degrees_north");
+    WriteCoordinate(file.AddVariable("lon", float_type, {lon}), 0, 360,
+                    options_.columns, "degrees_east");
+
+    // Definition of the variables
+    std::vector<netcdf::Variable> variables;
+    std::vector<size_t> chunk(options_.chunk);
+    chunk[1] = std::min(std::max<size_t>(chunk[1], 1), options_.rows);
+    chunk[2] = std::min(std::max<size_t>(chunk[2], 1), options_.columns);
+    chunk[0] = std::max<size_t>(chunk[0], 1);
+    for (size_t ix = 0; ix < options_.groups; ++ix) {
+      netcdf::Group group = file.AddGroup(Name("member_", ix));
+      for (size_t jx = 0; jx < options_.variables; ++jx) {
+        netcdf::Variable variable =
+            group.AddVariable(Name("var_", jx), short_type, {time, lat, lon});
+        variable.SetChunking(chunk);
+        if (options_.deflate_level > 0 || options_.shuffle)
+          variable.SetDeflate(options_.shuffle, options_.deflate_level);
+        // The values are unpacked with packed * scale_factor + add_offset
+        const netcdf::Packing packing = GetPacking(jx);
+        variable.AddAttribute(netcdf::CF::SCALE_FACTOR)
+            .Write(double_type,
+                   std::vector<double>{packing.get_scale_factor()});
+        variable.AddAttribute(netcdf::CF::ADD_OFFSET)
+            .Write(double_type, std::vector<double>{packing.get_add_offset()});
+        variable.AddAttribute("_FillValue")
+            .Write(short_type, std::vector<short>{kFillValue});
+        variable.AddAttribute("units").WriteText("K");
+        variables.push_back(variable);
+      }
+    }
+
+    // Record by record
+    std::valarray<double> values(options_.rows * options_.columns);
+    std::valarray<short> packed(values.size());
+    for (size_t tx = 0; tx < options_.times; ++tx) {
+      time_var.Write(netcdf::Hyperslab(std::vector<size_t>{tx},
+                                       std::vector<size_t>{tx + 1}),
+                     std::valarray<double>(static_cast<double>(tx), 1));
+      const netcdf::Hyperslab record(
+          std::vector<size_t>{tx, 0, 0},
+          std::vector<size_t>{tx + 1, options_.rows, options_.columns});
+      for (size_t ix = 0; ix < variables.size(); ++ix) {
+        const size_t jx = ix % options_.variables;
+        Fill(ix, jx, tx, values);
+        GetPacking(jx).Pack(&values[0], values.size(), &packed[0],
+                            kFillValue);
+        variables[ix].Write(record, packed);
+      }
+    }
+    file.Close();
+    return timer.Elapsed();
+  }
+
+ private:
+  static constexpr short kFillValue = -32768;
+  static constexpr double kPi = 3.14159265358979323846;
+  DatasetOptions options_;
+
+  static std::string Name(const std::string& prefix, const size_t index) {
+    const std::string result = std::to_string(index);
+    return prefix + (result.size() < 2 ? "0" : "") + result;
+  }
+
+  static void WriteCoordinate(const netcdf::Variable& variable,
+                              const double first, const double last,
+                              const size_t size, const std::string& units) {
+    std::valarray<float> values(size);
+    for (size_t ix = 0; ix < size; ++ix) {
+      values[ix] = static_cast<float>(
+          first + (last - first) * (ix + 0.5) / static_cast<double>(size));
+    }
+    variable.AddAttribute("units").WriteText(units);
+    variable.Write(netcdf::Hyperslab(), values);
+  }
+
+  // SplitMix64: a pseudo-random value depending only on its input
+  static uint64_t Mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  // Uniform value in [0, 1)
+  static double Uniform(const uint64_t x) {
+    return static_cast<double>(Mix(x) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  // Mean and amplitude of the field of a variable
+  static double Mean(const size_t variable) { return 250 + 10 * variable; }
+  static double Amplitude(const size_t variable) { return 20 + 5 * variable; }
+
+  // The packing covers the range of the field and of the noise
+  netcdf::Packing GetPacking(const size_t variable) const {
+    const double range = Amplitude(variable) * (1 + options_.noise);
+    return netcdf::Packing::Compute(Mean(variable) - range,
+                                    Mean(variable) + range, 16);
+  }
+
+  // Compute a record of a variable. The missing values are blocks of 8x8
+  // cells, the same for all the records.
+  void Fill(const size_t index, const size_t variable, const size_t time,
+            std::valarray<double>& values) const {
+    const uint64_t seed = Mix(options_.seed ^ Mix(index + 1));
+    const double mean = Mean(variable);
+    const double amplitude = Amplitude(variable);
+    const double phase = Uniform(seed) * 2 * kPi;
+    std::vector<double> lon(options_.columns);
+    for (size_t jx = 0; jx < options_.columns; ++jx) {
+      lon[jx] = std::cos(2 * kPi * jx / options_.columns + phase +
+                         0.1 * static_cast<double>(time));
+    }
+    const uint64_t noise_seed = Mix(seed ^ Mix(time + 1));
+    for (size_t ix = 0; ix < options_.rows; ++ix) {
+      const double lat = std::sin(kPi * (ix + 0.5) / options_.rows);
+      double* const row = &values[ix * options_.columns];
+      for (size_t jx = 0; jx < options_.columns; ++jx) {
+        const size_t cell = ix * options_.columns + jx;
+        const double noise = 2 * Uniform(noise_seed + cell) - 1;
+        row[jx] = mean + amplitude * (lat * lon[jx] + options_.noise * noise);
+        const uint64_t block = (ix / 8) * ((options_.columns + 7) / 8) + jx / 8;
+        if (Uniform(seed ^ Mix(block)) < options_.fill_ratio)
+          row[jx] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  }
+};
+
+}  // namespace benchmark
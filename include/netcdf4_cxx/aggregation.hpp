@@ -0,0 +1,180 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/hyperslab.hpp>
+#include <netcdf4_cxx/lru_cache.hpp>
+#include <netcdf4_cxx/selection.hpp>
+#include <netcdf4_cxx/variable.hpp>
+#include <string>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * How the files of an aggregation are joined, after the NcML aggregations
+ */
+enum class Aggregation {
+  //! The files are concatenated along the first dimension of the variable
+  kJoinExisting,
+  //! Each file holds one element of a new outer dimension
+  kJoinNew
+};
+
+/**
+ * A variable split over a list of files, read as a single variable. The
+ * files are sorted by name. Only the length of the aggregated dimension,
+ * and its coordinate, are read from each file up front; a read is split into
+ * one read per file, stored directly in the result.
+ *
+ * The files are kept open between reads, up to a maximum number of files:
+ * the least recently used file is closed to open a new one.
+ */
+class AggregatedVariable {
+ private:
+  //! A file of the aggregation
+  struct Member {
+    std::string path;  //!< Path to the file
+    size_t offset;     //!< Index of its first element in the aggregation
+    size_t length;     //!< Number of elements of the aggregated dimension
+  };
+
+  //! An open file and the variable read
+  struct Handle {
+    std::shared_ptr<File> file;          //!< File open
+    std::shared_ptr<Variable> variable;  //!< Variable read
+  };
+
+  //! Part of a read served by a file
+  struct Part {
+    size_t member;        //!< Index of the file
+    Hyperslab hyperslab;  //!< Values selected in the file
+    size_t offset;        //!< Position of the values in the result
+  };
+
+  std::string name_;
+  Aggregation aggregation_;
+  std::vector<Member> members_;
+  std::vector<size_t> shape_;
+  std::valarray<double> coordinate_;
+  mutable LruCache<size_t, Handle> handles_;
+
+  // Open a file of the aggregation, or get it from the open files
+  Handle Open(const size_t member) const;
+
+  // Split a read into reads of the files
+  std::vector<Part> Split(const Hyperslab& hyperslab) const;
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param paths files of the aggregation
+   * @param name name, or path such as /group/name, of the variable
+   * @param aggregation how the files are joined
+   * @param max_open_files maximum number of files kept open
+   * @throw std::invalid_argument if the variable is missing from a file
+   *  or its shape is not the same in all files
+   */
+  AggregatedVariable(std::vector<std::string> paths, const std::string& name,
+                     const Aggregation aggregation = Aggregation::kJoinExisting,
+                     const size_t max_open_files = 64);
+
+  /**
+   * Get the name of the variable
+   *
+   * @return the name, or path, given to the constructor
+   */
+  const std::string& name() const noexcept { return name_; }
+
+  /**
+   * Get the files of the aggregation
+   *
+   * @return the paths, sorted by name
+   */
+  std::vector<std::string> GetPaths() const {
+    std::vector<std::string> result;
+    for (auto& item : members_) result.push_back(item.path);
+    return result;
+  }
+
+  /**
+   * Get the shape of the aggregated variable
+   *
+   * @return the length of each dimension
+   */
+  const std::vector<size_t>& GetShape() const noexcept { return shape_; }
+
+  /**
+   * Get the rank of the aggregated variable
+   *
+   * @return the number of dimensions
+   */
+  size_t GetRank() const noexcept { return shape_.size(); }
+
+  /**
+   * Get the values of the aggregated dimension: the values of its
+   * coordinate variable if the files define one, otherwise the index of
+   * each element. For a kJoinNew aggregation, the index of the file.
+   *
+   * @return the coordinate values
+   */
+  const std::valarray<double>& GetCoordinate() const noexcept {
+    return coordinate_;
+  }
+
+  /**
+   * Get the number of files open
+   *
+   * @return the number of files
+   */
+  size_t GetOpenFiles() const noexcept { return handles_.size(); }
+
+  /**
+   * Read the data for this Variable
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> Read(const Hyperslab& hyperslab) const {
+    std::valarray<T> values(hyperslab.GetSize());
+    for (auto& item : Split(hyperslab.Forward())) {
+      Open(item.member).variable->Read(item.hyperslab, &values[item.offset]);
+    }
+    if (hyperslab.IsReversed() && values.size() != 0)
+      Reverse(hyperslab, &values[0], sizeof(T));
+    return values;
+  }
+
+  /**
+   * Read all the data for this Variable
+   *
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> Read() const {
+    return Read<T>(Hyperslab(shape_));
+  }
+};
+
+}  // namespace netcdf
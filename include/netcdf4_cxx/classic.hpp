@@ -0,0 +1,538 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <netcdf4_cxx/type.hpp>
+#include <stdexcept>
+#include <string>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+namespace classic {
+
+/**
+ * Version of the classic binary format
+ */
+enum class Version {
+  kClassic = 1,       //!< CDF-1, 32-bit offsets
+  k64BitOffset = 2,   //!< CDF-2, 64-bit offsets
+  k64BitData = 5      //!< CDF-5, 64-bit offsets and sizes
+};
+
+/**
+ * Get the size in bytes of a value stored in a classic file
+ *
+ * @param type type of the value
+ * @return the size in bytes
+ */
+size_t SizeOf(const type::Primitive type);
+
+/**
+ * Copy big-endian values into native values (or the reverse: the operation
+ * is its own inverse). The input and output buffers may be the same but
+ * must not overlap otherwise. The bytes are swapped by vector when the
+ * processor supports it, and copied as is on a big-endian host.
+ *
+ * @param in values to convert
+ * @param out converted values
+ * @param count number of values
+ * @param width size of a value in bytes: 1, 2, 4 or 8
+ */
+void ByteSwap(const void* in, void* out, const size_t count,
+              const size_t width);
+
+/**
+ * Dimension described in the header of a classic file
+ */
+struct DimensionInfo {
+  std::string name;  //!< Dimension name
+  uint64_t length;   //!< Dimension length, 0 for the record dimension
+};
+
+/**
+ * Attribute described in the header of a classic file
+ */
+struct AttributeInfo {
+  std::string name;      //!< Attribute name
+  type::Primitive type;  //!< Type of the values
+  uint64_t length;       //!< Number of values
+  std::string value;     //!< Values, big-endian, without padding
+
+  /**
+   * True if value is of type text.
+   *
+   * @return if it's a text or not
+   */
+  bool IsText() const noexcept { return type == type::Primitive::kChar; }
+
+  /**
+   * Retrieve text value; only call if IsText() is true.
+   *
+   * @return text read
+   */
+  const std::string& ReadText() const noexcept { return value; }
+
+  /**
+   * Read the value as an array.
+   *
+   * @return a new container on values read
+   */
+  template <typename T>
+  std::vector<T> Read() const {
+    if (sizeof(T) != SizeOf(type))
+      throw std::invalid_argument(
+          "the size of the NetCDF type does not "
+          "match the size of the given C++ type");
+    std::vector<T> values(length);
+    if (length != 0) ByteSwap(value.data(), values.data(), length, sizeof(T));
+    return values;
+  }
+};
+
+/**
+ * Variable described in the header of a classic file
+ */
+struct VariableInfo {
+  std::string name;                       //!< Variable name
+  type::Primitive type;                   //!< Type of the values
+  std::vector<uint64_t> dimensions;       //!< Dimension identifiers
+  std::vector<uint64_t> shape;            //!< Length of each dimension
+  std::vector<AttributeInfo> attributes;  //!< Variable attributes
+  uint64_t begin;                         //!< File offset of the values
+  bool record;                            //!< True for a record variable
+
+  /**
+   * Get the number of dimensions of the variable
+   *
+   * @return the rank
+   */
+  size_t GetRank() const noexcept { return shape.size(); }
+
+  /**
+   * Find an attribute of the variable by its name
+   *
+   * @param name attribute name
+   * @return the attribute or NULL if not found
+   */
+  const AttributeInfo* FindAttribute(const std::string& name) const noexcept {
+    for (auto& item : attributes) {
+      if (item.name == name) return &item;
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * Header of a file written in one of the classic binary formats (CDF-1,
+ * CDF-2 or CDF-5), decoded without the netCDF library.
+ */
+class Header {
+ private:
+  Version version_{Version::kClassic};
+  uint64_t records_{0};
+  uint64_t record_size_{0};
+  uint64_t size_{0};
+  std::vector<DimensionInfo> dimensions_;
+  std::vector<AttributeInfo> attributes_;
+  std::vector<VariableInfo> variables_;
+
+ public:
+  /**
+   * Create an empty header
+   */
+  Header() = default;
+
+  /**
+   * Decode a header
+   *
+   * @param data beginning of the file
+   * @param size number of bytes available
+   * @param file_size size of the file, used to compute the number of
+   *  records of a file being written in streaming mode
+   * @throw std::runtime_error if the header is invalid or truncated
+   */
+  Header(const void* data, const size_t size, const uint64_t file_size = 0);
+
+  /**
+   * Decode a header that may not be complete
+   *
+   * @param data beginning of the file
+   * @param size number of bytes available
+   * @param header decoded header
+   * @param file_size size of the file, used to compute the number of
+   *  records of a file being written in streaming mode
+   * @return the size of the header in bytes, or 0 if more bytes are
+   *  needed to decode it
+   * @throw std::runtime_error if the header is invalid
+   */
+  static size_t Parse(const void* data, const size_t size, Header& header,
+                      const uint64_t file_size = 0);
+
+  /**
+   * Read the header of a file without opening it with the netCDF library
+   * nor reading its values. The first bytes of the file are read at once,
+   * which is enough for most headers; larger headers are completed by
+   * further reads.
+   *
+   * @param path path to the file
+   * @param read_size number of bytes read first
+   * @return the header
+   * @throw std::runtime_error if the file cannot be read or is not a valid
+   *  classic file
+   */
+  static Header Scan(const std::string& path, size_t read_size = 16384);
+
+  /**
+   * Get the version of the binary format
+   *
+   * @return the version
+   */
+  Version version() const noexcept { return version_; }
+
+  /**
+   * Get the number of records
+   *
+   * @return the length of the record dimension
+   */
+  uint64_t records() const noexcept { return records_; }
+
+  /**
+   * Get the number of bytes between two consecutive records
+   *
+   * @return the record size in bytes
+   */
+  uint64_t record_size() const noexcept { return record_size_; }
+
+  /**
+   * Get the size of the header
+   *
+   * @return the size in bytes
+   */
+  uint64_t size() const noexcept { return size_; }
+
+  /**
+   * Get the dimensions, indexed by their identifier
+   *
+   * @return the dimensions
+   */
+  const std::vector<DimensionInfo>& dimensions() const noexcept {
+    return dimensions_;
+  }
+
+  /**
+   * Get the global attributes
+   *
+   * @return the attributes
+   */
+  const std::vector<AttributeInfo>& attributes() const noexcept {
+    return attributes_;
+  }
+
+  /**
+   * Get the variables, indexed by their identifier
+   *
+   * @return the variables
+   */
+  const std::vector<VariableInfo>& variables() const noexcept {
+    return variables_;
+  }
+
+  /**
+   * Find a variable by its name
+   *
+   * @param name variable name
+   * @return the variable or NULL if not found
+   */
+  const VariableInfo* FindVariable(const std::string& name) const noexcept {
+    for (auto& item : variables_) {
+      if (item.name == name) return &item;
+    }
+    return nullptr;
+  }
+
+  /**
+   * Find a global attribute by its name
+   *
+   * @param name attribute name
+   * @return the attribute or NULL if not found
+   */
+  const AttributeInfo* FindAttribute(const std::string& name) const noexcept {
+    for (auto& item : attributes_) {
+      if (item.name == name) return &item;
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * Read-only view over the big-endian values of a variable stored in memory
+ * as laid out in a classic file: a non-record variable is a single block of
+ * values, a record variable one block per record, separated by the record
+ * size. The values are converted to the native byte order on access.
+ *
+ * @tparam T type of the values
+ */
+template <typename T>
+class View {
+ private:
+  const unsigned char* data_;
+  size_t block_;
+  size_t blocks_;
+  size_t stride_;
+
+  // Copy the values [first, first + count[ of a block
+  void CopyBlock(const size_t block, const size_t first, const size_t count,
+                 T* out) const {
+    ByteSwap(data_ + block * stride_ + first * sizeof(T), out, count,
+             sizeof(T));
+  }
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param data first value of the first block
+   * @param block number of values per block
+   * @param blocks number of blocks
+   * @param stride number of bytes between two consecutive blocks
+   */
+  View(const unsigned char* data, const size_t block, const size_t blocks,
+       const size_t stride) noexcept
+      : data_(data), block_(block), blocks_(blocks), stride_(stride) {}
+
+  /**
+   * Get the number of values
+   *
+   * @return the number of values
+   */
+  size_t size() const noexcept { return block_ * blocks_; }
+
+  /**
+   * Get the number of values per block (per record for a record variable)
+   *
+   * @return the number of values
+   */
+  size_t block() const noexcept { return block_; }
+
+  /**
+   * Get the number of blocks (of records for a record variable)
+   *
+   * @return the number of blocks
+   */
+  size_t blocks() const noexcept { return blocks_; }
+
+  /**
+   * Get the number of bytes between two consecutive blocks
+   *
+   * @return the stride in bytes
+   */
+  size_t stride() const noexcept { return stride_; }
+
+  /**
+   * Test if the values are stored without gap
+   *
+   * @return true if the blocks are adjacent
+   */
+  bool contiguous() const noexcept {
+    return blocks_ <= 1 || stride_ == block_ * sizeof(T);
+  }
+
+  /**
+   * Get the big-endian values of a block, as stored in the file
+   *
+   * @param ix block index
+   * @return a pointer to the first byte of the block
+   */
+  const unsigned char* raw(const size_t ix = 0) const noexcept {
+    return data_ + ix * stride_;
+  }
+
+  /**
+   * Get a value
+   *
+   * @param ix index of the value
+   * @return the value in the native byte order
+   */
+  T operator[](const size_t ix) const noexcept {
+    const unsigned char* ptr =
+        data_ + (ix / block_) * stride_ + (ix % block_) * sizeof(T);
+    T result;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    memcpy(&result, ptr, sizeof(T));
+#else
+    unsigned char bytes[sizeof(T)];
+    for (size_t jx = 0; jx < sizeof(T); ++jx) {
+      bytes[jx] = ptr[sizeof(T) - 1 - jx];
+    }
+    memcpy(&result, bytes, sizeof(T));
+#endif
+    return result;
+  }
+
+  /**
+   * Copy values in the native byte order
+   *
+   * @param first index of the first value
+   * @param count number of values
+   * @param out buffer receiving the values
+   */
+  void CopyTo(size_t first, size_t count, T* out) const {
+    if (first + count > size())
+      throw std::out_of_range("the values requested are out of the view");
+    while (count != 0) {
+      size_t block = first / block_;
+      size_t offset = first % block_;
+      size_t n = std::min(count, block_ - offset);
+      CopyBlock(block, offset, n, out);
+      first += n;
+      count -= n;
+      out += n;
+    }
+  }
+
+  /**
+   * Copy all values in the native byte order
+   *
+   * @return the values
+   */
+  std::valarray<T> Read() const {
+    std::valarray<T> result(size());
+    if (result.size()) CopyTo(0, result.size(), &result[0]);
+    return result;
+  }
+};
+
+/**
+ * A file mapped read-only in memory
+ */
+class MappedFile {
+ private:
+  const unsigned char* data_{nullptr};
+  size_t size_{0};
+
+ public:
+  /**
+   * Map a file
+   *
+   * @param path path to the file
+   * @throw std::runtime_error if the file cannot be mapped
+   */
+  explicit MappedFile(const std::string& path);
+
+  /**
+   * Unmap the file
+   */
+  ~MappedFile() noexcept;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /**
+   * Move constructor
+   *
+   * @param rhs right value
+   */
+  MappedFile(MappedFile&& rhs) noexcept : data_(rhs.data_), size_(rhs.size_) {
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+  }
+
+  /**
+   * Get the content of the file
+   *
+   * @return a pointer to the first byte of the file
+   */
+  const unsigned char* data() const noexcept { return data_; }
+
+  /**
+   * Get the size of the file
+   *
+   * @return the size in bytes
+   */
+  size_t size() const noexcept { return size_; }
+};
+
+/**
+ * Reader of the files written in the classic binary formats, mapping the
+ * file in memory instead of copying the values through the netCDF library.
+ */
+class Reader {
+ private:
+  MappedFile file_;
+  Header header_;
+
+  // Get the variable and check that its values are of the type given
+  const VariableInfo& GetVariable(const std::string& name,
+                                  const type::Primitive type) const;
+
+  // Get the location of the values of a variable
+  void Locate(const VariableInfo& variable, size_t& block, size_t& blocks,
+              size_t& stride) const;
+
+ public:
+  /**
+   * Open a file
+   *
+   * @param path path to the file
+   * @throw std::runtime_error if the file is not a valid classic file
+   */
+  explicit Reader(const std::string& path);
+
+  /**
+   * Get the header of the file
+   *
+   * @return the header
+   */
+  const Header& header() const noexcept { return header_; }
+
+  /**
+   * Get a view over the values of a variable
+   *
+   * @tparam T type of the values, matching the type of the variable
+   * @param name variable name
+   * @return the view
+   * @throw std::invalid_argument if the variable does not exist or is not
+   *  of the type requested
+   */
+  template <typename T>
+  View<T> GetView(const std::string& name) const {
+    auto& variable = GetVariable(name, type::PrimitiveOf<T>::value);
+    size_t block, blocks, stride;
+    Locate(variable, block, blocks, stride);
+    return View<T>(file_.data() + variable.begin, block, blocks, stride);
+  }
+
+  /**
+   * Read the values of a variable
+   *
+   * @tparam T type of the values, matching the type of the variable
+   * @param name variable name
+   * @return the values in the native byte order
+   */
+  template <typename T>
+  std::valarray<T> Read(const std::string& name) const {
+    return GetView<T>(name).Read();
+  }
+};
+
+}  // namespace classic
+}  // namespace netcdf
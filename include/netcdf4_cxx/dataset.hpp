@@ -62,6 +62,41 @@ class DataSet : public AbstractDataSet {
    */
   std::list<Attribute> GetAttributes() const;
 
+  /**
+   * Get the number of attributes contained in this container.
+   *
+   * @return the number of attributes
+   */
+  int GetNumberOfAttributes() const {
+    int natts;
+    if (id_ == NC_GLOBAL) {
+      Check(nc_inq_natts(nc_id_, &natts));
+    } else {
+      Check(nc_inq_varnatts(nc_id_, id_, &natts));
+    }
+    return natts;
+  }
+
+  /**
+   * Visit the attributes contained in this container without building a
+   * list. The visitor is called as visitor(const Attribute&) and returns
+   * false to stop the iteration.
+   *
+   * @param visitor callable invoked on each attribute
+   * @return false if the visitor stopped the iteration, otherwise true
+   */
+  template <typename Visitor>
+  bool VisitAttributes(Visitor&& visitor) const {
+    int natts = GetNumberOfAttributes();
+    char name[NC_MAX_NAME + 1];
+
+    for (int ix = 0; ix < natts; ++ix) {
+      Check(nc_inq_attname(nc_id_, id_, ix, name));
+      if (!visitor(Attribute(*this, name))) return false;
+    }
+    return true;
+  }
+
   /**
    * Find an Attribute by its name
    *
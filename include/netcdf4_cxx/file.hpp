@@ -19,8 +19,10 @@
 #include <netcdf.h>
 #include <stddef.h>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <list>
+#include <memory>
 #include <netcdf4_cxx/attribute.hpp>
 #include <netcdf4_cxx/dataset.hpp>
 #include <netcdf4_cxx/group.hpp>
@@ -49,6 +51,48 @@ enum class Format {
   k64BitsNetCdf3 = NC_FORMAT_64BIT
 };
 
+/**
+ * Image of a netCDF file held in memory, as returned by File::CloseToBuffer.
+ * The buffer allocated by the netCDF library is taken over without copy and
+ * released when the image is destroyed.
+ */
+class MemoryImage {
+ private:
+  std::unique_ptr<unsigned char, void (*)(void*)> data_;
+  size_t size_;
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param data buffer allocated with malloc
+   * @param size size of the buffer in bytes
+   */
+  MemoryImage(void* data, const size_t size) noexcept
+      : data_(static_cast<unsigned char*>(data), free), size_(size) {}
+
+  /**
+   * Get the content of the file
+   *
+   * @return a pointer to the first byte of the file
+   */
+  const unsigned char* data() const noexcept { return data_.get(); }
+
+  /**
+   * Get the size of the file
+   *
+   * @return the size in bytes
+   */
+  size_t size() const noexcept { return size_; }
+
+  /**
+   * Test if the image is empty
+   *
+   * @return true if the image holds no data
+   */
+  bool empty() const noexcept { return size_ == 0; }
+};
+
 /**
  * A netCDF File is a collection of dimensions, groups, variables and
  * attributes. Together they describe the meaning of data and relations
@@ -105,6 +149,38 @@ class File : public Group {
             bool clobber = true, const bool diskless = false,
             const bool persist = false, const Format format = Format::kNetCdf4);
 
+  /**
+   * Open, in read-only mode, a netCDF file held in memory. The buffer is
+   * used as is, without copy: it must remain valid until the file is
+   * closed.
+   *
+   * @param data content of the netCDF file
+   * @param size size of the buffer in bytes
+   * @param name name given to the dataset, returned by GetFilePath
+   */
+  void OpenMemory(const void* data, const size_t size,
+                  const std::string& name = "memory");
+
+  /**
+   * Create a new netCDF file in memory, without any access to the file
+   * system. The file is retrieved with CloseToBuffer.
+   *
+   * @param format underlying file format
+   * @param initial_size initial size of the buffer in bytes, or 0 to let
+   *  the library choose it
+   * @param name name given to the dataset, returned by GetFilePath
+   */
+  void CreateInMemory(const Format format = Format::kNetCdf4,
+                      const size_t initial_size = 0,
+                      const std::string& name = "memory");
+
+  /**
+   * Close a file created by CreateInMemory and hand over its content.
+   *
+   * @return the image of the file in memory
+   */
+  MemoryImage CloseToBuffer();
+
   /**
    * Destructor
    */
@@ -0,0 +1,152 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/lru_cache.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * Pool of open files shared between the parts of a program reading the
+ * same files. Opening a netCDF-4 file reads its metadata, which costs far
+ * more than most reads: the pool keeps the files open, keyed by path and
+ * access mode, up to a maximum number of files. The least recently used
+ * file is released to open a new one; it is closed once the last handle
+ * on it is destroyed.
+ *
+ * A file open read-only is checked before being returned again: if its
+ * modification time, size or inode changed, for example because it was
+ * replaced, it is opened again.
+ *
+ * The pool can be used from several threads. The files are opened and
+ * closed outside of the lock of the pool: the threads opening the same file
+ * wait for the first one to open it, the other threads are not blocked.
+ */
+class FilePool {
+ private:
+  //! Identity of the content of a file on disk
+  struct Stamp {
+    int64_t mtime;   //!< Time of the last modification, in nanoseconds
+    int64_t size;    //!< Size in bytes
+    uint64_t inode;  //!< Inode number
+  };
+
+  //! A file held by the pool
+  struct Entry {
+    std::shared_ptr<File> file;  //!< File open
+    Stamp stamp;                 //!< Identity of the file when opened
+  };
+
+  //! Files released by the pool, closed once the lock is released
+  using Released = std::vector<std::shared_ptr<File>>;
+
+  mutable std::mutex mutex_;
+  LruCache<std::string, Entry> entries_;
+  //! Files being opened, by key
+  std::unordered_map<std::string, std::shared_future<std::shared_ptr<File>>>
+      pending_;
+
+  // Get the identity of a file, returns false if the file does not exist
+  static bool GetStamp(const std::string& path, Stamp& stamp);
+
+  // Release the least recently used files beyond the given number of files
+  void Shrink(const size_t size, Released& released);
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param capacity maximum number of files kept open
+   */
+  explicit FilePool(const size_t capacity = 128) : entries_(capacity) {}
+
+  /**
+   * Get the pool shared by the whole program
+   *
+   * @return the pool
+   */
+  static FilePool& Instance();
+
+  /**
+   * Get an open file
+   *
+   * @param path path to the file
+   * @param mode access mode: r, r+, a or one of the shared modes described
+   *  in File::Open. Files created with the w modes cannot be pooled.
+   * @return a handle on the file, shared with the other users of the pool
+   * @throw std::invalid_argument if the mode creates the file
+   * @throw std::runtime_error if the file cannot be opened, in all the
+   *  threads waiting for it
+   */
+  std::shared_ptr<File> Open(const std::string& path,
+                             const std::string& mode = "r");
+
+  /**
+   * Release a file held by the pool
+   *
+   * @param path path to the file
+   * @param mode access mode given to Open
+   * @return true if the file was held
+   */
+  bool Erase(const std::string& path, const std::string& mode = "r");
+
+  /**
+   * Release all the files held by the pool
+   */
+  void Clear();
+
+  /**
+   * Get the number of files held
+   *
+   * @return the number of files
+   */
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+  }
+
+  /**
+   * Get the maximum number of files held
+   *
+   * @return the capacity
+   */
+  size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.capacity();
+  }
+
+  /**
+   * Set the maximum number of files held, releasing the least recently
+   * used files if needed
+   *
+   * @param capacity the capacity
+   * @throw std::invalid_argument if the capacity is zero
+   */
+  void SetCapacity(const size_t capacity);
+};
+
+}  // namespace netcdf
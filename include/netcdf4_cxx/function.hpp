@@ -0,0 +1,104 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <netcdf4_cxx/type.hpp>
+#include <stdexcept>
+#include <string>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * A user-defined function callable from the expressions evaluated by Query.
+ *
+ * The function is vectorized: it receives a block of values for each
+ * argument, scalar arguments being broadcast to the size of the block, and
+ * returns the block of values computed. When an expression is evaluated tile
+ * by tile (see Query::EvaluateInto), the function is called once per tile,
+ * like the built-in functions.
+ */
+class Function {
+ public:
+  //! Signature of the callable implementing the function
+  using Callable = std::function<std::valarray<double>(
+      const std::vector<std::valarray<double>>&)>;
+
+  /**
+   * Default constructor
+   *
+   * @param arity number of arguments expected by the function
+   * @param callable the implementation of the function
+   * @param unit unit of the values returned by the function
+   * @param data_type type used to store the values returned by the function:
+   *  type::Primitive::kFloat or type::Primitive::kDouble.
+   */
+  Function(const size_t arity, const Callable& callable,
+           const std::string& unit = "",
+           const type::Primitive data_type = type::Primitive::kDouble)
+      : arity_(arity), callable_(callable), unit_(unit), data_type_(data_type) {
+    if (!callable_) throw std::invalid_argument("the callable is not defined");
+    if (data_type_ != type::Primitive::kFloat &&
+        data_type_ != type::Primitive::kDouble)
+      throw std::invalid_argument(
+          "the values returned by a function must be stored as float or "
+          "double");
+  }
+
+  /**
+   * Get the number of arguments expected by the function
+   *
+   * @return the number of arguments
+   */
+  size_t arity() const noexcept { return arity_; }
+
+  /**
+   * Get the unit of the values returned by the function
+   *
+   * @return the unit or an empty string if the unit is not known
+   */
+  const std::string& unit() const noexcept { return unit_; }
+
+  /**
+   * Get the type used to store the values returned by the function
+   *
+   * @return the data type
+   */
+  type::Primitive data_type() const noexcept { return data_type_; }
+
+  /**
+   * Call the function on a block of values
+   *
+   * @param args the values of each argument, all of the same size
+   * @return the values computed
+   */
+  std::valarray<double> operator()(
+      const std::vector<std::valarray<double>>& args) const {
+    return callable_(args);
+  }
+
+ private:
+  size_t arity_;
+  Callable callable_;
+  std::string unit_;
+  type::Primitive data_type_;
+};
+
+}  // namespace netcdf
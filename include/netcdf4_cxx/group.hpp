@@ -123,6 +123,26 @@ class GroupIteratorType : public std::iterator<std::forward_iterator_tag, T> {
   T* operator->() noexcept { return group_; }
 };
 
+/**
+ * Order in which a group tree is traversed
+ */
+enum class TraversalOrder {
+  kPreOrder,  //!< A group is visited before its nested groups
+  kPostOrder  //!< A group is visited after its nested groups
+};
+
+/**
+ * Action returned by a visitor to drive a group tree traversal
+ */
+enum class VisitAction {
+  kContinue,  //!< Continue the traversal
+  kPrune,     //!< Do not descend into the nested groups of the visited group
+  kStop       //!< Stop the traversal
+};
+
+class GroupTree;
+class GroupTreeIterator;
+
 /**
  * A Group is a logical collection of Variables. The Groups in a Dataset form a
  * hierarchical tree, like directories on a disk. A Group has a name and
@@ -130,6 +150,8 @@ class GroupIteratorType : public std::iterator<std::forward_iterator_tag, T> {
  * dataset, the root Group, whose name is the empty string.
  */
 class Group : public DataSet {
+  friend class GroupTreeIterator;
+
  private:
   /**
    * Create a new group from a Group ID
@@ -306,6 +328,16 @@ class Group : public DataSet {
     return std::shared_ptr<Variable>(nullptr);
   }
 
+  /**
+   * Find the Variable designated by a path such as /forecast/member03/t2m.
+   * An absolute path starts at the root group, a relative path at this
+   * group.
+   *
+   * @param path path to the variable
+   * @return the Variable, or null if not found
+   */
+  std::shared_ptr<Variable> FindVariableByPath(const std::string& path) const;
+
   /**
    * Find the Variable with the specified (short) name in this group or a parent
    * group.
@@ -323,6 +355,49 @@ class Group : public DataSet {
    */
   std::list<Group> Walk() const;
 
+  /**
+   * Get a lazy range over the groups nested in this group, at any depth.
+   * The groups are fetched from the library while iterating, so that the
+   * traversal can be stopped or pruned without listing the whole tree.
+   *
+   * @param order traversal order
+   * @return the range of nested groups (this group excluded)
+   */
+  GroupTree Tree(const TraversalOrder order = TraversalOrder::kPreOrder) const;
+
+  /**
+   * Visit the groups nested in this group, at any depth. The visitor is
+   * called as visitor(const Group&) and returns a VisitAction: kPrune skips
+   * the nested groups of the visited one (pre-order only), kStop ends the
+   * traversal.
+   *
+   * @param visitor callable invoked on each group
+   * @param order traversal order
+   * @return false if the visitor stopped the traversal, otherwise true
+   */
+  template <typename Visitor>
+  bool Visit(Visitor&& visitor,
+             const TraversalOrder order = TraversalOrder::kPreOrder) const;
+
+  /**
+   * Visit the variables contained directly in this group without building
+   * a list. The visitor is called as visitor(const Variable&) and returns
+   * false to stop the iteration.
+   *
+   * @param visitor callable invoked on each variable
+   * @return false if the visitor stopped the iteration, otherwise true
+   */
+  template <typename Visitor>
+  bool VisitVariables(Visitor&& visitor) const {
+    int num_variables;
+    Check(nc_inq_nvars(nc_id_, &num_variables));
+    // Within a group, variable IDs are numbered from 0 to nvars - 1
+    for (int var_id = 0; var_id < num_variables; ++var_id) {
+      if (!visitor(Variable(*this, var_id))) return false;
+    }
+    return true;
+  }
+
   /**
    * Get the root Group
    *
@@ -447,4 +522,166 @@ class Group : public DataSet {
       const std::string& path);
 };
 
+/**
+ * Forward iterator over the groups nested in a group. Only the identifiers
+ * of the groups on the path to the current position, and of their
+ * siblings not visited yet, are held in memory. Both buffers are reused
+ * from one level to the next, so that the traversal does not allocate once
+ * the deepest level has been reached.
+ */
+class GroupTreeIterator
+    : public std::iterator<std::forward_iterator_tag, const Group> {
+ private:
+  //! A level of the tree being traversed
+  struct Frame {
+    int nc_id;     //!< Group whose nested groups are listed
+    size_t first;  //!< Index of its first nested group in ids_
+    size_t count;  //!< Number of nested groups
+    size_t next;   //!< Next nested group to visit
+  };
+
+  std::vector<Frame> frames_;
+  std::vector<int> ids_;
+  TraversalOrder order_{TraversalOrder::kPreOrder};
+  Group current_;
+  bool prune_{false};
+
+  // Add a level containing the nested groups of the given group
+  void Push(const int nc_id);
+
+  // Remove the last level
+  void Pop() noexcept {
+    ids_.resize(frames_.back().first);
+    frames_.pop_back();
+  }
+
+  // Move to the next group to visit
+  void Next();
+
+ public:
+  /**
+   * Create an iterator past the end of the traversal
+   */
+  GroupTreeIterator() = default;
+
+  /**
+   * Create an iterator on the first group to visit
+   *
+   * @param root group whose nested groups are traversed
+   * @param order traversal order
+   */
+  GroupTreeIterator(const Group& root, const TraversalOrder order);
+
+  /**
+   * Do not descend into the nested groups of the current group. Only
+   * meaningful for a pre-order traversal: in post-order, the nested groups
+   * have already been visited.
+   */
+  void Prune() noexcept { prune_ = true; }
+
+  /**
+   * Get the depth of the current group relative to the traversed group
+   *
+   * @return 1 for a group nested directly in the traversed group
+   */
+  size_t depth() const noexcept { return frames_.size(); }
+
+  /**
+   * Move forward to the next group
+   *
+   * @return a reference to this instance
+   */
+  GroupTreeIterator& operator++();
+
+  /**
+   * Dereferences pointer to the handled instance
+   *
+   * @return a reference to the current group
+   */
+  const Group& operator*() const noexcept { return current_; }
+
+  /**
+   * Pointer to member instance
+   *
+   * @return a pointer to the current group
+   */
+  const Group* operator->() const noexcept { return &current_; }
+
+  /**
+   * Test whether two iterators are equal
+   *
+   * @param other Iterator to compare
+   * @return true if the two iterators are the same
+   */
+  bool operator==(const GroupTreeIterator& other) const noexcept {
+    if (frames_.empty() || other.frames_.empty())
+      return frames_.empty() && other.frames_.empty();
+    return current_.nc_id() == other.current_.nc_id() &&
+           frames_.size() == other.frames_.size();
+  }
+
+  /**
+   * Test whether two iterators are different
+   *
+   * @param other Iterator to compare
+   * @return true if the two iterators are different
+   */
+  bool operator!=(const GroupTreeIterator& other) const noexcept {
+    return !(*this == other);
+  }
+};
+
+/**
+ * Range of the groups nested in a group, returned by Group::Tree
+ */
+class GroupTree {
+ private:
+  Group root_;
+  TraversalOrder order_;
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param root group whose nested groups are traversed
+   * @param order traversal order
+   */
+  GroupTree(const Group& root, const TraversalOrder order) noexcept
+      : root_(root), order_(order) {}
+
+  /**
+   * Return an iterator to the beginning
+   *
+   * @return an iterator
+   */
+  GroupTreeIterator begin() const { return GroupTreeIterator(root_, order_); }
+
+  /**
+   * Return an iterator to the end
+   *
+   * @return an iterator
+   */
+  GroupTreeIterator end() const { return GroupTreeIterator(); }
+};
+
+inline GroupTree Group::Tree(const TraversalOrder order) const {
+  return GroupTree(*this, order);
+}
+
+template <typename Visitor>
+bool Group::Visit(Visitor&& visitor, const TraversalOrder order) const {
+  for (GroupTreeIterator it(*this, order), end; it != end; ++it) {
+    switch (visitor(*it)) {
+      case VisitAction::kStop:
+        return false;
+      case VisitAction::kPrune:
+        it.Prune();
+        break;
+      case VisitAction::kContinue:
+        break;
+    }
+  }
+  return true;
+}
+
 }  // namespace netcdf
@@ -70,10 +70,15 @@ class Range {
    * @param start first value of the interval
    * @param end end of interval
    * @param step spacing between values
+   *
+   * @note With a negative step, end is compared as a signed value: the
+   * values down to zero are selected with end = static_cast<size_t>(-1).
    */
   Range(const size_t start, const size_t end, const ptrdiff_t step) noexcept {
     // Converts an invalid definition in an empty range
-    if (start > end and step > 0) {
+    if ((start > end and step > 0) or
+        (static_cast<ptrdiff_t>(start) <= static_cast<ptrdiff_t>(end) and
+         step < 0)) {
       *this = Range();
     } else {
       start_ = start;
@@ -143,7 +148,8 @@ class Range {
    * @return the last of the interval
    */
   constexpr size_t Last() const noexcept {
-    return IsEmpty() ? 0 : end_ + (end_ > start_ ? -1 : 1);
+    // The end of a reversed range may be static_cast<size_t>(-1)
+    return IsEmpty() ? 0 : (step_ > 0 ? end_ - 1 : end_ + 1);
   }
 
   /**
@@ -159,6 +165,33 @@ class Range {
                       : static_cast<ptrdiff_t>(item - start_) % step_ == 0;
   }
 
+  /**
+   * Check if the values are generated in decreasing order
+   *
+   * @return true if step() < 0
+   */
+  constexpr bool IsReversed() const noexcept { return step_ < 0; }
+
+  /**
+   * Get the Range generating the same values in the reverse order. For
+   * example, Range(0, n).Reversed() selects the n first values from the
+   * last to the first.
+   *
+   * @return the Range, with the opposite step
+   */
+  Range Reversed() const {
+    const size_t size = GetSize();
+    if (size == 0) return Range();
+    return Range((*this)[size - 1], start_ - (step_ > 0 ? 1 : -1), -step_);
+  }
+
+  /**
+   * Get the Range generating the same values in increasing order
+   *
+   * @return the Range, with a positive step
+   */
+  Range Forward() const { return step_ > 0 ? *this : Reversed(); }
+
   /**
    * Get the start of Range
    *
@@ -258,7 +291,7 @@ class Hyperslab {
       throw std::invalid_argument("start and step are not aligned");
     }
     for (auto& item : step) {
-      if (item < 1) throw std::invalid_argument("stride must be > 0");
+      if (item == 0) throw std::invalid_argument("stride must be != 0");
     }
   }
 
@@ -366,9 +399,34 @@ class Hyperslab {
    * @return true if the Hyperslab select adjacent values
    */
   bool OnlyAdjacent() const {
-    if (step_.empty()) return true;
-    return std::accumulate(step_.begin(), step_.end(), 1,
-                           std::multiplies<ptrdiff_t>()) == 1;
+    return std::all_of(step_.begin(), step_.end(),
+                       [](const ptrdiff_t item) { return item == 1; });
+  }
+
+  /**
+   * Check if the values of a dimension at least are selected in decreasing
+   * order
+   *
+   * @return true if a step is negative
+   */
+  bool IsReversed() const {
+    return std::any_of(step_.begin(), step_.end(),
+                       [](const ptrdiff_t item) { return item < 0; });
+  }
+
+  /**
+   * Get the Hyperslab selecting the same values in increasing order along
+   * each dimension
+   *
+   * @return the Hyperslab, with positive steps
+   */
+  Hyperslab Forward() const {
+    if (!IsReversed()) return *this;
+    std::vector<Range> ranges;
+    for (size_t ix = 0; ix < GetRank(); ++ix) {
+      ranges.push_back(GetRange(ix).Forward());
+    }
+    return Hyperslab(ranges);
   }
 
   /**
@@ -0,0 +1,173 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+namespace netcdf {
+
+/**
+ * Cache holding a bounded number of values. When the cache is full, the
+ * least recently used value is discarded to make room for a new one.
+ *
+ * @tparam Key type of the keys
+ * @tparam Value type of the values
+ * @tparam Hash hash function of the keys
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+ private:
+  using Item = std::pair<Key, Value>;
+  using ItemIterator = typename std::list<Item>::iterator;
+
+  //! Items, from the most to the least recently used
+  std::list<Item> items_;
+  //! Position of the items by key
+  std::unordered_map<Key, ItemIterator, Hash> index_;
+  //! Maximum number of items
+  size_t capacity_;
+
+  // Discard the least recently used items beyond the capacity
+  void Shrink() {
+    while (items_.size() > capacity_) {
+      index_.erase(items_.back().first);
+      items_.pop_back();
+    }
+  }
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param capacity maximum number of values held
+   */
+  explicit LruCache(const size_t capacity) : capacity_(capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("the capacity of the cache must be > 0");
+  }
+
+  /**
+   * Get the number of values held
+   *
+   * @return the number of values
+   */
+  size_t size() const noexcept { return items_.size(); }
+
+  /**
+   * Test if the cache is empty
+   *
+   * @return true if the cache holds no value
+   */
+  bool empty() const noexcept { return items_.empty(); }
+
+  /**
+   * Get the maximum number of values held
+   *
+   * @return the capacity
+   */
+  size_t capacity() const noexcept { return capacity_; }
+
+  /**
+   * Set the maximum number of values held, discarding the least recently
+   * used values if needed
+   *
+   * @param capacity the capacity
+   */
+  void SetCapacity(const size_t capacity) {
+    if (capacity == 0)
+      throw std::invalid_argument("the capacity of the cache must be > 0");
+    capacity_ = capacity;
+    Shrink();
+  }
+
+  /**
+   * Find a value and mark it as the most recently used
+   *
+   * @param key key of the value
+   * @return a pointer to the value or NULL if not found
+   */
+  Value* Find(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    items_.splice(items_.begin(), items_, it->second);
+    return &it->second->second;
+  }
+
+  /**
+   * Insert or replace a value and mark it as the most recently used
+   *
+   * @param key key of the value
+   * @param value value to insert
+   * @return a reference to the value stored
+   */
+  Value& Insert(const Key& key, Value value) {
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      it->second->second = std::move(value);
+      items_.splice(items_.begin(), items_, it->second);
+      return items_.front().second;
+    }
+    items_.emplace_front(key, std::move(value));
+    index_.emplace(key, items_.begin());
+    Shrink();
+    return items_.front().second;
+  }
+
+  /**
+   * Remove a value
+   *
+   * @param key key of the value
+   * @return true if the value was found and removed
+   */
+  bool Erase(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) return false;
+    items_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  /**
+   * Remove the least recently used value
+   *
+   * @param value the value removed
+   * @return false if the cache is empty
+   */
+  bool Evict(Value& value) {
+    if (items_.empty()) return false;
+    value = std::move(items_.back().second);
+    index_.erase(items_.back().first);
+    items_.pop_back();
+    return true;
+  }
+
+  /**
+   * Remove all values
+   */
+  void Clear() {
+    index_.clear();
+    items_.clear();
+  }
+};
+
+}  // namespace netcdf
@@ -0,0 +1,113 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+#include <netcdf4_cxx/classic.hpp>
+#include <netcdf4_cxx/hyperslab.hpp>
+#include <netcdf4_cxx/variable.hpp>
+#include <stdexcept>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * Read access to a variable of a netCDF-4 file served from a memory mapping
+ * of the file, when the variable is stored contiguously, without filter, in
+ * the native byte order. The values are then copied from the page cache
+ * without going through the HDF5 library and its chunk cache. The other
+ * variables are read with the netCDF library.
+ *
+ * The storage of the variable is located with the HDF5 library: without it,
+ * or if the file is open for writing or held in memory, the variable is
+ * never mapped.
+ */
+class MappedVariable {
+ private:
+  Variable variable_;
+  std::shared_ptr<classic::MappedFile> file_;
+  const unsigned char* data_{nullptr};
+  size_t element_size_{0};
+  std::vector<size_t> shape_;
+
+  // Copy the values selected from the mapping
+  void Copy(const Hyperslab& hyperslab, void* out) const;
+
+ public:
+  /**
+   * Default constructor
+   *
+   * @param variable variable to read
+   */
+  explicit MappedVariable(const Variable& variable);
+
+  /**
+   * Test if the values are served from the memory mapping
+   *
+   * @return true if the variable is mapped
+   */
+  bool IsMapped() const noexcept { return data_ != nullptr; }
+
+  /**
+   * Get the values of the variable as stored in the file. They are in the
+   * native byte order but may not be aligned on the size of their type.
+   *
+   * @return a pointer to the first value or NULL if the variable is not
+   *  mapped
+   */
+  const void* data() const noexcept { return data_; }
+
+  /**
+   * Get the variable read
+   *
+   * @return the variable
+   */
+  const Variable& variable() const noexcept { return variable_; }
+
+  /**
+   * Read the data for this Variable
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> Read(const Hyperslab& hyperslab) const {
+    if (!IsMapped()) return variable_.Read<T>(hyperslab);
+    if (sizeof(T) != element_size_)
+      throw std::invalid_argument(
+          "the size of the NetCDF type does not "
+          "match the size of the given C++ type");
+
+    std::valarray<T> values(hyperslab.GetSize());
+    if (values.size() != 0) Copy(hyperslab, &values[0]);
+    return values;
+  }
+
+  /**
+   * Read all the data for this Variable
+   *
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> Read() const {
+    return Read<T>(Hyperslab(shape_));
+  }
+};
+
+}  // namespace netcdf
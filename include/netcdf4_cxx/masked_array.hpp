@@ -0,0 +1,152 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netcdf4_cxx/scale_missing.hpp>
+#include <stdexcept>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * Values read in their storage type with the description of the missing
+ * values.
+ *
+ * The validity of the values is stored in a bitmap using the layout of Apache
+ * Arrow: bit i % 8 of byte i / 8 is set if the value i is valid. Optionally,
+ * the reason why each value is missing is stored as a MaskReason code, one
+ * byte per value. The values are not unpacked: use the ScaleMissing
+ * description of the variable to apply the scale factor and the offset.
+ */
+template <typename T>
+class MaskedArray {
+ public:
+  /**
+   * Default constructor
+   */
+  MaskedArray() noexcept : values_(), validity_(), reasons_(), missing_(0) {}
+
+  /**
+   * Compute the validity of values
+   *
+   * @param values values read in their storage type
+   * @param scale_missing description of the missing values
+   * @param reasons true to store the reason why each value is missing
+   */
+  MaskedArray(std::valarray<T>&& values, const ScaleMissing& scale_missing,
+              const bool reasons = false)
+      : values_(std::move(values)),
+        validity_((values_.size() + 7) / 8),
+        reasons_(reasons ? values_.size() : 0),
+        missing_(0) {
+    if (values_.size() != 0)
+      missing_ = scale_missing.ComputeValidity(
+          &values_[0], values_.size(), validity_.data(),
+          reasons ? reasons_.data() : nullptr);
+  }
+
+  /**
+   * Get the number of values
+   *
+   * @return the number of values
+   */
+  size_t size() const noexcept { return values_.size(); }
+
+  /**
+   * Get the number of missing values
+   *
+   * @return the number of missing values
+   */
+  size_t GetNullCount() const noexcept { return missing_; }
+
+  /**
+   * Get the values, in their storage type
+   *
+   * @return the values
+   */
+  const std::valarray<T>& values() const noexcept { return values_; }
+
+  /**
+   * Get the validity bitmap
+   *
+   * @return the validity bitmap
+   */
+  const std::vector<uint8_t>& validity() const noexcept { return validity_; }
+
+  /**
+   * Test if the reasons why the values are missing are stored
+   *
+   * @return true if the reasons are stored
+   */
+  bool HasReasons() const noexcept {
+    return !reasons_.empty();
+  }
+
+  /**
+   * Test if a value is valid
+   *
+   * @param index index of the value
+   * @return true if the value is valid
+   */
+  bool IsValid(const size_t index) const {
+    if (index >= values_.size())
+      throw std::out_of_range("index must be < size()");
+    return (validity_[index >> 3] >> (index & 7)) & 1;
+  }
+
+  /**
+   * Get the reason why a value is missing
+   *
+   * @param index index of the value
+   * @return the reason
+   * @throw std::logic_error if the reasons are not stored
+   */
+  MaskReason GetReason(const size_t index) const {
+    if (index >= values_.size())
+      throw std::out_of_range("index must be < size()");
+    if (reasons_.empty())
+      throw std::logic_error(
+          "the reasons of the missing values are not stored");
+    return static_cast<MaskReason>(reasons_[index]);
+  }
+
+  /**
+   * Get the values, the missing values being replaced by a value
+   *
+   * @param value the value that represents the "missing" value
+   * @return the values
+   */
+  std::valarray<T> Filled(const T& value) const {
+    std::valarray<T> result(values_);
+    for (size_t ix = 0; ix < result.size(); ++ix) {
+      const bool valid = (validity_[ix >> 3] >> (ix & 7)) & 1;
+      result[ix] = valid ? result[ix] : value;
+    }
+    return result;
+  }
+
+ private:
+  std::valarray<T> values_;
+  std::vector<uint8_t> validity_;
+  std::vector<uint8_t> reasons_;
+  size_t missing_;
+};
+
+}  // namespace netcdf
@@ -0,0 +1,152 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <limits>
+#include <netcdf4_cxx/scale_missing.hpp>
+#include <stdexcept>
+#include <valarray>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * Values read in their storage type, unpacked on demand.
+ *
+ * The array holds the packed values and the description of the packing and
+ * of the missing values of the variable read. The values are masked and
+ * deflated only when they are accessed, one by one or block by block, which
+ * avoids unpacking the values not used. If the destination of the values
+ * uses the same packing, the packed values are written as is.
+ *
+ * @tparam T storage type of the values
+ */
+template <typename T>
+class PackedArray {
+ public:
+  /**
+   * Create a new instance
+   *
+   * @param values values read in their storage type
+   * @param scale_missing description of the packing and of the missing
+   * values
+   */
+  PackedArray(std::valarray<T>&& values, const ScaleMissing& scale_missing)
+      : values_(std::move(values)), scale_missing_(scale_missing) {}
+
+  /**
+   * Get the number of values
+   *
+   * @return the number of values
+   */
+  size_t size() const noexcept { return values_.size(); }
+
+  /**
+   * Get the packed values
+   *
+   * @return the values in their storage type
+   */
+  const std::valarray<T>& raw() const noexcept { return values_; }
+
+  /**
+   * Get the description of the packing and of the missing values
+   *
+   * @return the description of the packing and of the missing values
+   */
+  const ScaleMissing& scale_missing() const noexcept { return scale_missing_; }
+
+  /**
+   * Unpack a value
+   *
+   * @param index index of the value
+   * @param missing_value the value that represents the "missing" value
+   * @return the value unpacked
+   */
+  template <typename U>
+  U Get(const size_t index,
+        const U missing_value = std::numeric_limits<U>::quiet_NaN()) const {
+    if (index >= values_.size())
+      throw std::out_of_range("index must be < size()");
+    U result;
+    scale_missing_.MaskAndDeflate(&values_[index], 1, &result, missing_value);
+    return result;
+  }
+
+  /**
+   * Unpack a block of values
+   *
+   * @param first index of the first value to unpack
+   * @param count number of values to unpack
+   * @param output buffer receiving the values unpacked
+   * @param missing_value the value that represents the "missing" value
+   */
+  template <typename U>
+  void Unpack(const size_t first, const size_t count, U* const output,
+              const U missing_value =
+                  std::numeric_limits<U>::quiet_NaN()) const {
+    if (first > values_.size() || count > values_.size() - first)
+      throw std::out_of_range("block must be within [0, size())");
+    if (count != 0)
+      scale_missing_.MaskAndDeflate(&values_[first], count, output,
+                                    missing_value);
+  }
+
+  /**
+   * Unpack all values
+   *
+   * @param missing_value the value that represents the "missing" value
+   * @return the values unpacked
+   */
+  template <typename U>
+  std::valarray<U> Unpack(
+      const U missing_value = std::numeric_limits<U>::quiet_NaN()) const {
+    std::valarray<U> result(values_.size());
+    if (result.size() != 0) Unpack(0, result.size(), &result[0], missing_value);
+    return result;
+  }
+
+  /**
+   * Unpack the values block by block. The callback receives the index of the
+   * first value of the block, the values unpacked and their number. The
+   * buffer holding the values is reused from one block to the next.
+   *
+   * @param block_size maximum number of values unpacked at once
+   * @param callback function called for each block
+   * @param missing_value the value that represents the "missing" value
+   */
+  template <typename U, typename Callback>
+  void ForEachBlock(const size_t block_size, Callback&& callback,
+                    const U missing_value =
+                        std::numeric_limits<U>::quiet_NaN()) const {
+    if (block_size == 0)
+      throw std::invalid_argument("block size must be > 0");
+    std::vector<U> buffer(std::min(block_size, values_.size()));
+    for (size_t ix = 0; ix < values_.size(); ix += block_size) {
+      const size_t count = std::min(block_size, values_.size() - ix);
+      Unpack(ix, count, buffer.data(), missing_value);
+      callback(ix, static_cast<const U*>(buffer.data()), count);
+    }
+  }
+
+ private:
+  std::valarray<T> values_;
+  ScaleMissing scale_missing_;
+};
+
+}  // namespace netcdf
@@ -0,0 +1,171 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace netcdf {
+
+/**
+ * @brief Parameters packing floating point values into signed integers
+ *
+ * The parameters are the values of the attributes defined by the CF
+ * conventions: the values are packed with (x - add_offset) / scale_factor
+ * and unpacked with x * scale_factor + add_offset. The smallest integer of
+ * the packed type is reserved for the missing values.
+ */
+class Packing {
+ private:
+  double scale_factor_;
+  double add_offset_;
+  double max_error_;
+
+ public:
+  /**
+   * @brief Create a new instance
+   *
+   * @param scale_factor value of the scale_factor attribute
+   * @param add_offset value of the add_offset attribute
+   * @param max_error maximum absolute error of the values unpacked
+   */
+  Packing(const double scale_factor, const double add_offset,
+          const double max_error) noexcept
+      : scale_factor_(scale_factor),
+        add_offset_(add_offset),
+        max_error_(max_error) {}
+
+  /**
+   * @brief Compute the parameters packing values into signed integers
+   *
+   * If a precision is given, the values are packed with that precision
+   * around the middle of the range. Otherwise, the range of the values is
+   * spread over all the integers available.
+   *
+   * @param min minimum value to pack
+   * @param max maximum value to pack
+   * @param bits number of bits of the packed integers
+   * @param precision maximum absolute error allowed, or zero to use the best
+   * precision available
+   * @return the parameters computed
+   * @throw std::invalid_argument if the precision requested can not be
+   * reached with the number of bits given
+   */
+  static Packing Compute(const double min, const double max, const int bits,
+                         const double precision = 0);
+
+  /**
+   * @brief Get the range of finite values
+   *
+   * NaN and infinite values are ignored. Values of type float and double are
+   * processed by SIMD kernels selected at runtime.
+   *
+   * @param values values to process
+   * @param size number of values
+   * @param min minimum value found
+   * @param max maximum value found
+   * @return false if there are no finite values
+   */
+  template <typename T>
+  static bool MinMax(const T* const values, const size_t size, double& min,
+                     double& max) {
+    return MinMaxScalar(values, size, min, max);
+  }
+
+  /**
+   * @brief Value of the scale_factor attribute
+   *
+   * @return the scale factor
+   */
+  inline constexpr double get_scale_factor() const noexcept {
+    return scale_factor_;
+  }
+
+  /**
+   * @brief Value of the add_offset attribute
+   *
+   * @return the offset
+   */
+  inline constexpr double get_add_offset() const noexcept {
+    return add_offset_;
+  }
+
+  /**
+   * @brief Maximum absolute error of the values unpacked
+   *
+   * @return the maximum error
+   */
+  inline constexpr double get_max_error() const noexcept { return max_error_; }
+
+  /**
+   * @brief Pack values
+   *
+   * NaN values are replaced by the fill value, the values outside the range
+   * of the packed type are clipped.
+   *
+   * @param input values to pack
+   * @param size number of values
+   * @param output values packed
+   * @param fill_value value representing the missing values
+   */
+  template <typename T, typename R>
+  void Pack(const T* const input, const size_t size, R* const output,
+            const R fill_value = std::numeric_limits<R>::min()) const {
+    static_assert(std::is_integral<R>::value && std::is_signed<R>::value,
+                  "values can only be packed into signed integers");
+    const double lower = std::numeric_limits<R>::min() + 1.0;
+    const double upper = std::numeric_limits<R>::max();
+    const double inverse = 1 / scale_factor_;
+    for (size_t ix = 0; ix < size; ++ix) {
+      const double x = static_cast<double>(input[ix]);
+      const double y = std::nearbyint(
+          std::min(std::max((x - add_offset_) * inverse, lower), upper));
+      output[ix] = x != x ? fill_value : static_cast<R>(y);
+    }
+  }
+
+ private:
+  // Compute the range value by value
+  template <typename T>
+  static bool MinMaxScalar(const T* const values, const size_t size,
+                           double& min, double& max) {
+    min = std::numeric_limits<double>::infinity();
+    max = -std::numeric_limits<double>::infinity();
+    for (size_t ix = 0; ix < size; ++ix) {
+      const double x = static_cast<double>(values[ix]);
+      if (std::isfinite(x)) {
+        min = std::min(min, x);
+        max = std::max(max, x);
+      }
+    }
+    return min <= max;
+  }
+};
+
+// SIMD implementations
+template <>
+bool Packing::MinMax(const float* const values, const size_t size,
+                     double& min, double& max);
+
+template <>
+bool Packing::MinMax(const double* const values, const size_t size,
+                     double& min, double& max);
+
+}  // namespace netcdf
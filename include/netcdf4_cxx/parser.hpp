@@ -1,10 +1,14 @@
 #pragma once
+#include <chrono>
 #include <functional>
 #include <iostream>
+#include <list>
 #include <map>
 #include <sstream>
 #include <string>
 #include "any.hpp"
+#include "function.hpp"
+#include "profile.hpp"
 #include "query.hpp"
 
 namespace netcdf {
@@ -99,6 +103,14 @@ class TokenStream {
    * @return the valid token found
    */
   const Kind& Get();
+
+  /**
+   * Get the reference to a NetCDF variable following the '{' token: the
+   * characters up to the closing '}', without the surrounding spaces.
+   *
+   * @return the reference read
+   */
+  std::string GetReference();
 };
 
 /**
@@ -125,7 +137,8 @@ enum class IdentifierType {
   kConstant,      //!< kConstant
   kUnary,         //!< kUnary
   kBinary,        //!< kBinary
-  kTernary        //!< kTernary
+  kTernary,       //!< kTernary
+  kUserDefined    //!< kUserDefined
 };
 
 /**
@@ -164,7 +177,7 @@ enum class IdentifierType {
  *      Term % Primary
  *  Primary:
  *      Number
- *      ${Name}
+ *      ${Reference}
  *      Name
  *      Name = Or
  *      ( Or )
@@ -174,6 +187,11 @@ enum class IdentifierType {
  *      floating-point-literal
  *  Name:
  *      [a-zA-Z][a-zA-Z_0-9]*
+ *  Reference:
+ *      Path
+ *      Name:Path
+ *  Path:
+ *      [/]Name[/Name]*
  * @endverbatim
  */
 class LiteralExpression {
@@ -184,7 +202,11 @@ class LiteralExpression {
    * @param string string to parse
    */
   LiteralExpression(const QueryProxy& query, const std::string& string)
-      : query_(query), stream_(string), variable_() {}
+      : query_(query),
+        stream_(string),
+        variable_(),
+        origin_(nullptr),
+        profiler_(query.profiler()) {}
 
   /**
    * Evaluate the expression
@@ -205,15 +227,69 @@ class LiteralExpression {
     return result;
   }
 
+  /**
+   * Get the references to the NetCDF variables used by an expression
+   *
+   * @param string string to parse
+   * @return the list of references, in order of first appearance
+   */
+  static std::list<std::string> GetVariables(const std::string& string);
+
+  /**
+   * Get the unit of the result of the last evaluation
+   *
+   * The unit is known only if the result is returned directly by a
+   * user-defined function.
+   *
+   * @return the unit or an empty string if the unit is not known
+   */
+  std::string GetUnit() const {
+    return origin_ != nullptr ? origin_->unit() : std::string();
+  }
+
+  /**
+   * Get the type used to store the result of the last evaluation
+   *
+   * @return the data type declared by the user-defined function returning
+   *  the result, otherwise type::Primitive::kDouble
+   */
+  type::Primitive GetDataType() const {
+    return origin_ != nullptr ? origin_->data_type()
+                              : type::Primitive::kDouble;
+  }
+
+  /**
+   * Register a user-defined function
+   *
+   * @param name name of the function
+   * @param function the function to register
+   * @throw std::invalid_argument if the name is not a valid identifier or
+   *  is used by a built-in function or constant
+   */
+  static void Register(const std::string& name, const Function& function);
+
+  /**
+   * Remove a user-defined function
+   *
+   * @param name name of the function
+   * @return true if the function was registered
+   */
+  static bool Unregister(const std::string& name) {
+    return function_.erase(name) != 0;
+  }
+
  private:
   const QueryProxy& query_;
   TokenStream stream_;
   std::map<std::string, Any> variable_;
+  const Function* origin_;
+  profile::Profiler* profiler_;
 
   static std::map<std::string, double> constant_;
   static std::map<std::string, std::function<Any(Any)>> unary_;
   static std::map<std::string, std::function<Any(Any, Any)>> binary_;
   static std::map<std::string, std::function<Any(Any, Any, Any)>> ternary_;
+  static std::map<std::string, Function> function_;
 
   // Store the content of a variable
   void SetValue(const std::string& name, const Any& value) {
@@ -230,6 +306,8 @@ class LiteralExpression {
       return IdentifierType::kTernary;
     else if (constant_.count(identifier) != 0)
       return IdentifierType::kConstant;
+    else if (function_.count(identifier) != 0)
+      return IdentifierType::kUserDefined;
     return IdentifierType::kNotAFunction;
   }
 
@@ -239,6 +317,9 @@ class LiteralExpression {
   // Call a function
   Any Call(const std::string& identifier, const IdentifierType identifier_type);
 
+  // Call a user-defined function
+  Any CallFunction(const std::string& identifier);
+
   // Get the value of a variable
   Any& GetValue(const std::string& name) {
     auto it = variable_.find(name);
@@ -255,6 +336,42 @@ class LiteralExpression {
   // Handle binary operators +, -, %, *, /
   Any& BinaryOperator(const Kind kind, Any&& left, Any&& right);
 
+  // Get the number of elements stored in a value
+  static size_t GetSize(const Any& value) {
+    if (value.IsEmpty() || value.IsTyped(typeid(double))) return 1;
+    return value.Cast<std::valarray<double>>().size();
+  }
+
+  // Get the number of bytes allocated to store a value
+  static size_t GetAllocatedSize(const Any& value) {
+    if (value.IsEmpty() || value.IsTyped(typeid(double))) return 0;
+    return value.Cast<std::valarray<double>>().size() * sizeof(double);
+  }
+
+  // Apply an operator to the last "arity" operands evaluated. If the
+  // evaluation is profiled, the operator becomes the parent of the nodes
+  // of its operands.
+  template <typename Operator>
+  Any Apply(const std::string& name, const size_t arity, Operator&& op) {
+    if (profiler_ == nullptr) return op();
+    const auto start = profile::Profiler::Clock::now();
+    Any result = op();
+    profiler_->Reduce(
+        name, arity,
+        std::chrono::duration<double>(profile::Profiler::Clock::now() - start)
+            .count(),
+        GetSize(result), GetAllocatedSize(result));
+    return result;
+  }
+
+  // Record a value obtained without computation
+  Any Leaf(const std::string& name, Any value, const bool copied = false) {
+    if (profiler_ != nullptr)
+      profiler_->Reduce(name, 0, 0, GetSize(value),
+                        copied ? GetAllocatedSize(value) : 0);
+    return value;
+  }
+
   // Load a NetCDF variable
   Any LoadVariable();
 
@@ -0,0 +1,276 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <chrono>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace netcdf {
+namespace profile {
+
+/**
+ * A node of the evaluation tree of a query, with the resources consumed to
+ * compute it. The wall time, the bytes read and the allocations include
+ * those of the child nodes.
+ */
+class Node {
+ public:
+  /**
+   * Default constructor
+   *
+   * @param name name of the node
+   */
+  explicit Node(const std::string& name)
+      : name_(name),
+        wall_time_(0),
+        elements_(0),
+        bytes_read_(0),
+        allocations_(0),
+        bytes_allocated_(0),
+        children_() {}
+
+  /**
+   * Get the name of the node
+   *
+   * @return the name
+   */
+  const std::string& name() const noexcept { return name_; }
+
+  /**
+   * Get the wall time spent to evaluate the node
+   *
+   * @return the wall time in seconds
+   */
+  double wall_time() const noexcept { return wall_time_; }
+
+  /**
+   * Get the number of elements produced by the node
+   *
+   * @return the number of elements
+   */
+  size_t elements() const noexcept { return elements_; }
+
+  /**
+   * Get the number of bytes read from the NetCDF files
+   *
+   * @return the number of bytes
+   */
+  size_t bytes_read() const noexcept { return bytes_read_; }
+
+  /**
+   * Get the number of arrays allocated
+   *
+   * @return the number of allocations
+   */
+  size_t allocations() const noexcept { return allocations_; }
+
+  /**
+   * Get the number of bytes allocated
+   *
+   * @return the number of bytes
+   */
+  size_t bytes_allocated() const noexcept { return bytes_allocated_; }
+
+  /**
+   * Get the child nodes
+   *
+   * @return the child nodes
+   */
+  const std::list<Node>& children() const noexcept { return children_; }
+
+ private:
+  friend class Profiler;
+
+  std::string name_;
+  double wall_time_;
+  size_t elements_;
+  size_t bytes_read_;
+  size_t allocations_;
+  size_t bytes_allocated_;
+  std::list<Node> children_;
+};
+
+/**
+ * Records the evaluation tree of a query and the resources consumed by each
+ * of its nodes (EXPLAIN ANALYZE).
+ */
+class Profiler {
+ public:
+  //! Clock used to measure the wall time
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Default constructor
+   *
+   * @param name name of the root node
+   */
+  explicit Profiler(const std::string& name = "query")
+      : root_(name), stack_(), bytes_read_(), process_peak_memory_(0) {}
+
+  /**
+   * Open a new node: the nodes created until the matching call to Close are
+   * its children
+   *
+   * @param name name of the node
+   */
+  void Open(const std::string& name);
+
+  /**
+   * Close the last node opened
+   *
+   * @param elements number of elements produced by the node
+   * @param bytes_allocated number of bytes allocated by the node to store
+   *  its result
+   */
+  void Close(const size_t elements, const size_t bytes_allocated);
+
+  /**
+   * Replace the last nodes created by a new node having them as children.
+   * Used for operators whose operands are evaluated before the operator is
+   * known.
+   *
+   * @param name name of the node
+   * @param arity number of nodes to replace
+   * @param wall_time wall time spent by the operator itself, in seconds
+   * @param elements number of elements produced by the operator
+   * @param bytes_allocated number of bytes allocated by the operator
+   */
+  void Reduce(const std::string& name, const size_t arity,
+              const double wall_time, const size_t elements,
+              const size_t bytes_allocated);
+
+  /**
+   * Record the bytes read from a NetCDF variable by the current node
+   *
+   * @param variable name of the variable read
+   * @param bytes number of bytes read
+   */
+  void AddBytesRead(const std::string& variable, const size_t bytes);
+
+  /**
+   * Get the root node of the evaluation tree
+   *
+   * @return the root node
+   */
+  const Node& root() const noexcept { return root_; }
+
+  /**
+   * Get the number of bytes read for each variable
+   *
+   * @return the bytes read indexed by variable name
+   */
+  const std::map<std::string, size_t>& bytes_read() const noexcept {
+    return bytes_read_;
+  }
+
+  /**
+   * Get the peak resident memory of the process, since its start, when the
+   * last top-level node was evaluated. This is not the memory used by the
+   * query: see Node::bytes_allocated for the memory allocated by each node.
+   *
+   * @return the peak memory in bytes, 0 if unknown
+   */
+  size_t process_peak_memory() const noexcept { return process_peak_memory_; }
+
+  /**
+   * Get a human-readable report of the evaluation
+   *
+   * @return the report
+   */
+  std::string ToString() const;
+
+  /**
+   * Get a JSON report of the evaluation
+   *
+   * @return the report
+   */
+  std::string ToJson() const;
+
+ private:
+  // A node being evaluated
+  struct Frame {
+    Node* node;
+    Clock::time_point start;
+  };
+
+  Node root_;
+  std::vector<Frame> stack_;
+  std::map<std::string, size_t> bytes_read_;
+  size_t process_peak_memory_;
+
+  // Get the node receiving the new children
+  Node& Current() noexcept {
+    return stack_.empty() ? root_ : *stack_.back().node;
+  }
+
+  // Update the root node once a top-level node has been evaluated
+  void Update(const Node& last);
+};
+
+/**
+ * Open a node on construction and close it on destruction. The profiler may
+ * be null: in this case nothing is recorded.
+ */
+class Scope {
+ public:
+  /**
+   * Default constructor
+   *
+   * @param profiler the profiler used or null
+   * @param name name of the node
+   */
+  Scope(Profiler* profiler, const std::string& name)
+      : profiler_(profiler), elements_(0), bytes_allocated_(0) {
+    if (profiler_ != nullptr) profiler_->Open(name);
+  }
+
+  /**
+   * Close the node
+   */
+  ~Scope() {
+    if (profiler_ != nullptr) profiler_->Close(elements_, bytes_allocated_);
+  }
+
+  /**
+   * Set the result produced by the node
+   *
+   * @param elements number of elements produced
+   * @param bytes_allocated number of bytes allocated to store the result
+   */
+  void SetResult(const size_t elements, const size_t bytes_allocated) noexcept {
+    elements_ = elements;
+    bytes_allocated_ = bytes_allocated;
+  }
+
+  /**
+   * Copying a scope would close the node twice
+   */
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+ private:
+  Profiler* profiler_;
+  size_t elements_;
+  size_t bytes_allocated_;
+};
+
+}  // namespace profile
+}  // namespace netcdf
@@ -0,0 +1,70 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+
+namespace netcdf {
+
+/**
+ * Algorithms discarding the mantissa bits that do not contribute to the
+ * precision of the values, so that they compress better. The values match
+ * the NC_QUANTIZE_* constants of the netCDF library.
+ */
+enum class QuantizeMode : int {
+  kNone = 0,              //!< no quantization
+  kBitGroom = 1,          //!< BitGroom: keep a number of significant digits
+  kGranularBitRound = 2,  //!< Granular BitRound: keep a number of
+                          //!< significant digits, value by value
+  kBitRound = 3           //!< BitRound: keep a number of significant bits
+};
+
+/**
+ * @brief Quantize values
+ *
+ * For BitGroom and Granular BitRound, @c nsd is the number of significant
+ * decimal digits kept (1 to 7 for float, 1 to 15 for double). For BitRound,
+ * it is the number of significant bits kept in the mantissa (1 to 23 for
+ * float, 1 to 52 for double). NaN, infinite, zero and fill values are left
+ * unchanged. BitGroom and BitRound are processed by SIMD kernels selected
+ * at runtime.
+ *
+ * @param values values to quantize
+ * @param size number of values
+ * @param mode quantization algorithm
+ * @param nsd number of significant digits or bits
+ * @param fill_value value representing the missing values
+ * @throw std::invalid_argument if nsd is not valid for the mode and the
+ * type of the values
+ */
+void Quantize(float* values, size_t size, QuantizeMode mode, int nsd,
+              float fill_value);
+
+/**
+ * @brief Quantize values
+ *
+ * @param values values to quantize
+ * @param size number of values
+ * @param mode quantization algorithm
+ * @param nsd number of significant digits or bits
+ * @param fill_value value representing the missing values
+ * @see Quantize(float*, size_t, QuantizeMode, int, float)
+ */
+void Quantize(double* values, size_t size, QuantizeMode mode, int nsd,
+              double fill_value);
+
+}  // namespace netcdf
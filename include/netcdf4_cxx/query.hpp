@@ -1,11 +1,112 @@
 #pragma once
 
+#include <netcdf.h>
 #include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/function.hpp>
+#include <netcdf4_cxx/hyperslab.hpp>
+#include <netcdf4_cxx/profile.hpp>
 #include <netcdf4_cxx/units.hpp>
+#include <list>
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace netcdf {
 
+/**
+ * Set of NetCDF files queried together.
+ *
+ * Each file is identified by an alias qualifying the references to its
+ * variables: ${obs:sst} designates the variable sst of the file registered
+ * under the alias obs. The references without alias designate the variables
+ * of the default file. The files are not copied: they must outlive the
+ * context.
+ */
+class QueryContext {
+ public:
+  /**
+   * Default constructor
+   */
+  QueryContext() = default;
+
+  /**
+   * Create a context whose default file is the given file
+   *
+   * @param file the default file
+   */
+  QueryContext(const File& file) : default_(&file), files_() {}
+
+  /**
+   * Register a file under an alias. A file already registered with the same
+   * alias is replaced.
+   *
+   * @param alias alias of the file
+   * @param file the file to register
+   * @throw std::invalid_argument if the alias is not a valid identifier
+   */
+  void Add(const std::string& alias, const File& file);
+
+  /**
+   * Get the file registered under an alias
+   *
+   * @param alias alias of the file or an empty string to get the default file
+   * @return the file
+   * @throw std::runtime_error if no file is registered under this alias
+   */
+  const File& GetFile(const std::string& alias) const;
+
+  /**
+   * Find the variable designated by a reference: [alias:]path where path is
+   * the name of the variable or its path in the group tree, for example
+   * /forecast/member03/t2m
+   *
+   * @param reference reference to the variable
+   * @return the variable, or null if not found
+   * @throw std::runtime_error if no file is registered under the alias
+   */
+  std::shared_ptr<Variable> FindVariable(const std::string& reference) const;
+
+  /**
+   * Split a reference into the alias of the file and the path to the
+   * variable
+   *
+   * @param reference reference to the variable
+   * @return a pair that contains the alias, empty for the default file, and
+   *  the path to the variable
+   */
+  static std::pair<std::string, std::string> SplitReference(
+      const std::string& reference);
+
+ private:
+  const File* default_ = nullptr;
+  std::map<std::string, const File*> files_;
+};
+
+/**
+ * Properties of the variable created by Query::EvaluateInto
+ */
+struct EvaluateOptions {
+  //! Unit of the result. If empty, the unit declared by the user-defined
+  //! function returning the result or the unit shared by all the NetCDF
+  //! variables used in the expression is used, if any.
+  std::string unit = "";
+  //! Maximum number of values evaluated at once
+  size_t tile_size = 1 << 20;
+  //! Chunk sizes of the variable created. If empty, the default storage
+  //! defined by the NetCDF library is used.
+  std::vector<size_t> chunk_sizes = {};
+  //! Deflate level, between 0 (no compression) and 9
+  int deflate_level = 0;
+  //! Turn on the shuffle filter
+  bool shuffle = false;
+  //! Value written where the expression is undefined (NaN)
+  double fill_value = NC_FILL_DOUBLE;
+  //! If not null, records the evaluation of each tile and the writing of
+  //! the results
+  profile::Profiler* profiler = nullptr;
+};
+
 /**
  * Execute queries on NetCDF files.
  *
@@ -18,13 +119,24 @@ namespace netcdf {
  *  * Boolean logic (&&, ||, &, |)
  *  * Constants (e, log2e, log10e, ln2, ln10, pi, pi_2, pi_4, 1_pi, 2_pi,
  *               2_sqrtpi, sqrt2, sqrt1_2)
+ *  * User-defined functions (see Query::RegisterFunction)
  *  * Expression local variables
  *  * Expression NetCDF variable : ${X} where X is the NetCDF variable name
+ *    or its path in the group tree (${/forecast/member03/t2m}). In a
+ *    QueryContext, the reference can be qualified by the alias of a file
+ *    (${obs:sst}).
  *    Expressions can handle physical units of NetCDF variables.
  *
+ * When an expression uses several variables, they are read by a background
+ * thread, in order of appearance, so that the reading of a variable overlaps
+ * the evaluation of the expression on the variables already read. This thread
+ * makes all the calls to the NetCDF library during the evaluation: the
+ * library is not thread-safe.
+ *
  *  Example:
  *  @code
  *    X = ${X} * 0.001; Y = abs(${Y}); sqrt(X/Y)
+ *    ${obs:/analysis/sst} - ${model:sst}
  *  @endcode
  */
 class Query {
@@ -42,14 +154,80 @@ class Query {
   /**
    * Evaluate the mathematical expression on the NetCDF file.
    *
-   * @param file NetCDF File to be query
+   * @param context NetCDF files to be queried
    * @param query mathematical expression
    * @param unit unit of result
    * @return the result of the expression
    */
-  std::valarray<double> Evaluate(const File& file, const std::string& query,
+  std::valarray<double> Evaluate(const QueryContext& context,
+                                 const std::string& query,
                                  const std::string& unit = "");
 
+  /**
+   * Evaluate the mathematical expression on the NetCDF file and record how
+   * the evaluation was carried out (EXPLAIN ANALYZE): the evaluation tree of
+   * the expression with, for each node, the wall time spent, the number of
+   * elements produced, the bytes read and the arrays allocated. The loading
+   * of the NetCDF variables is split between the reading of the data, the
+   * masking and scaling of the values read and the unit conversion.
+   *
+   * @code
+   *   netcdf::profile::Profiler profiler;
+   *   auto values = query.Evaluate(file, "sqrt(${X} * ${Y})", profiler);
+   *   std::cout << profiler.ToString();
+   * @endcode
+   *
+   * @param context NetCDF files to be queried
+   * @param query mathematical expression
+   * @param profiler profiler receiving the evaluation tree
+   * @param unit unit of result
+   * @return the result of the expression
+   */
+  std::valarray<double> Evaluate(const QueryContext& context,
+                                 const std::string& query,
+                                 profile::Profiler& profiler,
+                                 const std::string& unit = "");
+
+  /**
+   * Evaluate the mathematical expression on the NetCDF file and store the
+   * result in a new variable.
+   *
+   * The NetCDF variables used in the expression must have the same shape: the
+   * variable created uses their dimensions. The expression is evaluated tile
+   * by tile along the first dimension, so the result never has to be held
+   * entirely in memory.
+   *
+   * @param context NetCDF files to be queried
+   * @param query mathematical expression
+   * @param target group in which the variable is created
+   * @param name name of the variable to create
+   * @param options properties of the variable created
+   * @return the variable created
+   */
+  Variable EvaluateInto(const QueryContext& context, const std::string& query,
+                        const Group& target, const std::string& name,
+                        const EvaluateOptions& options = EvaluateOptions());
+
+  /**
+   * Register a user-defined function callable from the expressions. A
+   * function already registered with the same name is replaced.
+   *
+   * @param name name of the function
+   * @param function the function to register
+   * @throw std::invalid_argument if the name is not a valid identifier or
+   *  is used by a built-in function or constant
+   */
+  static void RegisterFunction(const std::string& name,
+                               const Function& function);
+
+  /**
+   * Remove a user-defined function
+   *
+   * @param name name of the function
+   * @return true if the function was registered
+   */
+  static bool UnregisterFunction(const std::string& name);
+
   /**
    * Conversion of values from one physical unit to another.
    *
@@ -65,43 +243,59 @@ class Query {
   }
 };
 
+// Reads in background the variables used by an expression
+class Prefetcher;
+
 /**
  * Provides a modified interface to Query
  */
 class QueryProxy {
  private:
-  const File& file_;
   const Query& query_;
+  QueryContext context_;
   const std::string& unit_;
+  Hyperslab hyperslab_;
+  profile::Profiler* profiler_;
+  std::shared_ptr<Prefetcher> prefetcher_;
 
  public:
   /**
    * Default constructor
    *
    * @param query Query instance to be used
-   * @param file NetCDF file to be used
+   * @param context NetCDF files to be used
    * @param unit unit of the result of the query
+   * @param hyperslab part of the variables to be loaded. If empty, the
+   *  variables are entirely loaded.
+   * @param profiler profiler recording the evaluation or null
    */
-  QueryProxy(const Query& query, const File& file, const std::string& unit)
-      : query_(query), file_(file), unit_(unit) {}
+  QueryProxy(const Query& query, const QueryContext& context,
+             const std::string& unit, const Hyperslab& hyperslab = Hyperslab(),
+             profile::Profiler* profiler = nullptr);
 
   /**
-   * Load a variable from the NetCDF File handled
+   * Start reading in background the variables used by an expression. Until
+   * the destruction of this instance, or until all the variables have been
+   * loaded, the NetCDF library must not be called by another thread.
    *
-   * @param name Variable name
+   * @param references references to the variables, in order of use
+   */
+  void Prefetch(const std::list<std::string>& references);
+
+  /**
+   * Load a variable from the NetCDF files handled
+   *
+   * @param name reference to the variable
    * @result the values read
    */
-  std::valarray<double> LoadVariable(const std::string& name) const {
-    auto variable = file_.FindVariable(name);
-    if (!variable) throw std::runtime_error(name + ": no such variable");
-    std::valarray<double> values = variable->ReadMaskAndScale<double>();
-    if (!unit_.empty()) {
-      auto units = variable->FindAttribute("units");
-      query_.ConvertToSamePysicalUnit(unit_, units ? units->ReadText() : "1",
-                                      values);
-    }
-    return values;
-  }
+  std::valarray<double> LoadVariable(const std::string& name) const;
+
+  /**
+   * Get the profiler recording the evaluation
+   *
+   * @return the profiler or null if the evaluation is not profiled
+   */
+  profile::Profiler* profiler() const noexcept { return profiler_; }
 };
 
 }  // namespace netcdf
@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <algorithm>
+#include <bitset>
 #include <cmath>
 #include <iterator>
 #include <valarray>
@@ -24,12 +27,26 @@ namespace netcdf {
 
 class DataSet;
 
+/**
+ * Reason why a value is considered as missing
+ */
+enum class MaskReason : uint8_t {
+  kValid = 0,         //!< the value is valid
+  kNaN = 1,           //!< the value is NaN
+  kFillValue = 2,     //!< the value equals the _FillValue
+  kMissingValue = 3,  //!< the value equals the missing_value
+  kBelowMinimum = 4,  //!< the value is less than the valid minimum
+  kAboveMaximum = 5   //!< the value is greater than the valid maximum
+};
+
 /**
  * @brief A variable decorator that handles missing data, and scale/offset
  * packed data.
  *
  * Specifically, this handles:
- *  - packed data using @c scale_factor and @c add_offset
+ *  - packed data using @c scale_factor and @c add_offset: as defined by the
+ *    CF conventions, the values are unpacked with
+ *    packed * scale_factor + add_offset
  *  - invalid/missing data using @c valid_min, @c valid_max, @c valid_range,
  *   @c missing_value or @c _FillValue
  *
@@ -50,6 +67,12 @@ class ScaleMissing {
   double offset_;
   double fill_value_;
   double missing_value_;
+  // Values tested to find the missing data. The tests not requested by the
+  // attributes use values that never match: NaN or infinities.
+  double mask_min_;
+  double mask_max_;
+  double mask_fill_value_;
+  double mask_missing_value_;
 
  public:
   /**
@@ -97,6 +120,46 @@ class ScaleMissing {
    */
   inline constexpr double get_valid_max() const noexcept { return valid_max_; }
 
+  /**
+   * @brief The variable defined packed data
+   *
+   * @return true if Variable has scale_factor or add_offset attributes
+   * different from the identity
+   */
+  inline constexpr bool HasScaleOffset() const noexcept {
+    return has_scale_offset_;
+  }
+
+  /**
+   * @brief Scale factor applied on the packed data
+   *
+   * @return the scale factor
+   */
+  inline constexpr double get_scale_factor() const noexcept { return scale_; }
+
+  /**
+   * @brief Offset applied on the packed data
+   *
+   * @return the offset
+   */
+  inline constexpr double get_add_offset() const noexcept { return offset_; }
+
+  /**
+   * @brief Determines if another description packs the data in the same way
+   *
+   * @param rhs description to compare
+   * @return true if both descriptions use the same scale factor and offset,
+   * and consider the same values as missing: _FillValue, missing_value and
+   * valid range
+   */
+  inline constexpr bool HasSamePacking(const ScaleMissing& rhs) const
+      noexcept {
+    return scale_ == rhs.scale_ && offset_ == rhs.offset_ &&
+           IsSame(mask_fill_value_, rhs.mask_fill_value_) &&
+           IsSame(mask_missing_value_, rhs.mask_missing_value_) &&
+           mask_min_ == rhs.mask_min_ && mask_max_ == rhs.mask_max_;
+  }
+
   /**
    * @brief Value it's outside the valid range
    *
@@ -145,46 +208,82 @@ class ScaleMissing {
   /**
    * @brief Determines if value is valid
    *
+   * The value is missing if it is NaN, equals the missing_value or the
+   * _FillValue, or is outside the valid range.
+   *
    * @param value value to test
    *
    * @return true if value is missing
    */
   inline bool IsMissing(const double value) const noexcept {
-    return std::isnan(value) || IsMissingValue(value) || IsFillValue(value);
+    // Bitwise operators: all the tests are evaluated, without branches
+    return (value != value) | (value == mask_missing_value_) |
+           (value == mask_fill_value_) | (value < mask_min_) |
+           (value > mask_max_);
+  }
+
+  /**
+   * @brief Get the reason why a value is missing
+   *
+   * @param value value to test
+   * @return the reason, MaskReason::kValid if the value is valid
+   */
+  inline MaskReason GetMaskReason(const double value) const noexcept {
+    return value != value
+               ? MaskReason::kNaN
+               : value == mask_fill_value_
+                     ? MaskReason::kFillValue
+                     : value == mask_missing_value_
+                           ? MaskReason::kMissingValue
+                           : value < mask_min_
+                                 ? MaskReason::kBelowMinimum
+                                 : value > mask_max_ ? MaskReason::kAboveMaximum
+                                                     : MaskReason::kValid;
+  }
+
+  /**
+   * @brief Compute the validity bitmap of values read in their storage type
+   *
+   * The bitmap uses the layout of Apache Arrow: bit i % 8 of byte i / 8 is
+   * set if the value i is valid. The padding bits of the last byte are
+   * cleared. Values of type short, float and double are processed by SIMD
+   * kernels selected at runtime.
+   *
+   * @param values values to test
+   * @param size number of values
+   * @param validity bitmap computed, (size + 7) / 8 bytes
+   * @param reasons if not null, receives for each value a MaskReason code
+   * @return the number of missing values
+   */
+  template <typename T>
+  size_t ComputeValidity(const T* const values, const size_t size,
+                         uint8_t* const validity,
+                         uint8_t* const reasons = nullptr) const {
+    return ComputeValidityScalar(values, size, validity, reasons);
   }
 
   /**
-   * @brief Compress data with scale and offset.
+   * @brief Compress data with scale and offset: the values are replaced by
+   * (x - add_offset) / scale_factor.
    *
    * @param array data to convert
    */
   template <typename T>
   std::valarray<T>& Inflate(std::valarray<T>& array) const {
-    if (!has_scale_offset_) return;
-
-    const size_t n = array.size();
-    for (size_t ix = 0; ix < n; ++ix) {
-      T& item = array[ix];
-      if (!IsMissing(item)) item = item * scale_ + offset_;
-    }
+    if (has_scale_offset_) Apply(array, kInflate, T());
     return array;
   }
 
   /**
-   * @brief Uncompress data with scale and offset.
+   * @brief Uncompress data with scale and offset: the values are replaced by
+   * x * scale_factor + add_offset.
    *
    * @param array data to convert
    *
    */
   template <typename T>
   std::valarray<T>& Deflate(std::valarray<T>& array) const {
-    if (!has_scale_offset_) return;
-
-    const size_t n = array.size();
-    for (size_t ix = 0; ix < n; ++ix) {
-      T& item = array[ix];
-      if (!IsMissing(item)) item = (item - offset_) / scale_;
-    }
+    if (has_scale_offset_) Apply(array, kDeflate, T());
     return array;
   }
 
@@ -197,11 +296,7 @@ class ScaleMissing {
    */
   template <typename T>
   std::valarray<T>& Mask(std::valarray<T>& array, const T& value) const {
-    const size_t n = array.size();
-    for (size_t ix = 0; ix < n; ++ix) {
-      T& item = array[ix];
-      if (IsMissing(item)) item = value;
-    }
+    Apply(array, kMask, value);
     return array;
   }
 
@@ -214,14 +309,37 @@ class ScaleMissing {
   template <typename T>
   std::valarray<T>& MaskAndDeflate(std::valarray<T>& array,
                                    const T& value) const {
-    const size_t n = array.size();
-    for (size_t ix = 0; ix < n; ++ix) {
-      T& item = array[ix];
-      item = IsMissing(item) ? value : (item - offset_) / scale_;
-    }
+    Apply(array, has_scale_offset_ ? kMask | kDeflate : kMask, value);
     return array;
   }
 
+  /**
+   * Apply Mask and Deflate operations, in one pass, on values read in their
+   * storage type and store the result in another type. The missing values
+   * are detected on the values read.
+   *
+   * @param input values read
+   * @param size number of values
+   * @param output values converted
+   * @param value the value that represents the "missing" value
+   */
+  template <typename R, typename T>
+  void MaskAndDeflate(const R* const input, const size_t size,
+                      T* const output, const T& value) const {
+    if (!has_scale_offset_) {
+      for (size_t ix = 0; ix < size; ++ix) {
+        const double x = static_cast<double>(input[ix]);
+        output[ix] = IsMissing(x) ? value : static_cast<T>(input[ix]);
+      }
+      return;
+    }
+    for (size_t ix = 0; ix < size; ++ix) {
+      const double x = static_cast<double>(input[ix]);
+      const T y = static_cast<T>(x * scale_ + offset_);
+      output[ix] = IsMissing(x) ? value : y;
+    }
+  }
+
   /**
    * Apply Mask and Inflate operations in one operation
    *
@@ -229,13 +347,93 @@ class ScaleMissing {
    */
   template <typename T>
   std::valarray<T>& MaskAndInflate(std::valarray<T>& array) const {
+    Apply(array, has_scale_offset_ ? kMask | kInflate : kMask,
+          static_cast<T>(missing_value_));
+    return array;
+  }
+
+ private:
+  // Compare two values, NaN being equal to NaN
+  static constexpr bool IsSame(const double lhs, const double rhs) noexcept {
+    return lhs == rhs || (lhs != lhs && rhs != rhs);
+  }
+
+  // Compute the validity bitmap value by value
+  template <typename T>
+  size_t ComputeValidityScalar(const T* const values, const size_t size,
+                               uint8_t* const validity,
+                               uint8_t* const reasons) const {
+    size_t result = 0;
+    for (size_t ix = 0; ix < size; ix += 8) {
+      const size_t n = std::min<size_t>(8, size - ix);
+      uint8_t byte = 0;
+      for (size_t jx = 0; jx < n; ++jx) {
+        const MaskReason reason =
+            GetMaskReason(static_cast<double>(values[ix + jx]));
+        byte |= static_cast<uint8_t>(reason == MaskReason::kValid) << jx;
+        if (reasons != nullptr)
+          reasons[ix + jx] = static_cast<uint8_t>(reason);
+      }
+      validity[ix >> 3] = byte;
+      result += n - std::bitset<8>(byte).count();
+    }
+    return result;
+  }
+
+  // Operations applied on the values
+  enum Operation { kMask = 1, kInflate = 2, kDeflate = 4 };
+
+  // Apply operations on the values. The generic implementation is a scalar
+  // loop; float and double arrays are processed by SIMD kernels selected at
+  // runtime according to the instruction sets supported by the CPU.
+  template <typename T>
+  void Apply(std::valarray<T>& array, const int operations,
+             const T value) const {
     const size_t n = array.size();
+    if (operations == kMask) {
+      for (size_t ix = 0; ix < n; ++ix) {
+        T& item = array[ix];
+        item = IsMissing(item) ? value : item;
+      }
+      return;
+    }
+    const bool mask = (operations & kMask) != 0;
+    const bool inflate = (operations & kInflate) != 0;
     for (size_t ix = 0; ix < n; ++ix) {
       T& item = array[ix];
-      item = IsMissing(item) ? missing_value_ : item * scale_ + offset_;
+      const double x = static_cast<double>(item);
+      const T y = static_cast<T>(inflate ? (x - offset_) / scale_
+                                         : x * scale_ + offset_);
+      item = IsMissing(x) ? (mask ? value : item) : y;
     }
-    return array;
   }
 };
 
+// SIMD implementations
+template <>
+size_t ScaleMissing::ComputeValidity(const short* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const;
+
+template <>
+size_t ScaleMissing::ComputeValidity(const float* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const;
+
+template <>
+size_t ScaleMissing::ComputeValidity(const double* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const;
+
+template <>
+void ScaleMissing::Apply(std::valarray<float>& array, const int operations,
+                         const float value) const;
+
+template <>
+void ScaleMissing::Apply(std::valarray<double>& array, const int operations,
+                         const double value) const;
+
 }  // namespace netcdf
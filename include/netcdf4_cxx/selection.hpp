@@ -0,0 +1,296 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <stddef.h>
+#include <netcdf4_cxx/hyperslab.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace netcdf {
+
+/**
+ * Selection of arbitrary elements of a variable, given by the list of
+ * their indices. Unlike an Hyperslab, the elements need not be regularly
+ * spaced: the values are returned in the order of the points, which may
+ * repeat.
+ */
+class PointSelection {
+ private:
+  size_t rank_;                      //!< number of dimensions
+  std::vector<size_t> coordinates_;  //!< indices of the points, row-major
+
+ public:
+  /**
+   * Create a selection from the indices of the points, stored one point
+   * after the other.
+   *
+   * @param rank number of dimensions of the variable
+   * @param coordinates indices of the points: rank values per point
+   */
+  PointSelection(const size_t rank, std::vector<size_t> coordinates)
+      : rank_(rank), coordinates_(std::move(coordinates)) {
+    if (rank_ == 0) throw std::invalid_argument("rank must be > 0");
+    if (coordinates_.size() % rank_ != 0)
+      throw std::invalid_argument(
+          "the number of coordinates is not a multiple of the rank");
+  }
+
+  /**
+   * Create a selection from one array of indices per dimension: the nth
+   * point is made of the nth index of each array.
+   *
+   * @param indices indices for each dimension, of the same length
+   */
+  explicit PointSelection(const std::vector<std::vector<size_t>>& indices)
+      : rank_(indices.size()), coordinates_() {
+    if (rank_ == 0) throw std::invalid_argument("rank must be > 0");
+    const size_t size = indices.front().size();
+    for (auto& item : indices) {
+      if (item.size() != size)
+        throw std::invalid_argument("the indices are not aligned");
+    }
+    coordinates_.reserve(size * rank_);
+    for (size_t ix = 0; ix < size; ++ix) {
+      for (auto& item : indices) coordinates_.push_back(item[ix]);
+    }
+  }
+
+  /**
+   * Create a selection from the list of points
+   *
+   * @param points indices of each point
+   */
+  static PointSelection FromPoints(
+      const std::vector<std::vector<size_t>>& points) {
+    if (points.empty())
+      throw std::invalid_argument("the selection must hold a point");
+    std::vector<size_t> coordinates;
+    coordinates.reserve(points.size() * points.front().size());
+    for (auto& item : points) {
+      if (item.size() != points.front().size())
+        throw std::invalid_argument("the points are not aligned");
+      coordinates.insert(coordinates.end(), item.begin(), item.end());
+    }
+    return PointSelection(points.front().size(), std::move(coordinates));
+  }
+
+  /**
+   * Create a selection from one array of indices per dimension, selecting
+   * every combination of these indices, the last dimension varying
+   * fastest.
+   *
+   * @param indices indices for each dimension
+   */
+  static PointSelection Outer(const std::vector<std::vector<size_t>>& indices) {
+    size_t size = 1;
+    for (auto& item : indices) size *= item.size();
+
+    std::vector<size_t> coordinates;
+    coordinates.reserve(size * indices.size());
+    std::vector<size_t> index(indices.size(), 0);
+    for (size_t ix = 0; ix < size; ++ix) {
+      for (size_t dim = 0; dim < indices.size(); ++dim) {
+        coordinates.push_back(indices[dim][index[dim]]);
+      }
+      for (size_t dim = indices.size(); dim-- > 0;) {
+        if (++index[dim] < indices[dim].size()) break;
+        index[dim] = 0;
+      }
+    }
+    return PointSelection(indices.size(), std::move(coordinates));
+  }
+
+  /**
+   * Get rank - number of dimensions
+   *
+   * @return rank
+   */
+  size_t GetRank() const noexcept { return rank_; }
+
+  /**
+   * Get the number of points selected
+   *
+   * @return number of points
+   */
+  size_t GetSize() const noexcept { return coordinates_.size() / rank_; }
+
+  /**
+   * Get the indices of the nth point
+   *
+   * @param index index of the point
+   * @return a pointer to the rank indices of the point
+   */
+  const size_t* operator[](const size_t index) const noexcept {
+    return &coordinates_[index * rank_];
+  }
+
+  /**
+   * Get the indices of the points, stored one point after the other
+   *
+   * @return the indices
+   */
+  const std::vector<size_t>& coordinates() const noexcept {
+    return coordinates_;
+  }
+};
+
+/**
+ * Box read to serve some points of a PointSelection
+ */
+struct PointBlock {
+  Hyperslab box;                //!< values read
+  std::vector<size_t> points;   //!< points served by the box
+  std::vector<size_t> offsets;  //!< position of each point in the box
+};
+
+/**
+ * Group the points of a selection into boxes read in a single call. The
+ * points are sorted by the chunk holding them, and the points of a chunk
+ * are read with their bounding box, split where it would hold too many
+ * values not selected.
+ *
+ * A chunk may therefore be read by several calls, one after the other.
+ * They decompress it once only if it stays in the chunk cache of the HDF5
+ * library: a chunk larger than this cache is decompressed by each call,
+ * which trades the decompression of the chunk for fewer values copied.
+ *
+ * @param selection points to read
+ * @param shape shape of the variable read
+ * @param chunks shape of the chunks storing the variable, empty if it is
+ *  stored contiguously
+ * @return the boxes to read, in the order of the chunks
+ * @throw std::invalid_argument if a point is outside the variable
+ */
+std::vector<PointBlock> Coalesce(const PointSelection& selection,
+                                 const std::vector<size_t>& shape,
+                                 const std::vector<size_t>& chunks);
+
+/**
+ * Values of an hyperslab extracted from a box read by ScheduleChunkReads
+ */
+struct ChunkExtract {
+  size_t hyperslab;                //!< index of the hyperslab served
+  size_t src;                      //!< position of the first value in box
+  size_t dst;                      //!< position of the first value served
+  std::vector<size_t> count;       //!< number of values per dimension
+  std::vector<size_t> src_stride;  //!< distance between values in the box
+  std::vector<size_t> dst_stride;  //!< distance between values served
+
+  /**
+   * Copy the values extracted
+   *
+   * @param box values read
+   * @param values values of the hyperslab served
+   */
+  template <typename T>
+  void Copy(const T* box, T* values) const {
+    const size_t last = count.size() - 1;
+    std::vector<size_t> index(count.size(), 0);
+    while (true) {
+      size_t from = src;
+      size_t to = dst;
+      for (size_t dim = 0; dim < last; ++dim) {
+        from += index[dim] * src_stride[dim];
+        to += index[dim] * dst_stride[dim];
+      }
+      for (size_t ix = 0; ix < count[last]; ++ix) {
+        values[to + ix * dst_stride[last]] = box[from + ix * src_stride[last]];
+      }
+
+      // Move to the next row, the last dimension varying fastest
+      size_t dim = last;
+      while (true) {
+        if (dim == 0) return;
+        --dim;
+        if (++index[dim] < count[dim]) break;
+        index[dim] = 0;
+      }
+    }
+  }
+};
+
+/**
+ * Box read within a chunk, serving one or more hyperslabs
+ */
+struct ChunkRead {
+  Hyperslab box;                       //!< values read
+  std::vector<ChunkExtract> extracts;  //!< values served from the box
+};
+
+/**
+ * Plan the reads of a list of hyperslabs of a chunked variable. Each chunk
+ * touched by the hyperslabs is read once, with the box bounding the values
+ * selected in it, and the chunks are read in the order of their
+ * coordinates, the order used by the HDF5 library to index them.
+ *
+ * @param hyperslabs values to read
+ * @param shape shape of the variable read
+ * @param chunks shape of the chunks storing the variable
+ * @return the boxes to read
+ * @throw std::invalid_argument if an hyperslab is outside the variable
+ */
+std::vector<ChunkRead> ScheduleChunkReads(
+    const std::vector<Hyperslab>& hyperslabs, const std::vector<size_t>& shape,
+    const std::vector<size_t>& chunks);
+
+/**
+ * Sort a list of hyperslabs of a variable stored contiguously in the order
+ * of their first value in the file
+ *
+ * @param hyperslabs values to read
+ * @param shape shape of the variable read
+ * @return the indices of the hyperslabs, sorted
+ * @throw std::invalid_argument if an hyperslab is outside the variable
+ */
+std::vector<size_t> SortByOffset(const std::vector<Hyperslab>& hyperslabs,
+                                 const std::vector<size_t>& shape);
+
+/**
+ * Default cost of a request of the netCDF library, expressed as the number
+ * of values copied in the same time. This is a conservative estimate, not a
+ * measure: bench_strided shows the crossover to tune it on a given system.
+ */
+constexpr size_t kRequestCost = 64;
+
+/**
+ * Choose how the values selected by an hyperslab with steps are read. The
+ * strided reads of the netCDF library issue one request per value, or per
+ * row when the last dimension is adjacent; reading the box enclosing the
+ * values and keeping the values selected costs one copy per value of the
+ * box.
+ *
+ * @param hyperslab values to read
+ * @param request_cost cost of a request
+ * @return true if the enclosing box is cheaper to read
+ */
+bool ReadEnclosingBox(const Hyperslab& hyperslab,
+                      const size_t request_cost = kRequestCost);
+
+/**
+ * Reorder, in place, the values read with hyperslab.Forward() into the
+ * order selected by an hyperslab with negative steps
+ *
+ * @param hyperslab values selected
+ * @param values values read in increasing order
+ * @param width size of a value in bytes
+ */
+void Reverse(const Hyperslab& hyperslab, void* values, const size_t width);
+
+}  // namespace netcdf
@@ -51,6 +51,36 @@ enum class Primitive {
   kCompound = NC_COMPOUND,  //!< kCompound compound types
 };
 
+/**
+ * Primitive type storing the values of the C++ type T
+ *
+ * @tparam T C++ type
+ */
+template <typename T>
+struct PrimitiveOf {
+  static constexpr Primitive value = Primitive::kNotAType;  //!< the type
+};
+
+#define _NETCDF4CXX_PRIMITIVE_OF(_type, _primitive)           \
+  template <>                                                 \
+  struct PrimitiveOf<_type> {                                 \
+    static constexpr Primitive value = Primitive::_primitive; \
+  };
+
+_NETCDF4CXX_PRIMITIVE_OF(char, kChar)
+_NETCDF4CXX_PRIMITIVE_OF(signed char, kByte)
+_NETCDF4CXX_PRIMITIVE_OF(unsigned char, kUByte)
+_NETCDF4CXX_PRIMITIVE_OF(short, kShort)
+_NETCDF4CXX_PRIMITIVE_OF(unsigned short, kUShort)
+_NETCDF4CXX_PRIMITIVE_OF(int, kInt)
+_NETCDF4CXX_PRIMITIVE_OF(unsigned int, kUInt)
+_NETCDF4CXX_PRIMITIVE_OF(long long, kInt64)
+_NETCDF4CXX_PRIMITIVE_OF(unsigned long long, kUInt64)
+_NETCDF4CXX_PRIMITIVE_OF(float, kFloat)
+_NETCDF4CXX_PRIMITIVE_OF(double, kDouble)
+
+#undef _NETCDF4CXX_PRIMITIVE_OF
+
 class Enum;
 class VLen;
 class Opaque;
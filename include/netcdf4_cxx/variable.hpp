@@ -18,18 +18,28 @@
 
 #include <netcdf.h>
 #include <stddef.h>
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
+#include <netcdf4_cxx/cf.hpp>
 #include <netcdf4_cxx/dataset.hpp>
 #include <netcdf4_cxx/dimension.hpp>
 #include <netcdf4_cxx/hyperslab.hpp>
+#include <netcdf4_cxx/masked_array.hpp>
 #include <netcdf4_cxx/netcdf.hpp>
+#include <netcdf4_cxx/packed_array.hpp>
+#include <netcdf4_cxx/packing.hpp>
+#include <netcdf4_cxx/quantize.hpp>
 #include <netcdf4_cxx/scale_missing.hpp>
+#include <netcdf4_cxx/selection.hpp>
 #include <netcdf4_cxx/type.hpp>
 #include <numeric>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <valarray>
 #include <vector>
 
@@ -192,6 +202,88 @@ class Variable : public DataSet {
     Check(nc_get_chunk_cache(&size, &slots, &preemption));
   }
 
+  /**
+   * Store the variable in chunks of the given shape
+   *
+   * @param chunk_sizes the chunk size for each dimension of the variable
+   */
+  void SetChunking(const std::vector<size_t>& chunk_sizes) const {
+    if (chunk_sizes.size() != GetRank())
+      throw std::invalid_argument(
+          "the chunk sizes do not match the rank of the variable");
+    Check(nc_def_var_chunking(nc_id_, id_, NC_CHUNKED, &chunk_sizes[0]));
+  }
+
+  /**
+   * Store the variable contiguously
+   */
+  void SetContiguous() const {
+    Check(nc_def_var_chunking(nc_id_, id_, NC_CONTIGUOUS, nullptr));
+  }
+
+  /**
+   * Get the shape of the chunks storing the variable
+   *
+   * @return the chunk size for each dimension of the variable, or an empty
+   *  vector if the variable is stored contiguously
+   */
+  std::vector<size_t> GetChunking() const {
+    std::vector<size_t> result(GetRank());
+    if (result.empty()) return result;
+    int storage;
+    Check(nc_inq_var_chunking(nc_id_, id_, &storage, &result[0]));
+    if (storage != NC_CHUNKED) result.clear();
+    return result;
+  }
+
+  /**
+   * Set the compression settings of the variable
+   *
+   * @param shuffle if true, turn on the shuffle filter
+   * @param level deflate level, between 0 (no compression) and 9
+   */
+  void SetDeflate(const bool shuffle, const int level) const {
+    Check(nc_def_var_deflate(nc_id_, id_, shuffle ? 1 : 0, level > 0 ? 1 : 0,
+                             level));
+  }
+
+  /**
+   * Set the quantization applied by the netCDF library on the values
+   * written in this variable. The variable must store float or double
+   * values.
+   *
+   * @param mode quantization algorithm
+   * @param nsd number of significant digits (BitGroom, Granular BitRound) or
+   * bits (BitRound) kept
+   * @throw std::runtime_error if the netCDF library does not support the
+   * quantization
+   */
+  void SetQuantize(const QuantizeMode mode, const int nsd) const {
+#ifdef NC_QUANTIZE_BITGROOM
+    Check(nc_def_var_quantize(nc_id_, id_, static_cast<int>(mode), nsd));
+#else
+    throw std::runtime_error(
+        "the netCDF library does not support the quantization");
+#endif
+  }
+
+  /**
+   * Get the quantization applied by the netCDF library on the values
+   * written in this variable
+   *
+   * @param nsd number of significant digits or bits kept
+   * @return the quantization algorithm, QuantizeMode::kNone if the values
+   * are not quantized
+   */
+  QuantizeMode GetQuantize(int& nsd) const {
+    int mode = 0;
+    nsd = 0;
+#ifdef NC_QUANTIZE_BITGROOM
+    Check(nc_inq_var_quantize(nc_id_, id_, &mode, &nsd));
+#endif
+    return static_cast<QuantizeMode>(mode);
+  }
+
   /**
    * Rename a variable
    *
@@ -209,6 +301,26 @@ class Variable : public DataSet {
    */
   template <class T>
   std::valarray<T> Read(const Hyperslab& hyperslab) const {
+    std::valarray<T> values(hyperslab.GetSize());
+    Read(hyperslab, &values[0]);
+    return values;
+  }
+
+  /**
+   * Read the data for this Variable into a buffer provided by the caller.
+   * The values of the numeric types are converted to T by the netCDF
+   * library.
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @param values buffer receiving the hyperslab.GetSize() values read
+   */
+  template <class T>
+  void Read(const Hyperslab& hyperslab, T* values) const {
+    if (hyperslab.IsReversed()) {
+      Read(hyperslab.Forward(), values);
+      Reverse(hyperslab, values, sizeof(T));
+      return;
+    }
     if (sizeof(T) != GetDataType().GetSize())
       throw std::invalid_argument(
           "the size of the NetCDF type does not "
@@ -219,18 +331,81 @@ class Variable : public DataSet {
           "Hyperslab defined overlap the "
           "variable definition");
 
-    std::valarray<T> values(hyperslab.GetSize());
-
     if (hyperslab.OnlyAdjacent())
       Check(nc_get_vara(nc_id_, id_, &hyperslab.start()[0],
-                        &hyperslab.GetSizeList()[0], &values[0]));
+                        &hyperslab.GetSizeList()[0], values));
     else
       Check(nc_get_vars(nc_id_, id_, &hyperslab.start()[0],
                         &hyperslab.GetSizeList()[0], &hyperslab.step()[0],
-                        &values[0]));
+                        values));
+  }
+
+  /**
+   * Read the values of a list of points. The points are grouped into a
+   * small number of box reads, in the order of the chunks storing the
+   * variable, and the values are then returned in the order of the points.
+   *
+   * @param selection points to be read
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> Read(const PointSelection& selection) const {
+    std::valarray<T> values(selection.GetSize());
+    std::vector<T> buffer;
+    for (auto& block : Coalesce(selection, GetShape(), GetChunking())) {
+      buffer.resize(block.box.GetSize());
+      Read(block.box, &buffer[0]);
+      for (size_t ix = 0; ix < block.points.size(); ++ix) {
+        values[block.points[ix]] = buffer[block.offsets[ix]];
+      }
+    }
     return values;
   }
 
+  /**
+   * Read a list of hyperslabs. The reads of a chunked variable are
+   * scheduled so that each chunk touched is read, and decompressed, once,
+   * in the order of the chunks in the file; the hyperslabs of a variable
+   * stored contiguously are read in the order of their offset in the file.
+   *
+   * @param hyperslabs Hyperslabs to be read
+   * @return a new container on the data read for each hyperslab
+   */
+  template <class T>
+  std::vector<std::valarray<T>> ReadMany(
+      const std::vector<Hyperslab>& hyperslabs) const {
+    // The values are read in increasing order, then reversed if needed
+    std::vector<Hyperslab> forward;
+    std::vector<std::valarray<T>> result;
+    for (auto& item : hyperslabs) {
+      forward.push_back(item.Forward());
+      result.emplace_back(item.GetSize());
+    }
+
+    const std::vector<size_t> shape = GetShape();
+    const std::vector<size_t> chunks = GetChunking();
+    if (chunks.empty()) {
+      for (auto ix : SortByOffset(forward, shape)) {
+        if (result[ix].size() != 0) Read(forward[ix], &result[ix][0]);
+      }
+    } else {
+      std::vector<T> buffer;
+      for (auto& item : ScheduleChunkReads(forward, shape, chunks)) {
+        buffer.resize(item.box.GetSize());
+        Read(item.box, &buffer[0]);
+        for (auto& extract : item.extracts) {
+          extract.Copy(&buffer[0], &result[extract.hyperslab][0]);
+        }
+      }
+    }
+
+    for (size_t ix = 0; ix < hyperslabs.size(); ++ix) {
+      if (hyperslabs[ix].IsReversed() && result[ix].size() != 0)
+        Reverse(hyperslabs[ix], &result[ix][0], sizeof(T));
+    }
+    return result;
+  }
+
   /**
    * Read all the data for this Variable, mask data that are considered as
    * missing with the provided value and deflate read values
@@ -242,9 +417,163 @@ class Variable : public DataSet {
   std::valarray<T> ReadMaskAndScale(
       const Hyperslab& hyperslab,
       const double missing_value = std::numeric_limits<T>::quiet_NaN()) const {
-    ScaleMissing scale_missing(*this);
     std::valarray<T> values = Read<T>(hyperslab);
-    return scale_missing.MaskAndDeflate(values, missing_value);
+    return GetScaleMissing().MaskAndDeflate(values,
+                                            static_cast<T>(missing_value));
+  }
+
+  /**
+   * Read the data for this Variable as float or double values, mask data
+   * that are considered as missing with the provided value and deflate read
+   * values.
+   *
+   * The result is the one of ReadMaskAndScale, but the values are read in
+   * their storage type (signed or unsigned 8, 16 or 32 bits integers, float
+   * or double), tile by tile, in a staging buffer. Each tile is masked,
+   * deflated and converted in one pass into the result. The other storage
+   * types are read with ReadMaskAndScale.
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @param missing_value the value that represents the "missing" value
+   * @param tile_size maximum number of values read at once
+   * @return a new container on the data read
+   */
+  template <class T>
+  std::valarray<T> ReadUnpacked(
+      const Hyperslab& hyperslab,
+      const T missing_value = std::numeric_limits<T>::quiet_NaN(),
+      const size_t tile_size = 1 << 16) const {
+    static_assert(std::is_floating_point<T>::value,
+                  "values can only be unpacked as float or double");
+    switch (GetDataType().GetPrimitive()) {
+      case type::Primitive::kByte:
+        return ReadTiles<signed char, T>(hyperslab, missing_value, tile_size);
+      case type::Primitive::kUByte:
+        return ReadTiles<unsigned char, T>(hyperslab, missing_value,
+                                           tile_size);
+      case type::Primitive::kShort:
+        return ReadTiles<short, T>(hyperslab, missing_value, tile_size);
+      case type::Primitive::kUShort:
+        return ReadTiles<unsigned short, T>(hyperslab, missing_value,
+                                            tile_size);
+      case type::Primitive::kInt:
+        return ReadTiles<int, T>(hyperslab, missing_value, tile_size);
+      case type::Primitive::kUInt:
+        return ReadTiles<unsigned int, T>(hyperslab, missing_value, tile_size);
+      case type::Primitive::kFloat:
+        return ReadTiles<float, T>(hyperslab, missing_value, tile_size);
+      case type::Primitive::kDouble:
+        return ReadTiles<double, T>(hyperslab, missing_value, tile_size);
+      default:
+        return ReadMaskAndScale<T>(hyperslab, missing_value);
+    }
+  }
+
+  /**
+   * Read all the data for this Variable as float or double values, mask
+   * data that are considered as missing with the provided value and deflate
+   * read values.
+   *
+   * @param missing_value the value that represents the "missing" value
+   * @return a new container on the data read
+   * @see ReadUnpacked(const Hyperslab&, const T, const size_t)
+   */
+  template <class T>
+  std::valarray<T> ReadUnpacked(
+      const T missing_value = std::numeric_limits<T>::quiet_NaN()) const {
+    return ReadUnpacked<T>(Hyperslab(GetShape()), missing_value);
+  }
+
+  /**
+   * Read the data for this Variable in their storage type and describe the
+   * values that are considered as missing with a validity bitmap instead of
+   * substituting them.
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @param reasons true to store the reason why each value is missing
+   * @return the values read and their validity
+   */
+  template <class T>
+  MaskedArray<T> ReadMasked(const Hyperslab& hyperslab,
+                            const bool reasons = false) const {
+    return MaskedArray<T>(Read<T>(hyperslab), GetScaleMissing(), reasons);
+  }
+
+  /**
+   * Read all the data for this Variable in their storage type and describe
+   * the values that are considered as missing with a validity bitmap.
+   *
+   * @param reasons true to store the reason why each value is missing
+   * @return the values read and their validity
+   */
+  template <class T>
+  MaskedArray<T> ReadMasked(const bool reasons = false) const {
+    return ReadMasked<T>(Hyperslab(GetShape()), reasons);
+  }
+
+  /**
+   * Read the data for this Variable in their storage type. The values are
+   * unpacked on demand by the result.
+   *
+   * @param hyperslab Hyperslabs to be read
+   * @return the packed values and the description of their packing
+   */
+  template <class T>
+  PackedArray<T> ReadPacked(const Hyperslab& hyperslab) const {
+    return PackedArray<T>(Read<T>(hyperslab), GetScaleMissing());
+  }
+
+  /**
+   * Read all the data for this Variable in their storage type. The values
+   * are unpacked on demand by the result.
+   *
+   * @return the packed values and the description of their packing
+   */
+  template <class T>
+  PackedArray<T> ReadPacked() const {
+    return ReadPacked<T>(Hyperslab(GetShape()));
+  }
+
+  /**
+   * Get the description of the packing and of the missing values of this
+   * Variable. The attributes are read on the first call: the description is
+   * then kept by this instance until the attributes are modified through it
+   * or ResetScaleMissing is called.
+   *
+   * @return the description of the packing and of the missing values
+   */
+  const ScaleMissing& GetScaleMissing() const {
+    if (!scale_missing_)
+      scale_missing_ = std::make_shared<const ScaleMissing>(*this);
+    return *scale_missing_;
+  }
+
+  /**
+   * Forget the description of the packing and of the missing values kept by
+   * this instance. Must be called if the attributes have been modified by
+   * another instance.
+   */
+  void ResetScaleMissing() const noexcept { scale_missing_.reset(); }
+
+  /**
+   * Add an attribute to this Variable
+   *
+   * @param name name of the attribute
+   * @return the attribute
+   */
+  Attribute AddAttribute(const std::string& name) const {
+    ResetScaleMissing();
+    return DataSet::AddAttribute(name);
+  }
+
+  /**
+   * Remove an attribute from this Variable
+   *
+   * @param name name of the attribute
+   */
+  void RemoveAttribute(const std::string& name) const {
+    ResetScaleMissing();
+    DataSet::RemoveAttribute(name);
   }
 
   /**
@@ -267,9 +596,9 @@ class Variable : public DataSet {
   template <class T>
   std::valarray<T> ReadMaskAndScale(
       const double missing_value = std::numeric_limits<T>::quiet_NaN()) const {
-    ScaleMissing scale_missing(*this);
     std::valarray<T> values = Read<T>();
-    return scale_missing.MaskAndDeflate(values, missing_value);
+    return GetScaleMissing().MaskAndDeflate(values,
+                                            static_cast<T>(missing_value));
   }
 
   /**
@@ -308,6 +637,63 @@ class Variable : public DataSet {
     }
   }
 
+  /**
+   * Write packed values for this variable.
+   *
+   * If this variable stores the values in the same type, with the same
+   * scale_factor, add_offset, _FillValue, missing_value and valid range, the
+   * packed values are written as is: the values considered as missing are
+   * written as stored. Otherwise the
+   * values are unpacked and packed again with the scale_factor and the
+   * add_offset of this variable, the missing values being replaced by the
+   * fill value of this variable.
+   *
+   * @param hyperslab Hyperslabs to be write
+   * @param values values to write
+   */
+  template <typename T>
+  void Write(const Hyperslab& hyperslab, const PackedArray<T>& values) const {
+    const type::Primitive primitive = GetDataType().GetPrimitive();
+    if (primitive == type::PrimitiveOf<T>::value &&
+        GetScaleMissing().HasSamePacking(values.scale_missing())) {
+      Write(hyperslab, values.raw());
+      return;
+    }
+    const std::valarray<double> unpacked = values.template Unpack<double>();
+    switch (primitive) {
+      case type::Primitive::kByte:
+        return WritePacked<signed char>(hyperslab, unpacked);
+      case type::Primitive::kUByte:
+        return WritePacked<unsigned char>(hyperslab, unpacked);
+      case type::Primitive::kShort:
+        return WritePacked<short>(hyperslab, unpacked);
+      case type::Primitive::kUShort:
+        return WritePacked<unsigned short>(hyperslab, unpacked);
+      case type::Primitive::kInt:
+        return WritePacked<int>(hyperslab, unpacked);
+      case type::Primitive::kUInt:
+        return WritePacked<unsigned int>(hyperslab, unpacked);
+      case type::Primitive::kFloat:
+        return WritePacked<float>(hyperslab, unpacked);
+      case type::Primitive::kDouble:
+        return WritePacked<double>(hyperslab, unpacked);
+      default:
+        throw std::invalid_argument(
+            "packed values can only be written in numeric variables");
+    }
+  }
+
+  /**
+   * Write all packed values for this variable
+   *
+   * @param values values to write
+   * @see Write(const Hyperslab&, const PackedArray<T>&)
+   */
+  template <typename T>
+  void Write(const PackedArray<T>& values) const {
+    Write(Hyperslab(), values);
+  }
+
 #define _NETCDF4CXX_WRITE_VAR(_type)                                         \
   void Write(const Hyperslab& hyperslab, const std::valarray<_type>& values) \
       const;
@@ -360,11 +746,267 @@ class Variable : public DataSet {
     ScaleMissing scale_missing(*this);
     Write<T>(scale_missing.MaskAndInflate(values));
   }
+
+  /**
+   * Quantize the values and write them. The quantization is done by this
+   * library, the netCDF library receiving values already quantized: the
+   * fill value of this variable is left unchanged.
+   *
+   * @param hyperslab Hyperslabs to be write
+   * @param values values to write
+   * @param mode quantization algorithm
+   * @param nsd number of significant digits or bits kept
+   * @throw std::invalid_argument if this variable does not store values of
+   * type T
+   * @see Quantize(float*, size_t, QuantizeMode, int, float)
+   */
+  template <typename T>
+  void QuantizeAndWrite(const Hyperslab& hyperslab,
+                        const std::valarray<T>& values,
+                        const QuantizeMode mode, const int nsd) const {
+    static_assert(std::is_floating_point<T>::value,
+                  "only float or double values can be quantized");
+    // The fill value is read in the type of the variable
+    if (GetDataType().GetPrimitive() != type::PrimitiveOf<T>::value)
+      throw std::invalid_argument(
+          "the values to quantize must have the type of the variable");
+    int no_fill;
+    T fill_value;
+    Check(nc_inq_var_fill(nc_id_, id_, &no_fill, &fill_value));
+    std::valarray<T> quantized(values);
+    if (quantized.size() != 0)
+      Quantize(&quantized[0], quantized.size(), mode, nsd, fill_value);
+    Write(hyperslab, quantized);
+  }
+
+  /**
+   * Pack floating point values into the integers stored by this variable
+   * and write them.
+   *
+   * The range of the values is computed first. The scale_factor and the
+   * add_offset attributes are derived from this range, for the precision
+   * requested, and written. The _FillValue attribute is set to the smallest
+   * integer of the packed type, if not already defined: NaN values are
+   * written with this fill value. An existing _FillValue must already be
+   * this integer, the other ones being used by the values packed. The
+   * values are then packed and written
+   * block by block, each block covering the chunks along the first
+   * dimension.
+   *
+   * @param hyperslab Hyperslabs to be write
+   * @param values values to write
+   * @param precision maximum absolute error allowed, or zero to use the best
+   * precision available
+   * @return the parameters used to pack the values
+   * @throw std::invalid_argument if this variable does not store 8, 16 or 32
+   * bits signed integers, if its fill value is not the smallest integer of
+   * this type, or if the precision can not be reached
+   */
+  template <typename T>
+  Packing PackAndWrite(const Hyperslab& hyperslab,
+                       const std::valarray<T>& values,
+                       const double precision = 0) const {
+    static_assert(std::is_floating_point<T>::value,
+                  "only float or double values can be packed");
+    switch (GetDataType().GetPrimitive()) {
+      case type::Primitive::kByte:
+        return PackTiles<T, signed char>(hyperslab, values, precision);
+      case type::Primitive::kShort:
+        return PackTiles<T, short>(hyperslab, values, precision);
+      case type::Primitive::kInt:
+        return PackTiles<T, int>(hyperslab, values, precision);
+      default:
+        throw std::invalid_argument(
+            "values can only be packed into 8, 16 or 32 bits signed "
+            "integers");
+    }
+  }
+
+  /**
+   * Pack floating point values into the integers stored by this variable
+   * and write all data for this variable
+   *
+   * @param values values to write
+   * @param precision maximum absolute error allowed, or zero to use the best
+   * precision available
+   * @return the parameters used to pack the values
+   * @see PackAndWrite(const Hyperslab&, const std::valarray<T>&, const double)
+   */
+  template <typename T>
+  Packing PackAndWrite(const std::valarray<T>& values,
+                       const double precision = 0) const {
+    return PackAndWrite(Hyperslab(), values, precision);
+  }
+
+ private:
+  // Description of the packing, read on demand
+  mutable std::shared_ptr<const ScaleMissing> scale_missing_;
+
+  // Pack the values with the scale_factor and the add_offset of this
+  // variable, store them as R and write them. NaN values are replaced by the
+  // fill value, the values outside the range of an integer type are clipped.
+  template <typename R>
+  void WritePacked(const Hyperslab& hyperslab,
+                   const std::valarray<double>& values) const {
+    const ScaleMissing& scale_missing = GetScaleMissing();
+    const double scale = scale_missing.get_scale_factor();
+    const double offset = scale_missing.get_add_offset();
+    int no_fill;
+    R fill_value;
+    Check(nc_inq_var_fill(nc_id_, id_, &no_fill, &fill_value));
+
+    const bool integral = std::is_integral<R>::value;
+    const double lower = static_cast<double>(std::numeric_limits<R>::lowest());
+    const double upper = static_cast<double>(std::numeric_limits<R>::max());
+    std::valarray<R> packed(values.size());
+    for (size_t ix = 0; ix < values.size(); ++ix) {
+      const double x = (values[ix] - offset) / scale;
+      if (std::isnan(x))
+        packed[ix] = fill_value;
+      else if (integral)
+        packed[ix] =
+            static_cast<R>(std::min(std::max(std::nearbyint(x), lower), upper));
+      else
+        packed[ix] = static_cast<R>(x);
+    }
+    Write(hyperslab, packed);
+  }
+
+  // Compute the packing of the values, write the attributes describing it
+  // and write the values packed as R, block by block along the first
+  // dimension
+  template <typename T, typename R>
+  Packing PackTiles(const Hyperslab& hyperslab, const std::valarray<T>& values,
+                    const double precision) const {
+    if (hyperslab.IsEmpty() && IsUnlimited())
+      throw std::runtime_error(
+          "You must specify a hyperslab for "
+          "unlimited variables");
+    const Hyperslab target =
+        hyperslab.IsEmpty() ? Hyperslab(GetShape()) : hyperslab;
+    const bool scalar = target.IsEmpty();
+    if (values.size() != (scalar ? 1 : target.GetSize()))
+      throw std::invalid_argument(
+          "data size does not match hyperslab "
+          "definition");
+
+    double min = 0;
+    double max = 0;
+    if (values.size() == 0 ||
+        !Packing::MinMax(&values[0], values.size(), min, max))
+      min = max = 0;
+    const Packing packing =
+        Packing::Compute(min, max, sizeof(R) * 8, precision);
+
+    // The packed values cover all the integers but the smallest one: a fill
+    // value among them would mask valid values when reading
+    int no_fill;
+    R fill_value = std::numeric_limits<R>::min();
+    const bool has_fill_value = GetScaleMissing().has_fill_value();
+    if (has_fill_value) {
+      Check(nc_inq_var_fill(nc_id_, id_, &no_fill, &fill_value));
+      if (fill_value != std::numeric_limits<R>::min())
+        throw std::invalid_argument(
+            "the fill value must be the smallest integer of the packed type");
+    }
+
+    type::Double double_type(*this);
+    AddAttribute(CF::SCALE_FACTOR)
+        .Write(double_type, std::vector<double>{packing.get_scale_factor()});
+    AddAttribute(CF::ADD_OFFSET)
+        .Write(double_type, std::vector<double>{packing.get_add_offset()});
+    if (!has_fill_value)
+      AddAttribute(CF::FILL_VALUE)
+          .Write(GetDataType(), std::vector<R>{fill_value});
+    if (values.size() == 0) return packing;
+
+    if (scalar) {
+      R packed;
+      packing.Pack(&values[0], 1, &packed, fill_value);
+      Check(nc_put_var(nc_id_, id_, &packed));
+      return packing;
+    }
+
+    // The blocks cover the chunks along the first dimension
+    const Range range = target.GetRange(0);
+    const size_t row_size = values.size() / range.GetSize();
+    size_t rows = std::max<size_t>(1, (1 << 16) / row_size);
+    int storage;
+    std::vector<size_t> chunk_sizes(GetShape().size());
+    Check(nc_inq_var_chunking(nc_id_, id_, &storage, &chunk_sizes[0]));
+    if (storage == NC_CHUNKED) {
+      const size_t chunk_rows = std::max<size_t>(
+          1, chunk_sizes[0] / range.step());
+      rows = std::max(chunk_rows, rows / chunk_rows * chunk_rows);
+    }
+    std::vector<R> staging(std::min(rows, range.GetSize()) * row_size);
+
+    std::vector<size_t> start = target.start();
+    std::vector<size_t> count = target.GetSizeList();
+    const bool adjacent = target.OnlyAdjacent();
+    for (size_t ix = 0; ix < range.GetSize(); ix += rows) {
+      start[0] = range.Item(ix);
+      count[0] = std::min(rows, range.GetSize() - ix);
+      packing.Pack(&values[ix * row_size], count[0] * row_size, &staging[0],
+                   fill_value);
+      if (adjacent)
+        Check(nc_put_vara(nc_id_, id_, &start[0], &count[0], &staging[0]));
+      else
+        Check(nc_put_vars(nc_id_, id_, &start[0], &count[0],
+                          &target.step()[0], &staging[0]));
+    }
+    return packing;
+  }
+
+  // Read the values stored as R, tile by tile along the first dimension, and
+  // unpack them as T
+  template <typename R, typename T>
+  std::valarray<T> ReadTiles(const Hyperslab& hyperslab, const T missing_value,
+                             const size_t tile_size) const {
+    if (hyperslab > GetShape())
+      throw std::invalid_argument(
+          "Hyperslab defined overlap the "
+          "variable definition");
+
+    // The values are processed one by one: they are read in increasing
+    // order, then reversed
+    if (hyperslab.IsReversed()) {
+      std::valarray<T> result =
+          ReadTiles<R, T>(hyperslab.Forward(), missing_value, tile_size);
+      if (result.size() != 0) Reverse(hyperslab, &result[0], sizeof(T));
+      return result;
+    }
+
+    const ScaleMissing& scale_missing = GetScaleMissing();
+    std::valarray<T> result(hyperslab.GetSize());
+    if (result.size() == 0) return result;
+
+    const Range range = hyperslab.GetRange(0);
+    const size_t row_size = result.size() / range.GetSize();
+    const size_t rows = std::max<size_t>(1, tile_size / row_size);
+    std::vector<R> staging(std::min(rows, range.GetSize()) * row_size);
+
+    std::vector<size_t> start = hyperslab.start();
+    std::vector<size_t> count = hyperslab.GetSizeList();
+    const bool adjacent = hyperslab.OnlyAdjacent();
+    for (size_t ix = 0; ix < range.GetSize(); ix += rows) {
+      start[0] = range.Item(ix);
+      count[0] = std::min(rows, range.GetSize() - ix);
+      if (adjacent)
+        Check(nc_get_vara(nc_id_, id_, &start[0], &count[0], &staging[0]));
+      else
+        Check(nc_get_vars(nc_id_, id_, &start[0], &count[0],
+                          &hyperslab.step()[0], &staging[0]));
+      scale_missing.MaskAndDeflate(&staging[0], count[0] * row_size,
+                                   &result[ix * row_size], missing_value);
+    }
+    return result;
+  }
 };
 
-#define _NETCDF4CXX_READ_VAR(_type) \
-  template <>                       \
-  std::valarray<_type> Variable::Read(const Hyperslab& hyperslab) const;
+#define _NETCDF4CXX_READ_VAR(_type)                                        \
+  template <>                                                              \
+  void Variable::Read(const Hyperslab& hyperslab, _type* values) const;
 
 _NETCDF4CXX_READ_VAR(signed char)
 _NETCDF4CXX_READ_VAR(unsigned char)
@@ -0,0 +1,183 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <netcdf.h>
+#include <algorithm>
+#include <netcdf4_cxx/aggregation.hpp>
+#include <netcdf4_cxx/group.hpp>
+#include <stdexcept>
+#include <string>
+
+namespace netcdf {
+
+// Read the values of the aggregated dimension held by a file
+static void ReadCoordinate(const Variable& variable, const size_t offset,
+                           const size_t length, double* values) {
+  // The coordinate variable is in the group of the dimension, which can be
+  // a parent group of the variable
+  auto dimension = variable.GetDimensions().front().GetShortName();
+  auto coordinate = Group(variable).FindVariableOrInParent(dimension);
+  if (coordinate != nullptr &&
+      coordinate->GetShape() == std::vector<size_t>{length}) {
+    Check(nc_get_var_double(coordinate->nc_id(), coordinate->id(), values));
+    return;
+  }
+  for (size_t ix = 0; ix < length; ++ix) values[ix] = offset + ix;
+}
+
+AggregatedVariable::AggregatedVariable(std::vector<std::string> paths,
+                                       const std::string& name,
+                                       const Aggregation aggregation,
+                                       const size_t max_open_files)
+    : name_(name),
+      aggregation_(aggregation),
+      members_(),
+      shape_(),
+      coordinate_(),
+      handles_(max_open_files) {
+  if (paths.empty())
+    throw std::invalid_argument("an aggregation needs at least one file");
+
+  std::sort(paths.begin(), paths.end());
+  for (auto& item : paths) {
+    members_.push_back(Member{item, members_.size(), 1});
+  }
+
+  // The files are joined along a new dimension: only the first file is
+  // opened, the others are checked when read
+  if (aggregation_ == Aggregation::kJoinNew) {
+    std::vector<size_t> shape = Open(0).variable->GetShape();
+    shape.insert(shape.begin(), members_.size());
+    coordinate_.resize(members_.size());
+    for (size_t ix = 0; ix < members_.size(); ++ix) coordinate_[ix] = ix;
+    shape_ = std::move(shape);
+    return;
+  }
+
+  // The files are joined along an existing dimension: the length of this
+  // dimension is read from each file
+  std::vector<size_t> shape;
+  std::vector<double> coordinate;
+  size_t offset = 0;
+  for (auto& item : members_) {
+    auto variable = Open(&item - &members_[0]).variable;
+    auto item_shape = variable->GetShape();
+    if (item_shape.empty())
+      throw std::invalid_argument(item.path + ": the variable " + name_ +
+                                  " has no dimension to join");
+    if (shape.empty()) {
+      shape = item_shape;
+    } else if (!std::equal(item_shape.begin() + 1, item_shape.end(),
+                           shape.begin() + 1, shape.end())) {
+      throw std::invalid_argument(item.path + ": the shape of " + name_ +
+                                  " does not match the aggregation");
+    }
+    item.offset = offset;
+    item.length = item_shape[0];
+    offset += item.length;
+
+    coordinate.resize(offset);
+    if (item.length != 0) {
+      ReadCoordinate(*variable, item.offset, item.length,
+                     &coordinate[item.offset]);
+    }
+  }
+  shape[0] = offset;
+  shape_ = std::move(shape);
+  coordinate_ = std::valarray<double>(coordinate.data(), coordinate.size());
+}
+
+AggregatedVariable::Handle AggregatedVariable::Open(
+    const size_t member) const {
+  auto handle = handles_.Find(member);
+  if (handle != nullptr) return *handle;
+
+  const Member& item = members_[member];
+  auto file = std::make_shared<File>(item.path);
+  auto variable = file->FindVariableByPath(name_);
+  if (variable == nullptr)
+    throw std::invalid_argument(item.path + ": variable " + name_ +
+                                " not found");
+
+  // Once the aggregation is built, the shape of the variable read from the
+  // files opened again, or for the first time, is checked
+  if (!shape_.empty()) {
+    auto shape = variable->GetShape();
+    std::vector<size_t> expected(shape_.begin() + 1, shape_.end());
+    if (aggregation_ == Aggregation::kJoinExisting)
+      expected.insert(expected.begin(), item.length);
+    if (shape != expected)
+      throw std::invalid_argument(item.path + ": the shape of " + name_ +
+                                  " does not match the aggregation");
+  }
+  return handles_.Insert(member, Handle{file, variable});
+}
+
+std::vector<AggregatedVariable::Part> AggregatedVariable::Split(
+    const Hyperslab& hyperslab) const {
+  const size_t rank = shape_.size();
+  if (hyperslab.GetRank() != rank)
+    throw std::invalid_argument(
+        "the rank of the Hyperslab does not match the rank of the variable");
+
+  std::vector<Range> ranges = hyperslab.range();
+  for (size_t ix = 0; ix < rank; ++ix) {
+    // The end of a range may be past the last value selected
+    const size_t size = ranges[ix].GetSize();
+    if (size != 0 && ranges[ix][size - 1] >= shape_[ix])
+      throw std::invalid_argument(
+          "Hyperslab defined overlap the "
+          "variable definition");
+  }
+
+  // Number of values read for each element of the aggregated dimension
+  size_t block = 1;
+  for (size_t ix = 1; ix < rank; ++ix) block *= ranges[ix].GetSize();
+
+  std::vector<Part> result;
+  const Range& outer = ranges[0];
+  const size_t count = block == 0 ? 0 : outer.GetSize();
+  const size_t step = outer.step();
+  size_t selected = 0;
+
+  while (selected < count) {
+    // File holding the next element selected
+    const size_t index = outer[selected];
+    auto it = std::upper_bound(
+        members_.begin(), members_.end(), index,
+        [](const size_t lhs, const Member& rhs) { return lhs < rhs.offset; });
+    const Member& item = *(it - 1);
+
+    // Elements selected in this file
+    const size_t first = index - item.offset;
+    const size_t n =
+        std::min(count - selected, (item.length - 1 - first) / step + 1);
+
+    std::vector<Range> local(ranges.begin() + 1, ranges.end());
+    if (aggregation_ == Aggregation::kJoinExisting) {
+      local.insert(local.begin(),
+                   Range(first, first + (n - 1) * step + 1, step));
+    }
+    result.push_back(
+        Part{static_cast<size_t>(&item - &members_[0]), Hyperslab(local),
+             selected * block});
+    selected += n;
+  }
+  return result;
+}
+
+}  // namespace netcdf
@@ -0,0 +1,503 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <limits>
+#include <netcdf4_cxx/classic.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "simd.hpp"
+
+namespace netcdf {
+namespace classic {
+
+// Tags of the lists of the header
+static const uint32_t kAbsent = 0x00;
+static const uint32_t kDimension = 0x0A;
+static const uint32_t kVariable = 0x0B;
+static const uint32_t kAttribute = 0x0C;
+
+namespace {
+
+// Raised when the header extends past the bytes available
+struct Truncated {};
+
+// Decode the big-endian fields of a header
+class Cursor {
+ private:
+  const unsigned char* begin_;
+  const unsigned char* ptr_;
+  const unsigned char* end_;
+  Version version_;
+
+ public:
+  Cursor(const unsigned char* data, const size_t size)
+      : begin_(data), ptr_(data), end_(data + size), version_() {}
+
+  void set_version(const Version version) noexcept { version_ = version; }
+
+  size_t position() const noexcept { return ptr_ - begin_; }
+
+  void Require(const uint64_t size) const {
+    if (size > static_cast<uint64_t>(end_ - ptr_)) throw Truncated();
+  }
+
+  uint32_t ReadUInt32() {
+    Require(4);
+    uint32_t result = (static_cast<uint32_t>(ptr_[0]) << 24) |
+                      (static_cast<uint32_t>(ptr_[1]) << 16) |
+                      (static_cast<uint32_t>(ptr_[2]) << 8) |
+                      static_cast<uint32_t>(ptr_[3]);
+    ptr_ += 4;
+    return result;
+  }
+
+  uint64_t ReadUInt64() {
+    uint64_t high = ReadUInt32();
+    return (high << 32) | ReadUInt32();
+  }
+
+  // Sizes and counts are stored on 64 bits by CDF-5 only
+  uint64_t ReadSize() {
+    return version_ == Version::k64BitData ? ReadUInt64() : ReadUInt32();
+  }
+
+  // Offsets are stored on 64 bits, except by CDF-1
+  uint64_t ReadOffset() {
+    return version_ == Version::kClassic ? ReadUInt32() : ReadUInt64();
+  }
+
+  // Read bytes padded to a multiple of four
+  std::string ReadBytes(const uint64_t size) {
+    Require(size);
+    const uint64_t padded = (size + 3) & ~static_cast<uint64_t>(3);
+    Require(padded);
+    std::string result(reinterpret_cast<const char*>(ptr_), size);
+    ptr_ += padded;
+    return result;
+  }
+
+  std::string ReadName() { return ReadBytes(ReadSize()); }
+};
+
+}  // namespace
+
+// Decode the header of a list and return its number of elements
+static uint64_t ReadList(Cursor& cursor, const uint32_t tag) {
+  uint32_t item = cursor.ReadUInt32();
+  uint64_t size = cursor.ReadSize();
+  if (item == kAbsent && size == 0) return 0;
+  if (item != tag)
+    throw std::runtime_error("invalid netCDF header: unexpected list tag");
+  return size;
+}
+
+static type::Primitive ReadType(Cursor& cursor, const Version version) {
+  uint32_t result = cursor.ReadUInt32();
+  uint32_t last = version == Version::k64BitData ? NC_UINT64 : NC_DOUBLE;
+  if (result < NC_BYTE || result > last)
+    throw std::runtime_error("invalid netCDF header: unknown type " +
+                             std::to_string(result));
+  return static_cast<type::Primitive>(result);
+}
+
+static std::vector<AttributeInfo> ReadAttributes(Cursor& cursor,
+                                                 const Version version) {
+  // The number of elements is not trusted to size the containers: a corrupt
+  // header would allocate memory until the cursor reaches the end
+  std::vector<AttributeInfo> result;
+  for (uint64_t remaining = ReadList(cursor, kAttribute); remaining != 0;
+       --remaining) {
+    AttributeInfo item;
+    item.name = cursor.ReadName();
+    item.type = ReadType(cursor, version);
+    item.length = cursor.ReadSize();
+    size_t size = SizeOf(item.type);
+    if (item.length > std::numeric_limits<uint64_t>::max() / size)
+      throw std::runtime_error("invalid netCDF header: attribute too large");
+    item.value = cursor.ReadBytes(item.length * size);
+    result.push_back(std::move(item));
+  }
+  return result;
+}
+
+// Multiply two sizes decoded from a header, rejecting the products that do
+// not fit on 64 bits
+static uint64_t Multiply(const uint64_t lhs, const uint64_t rhs,
+                         const std::string& name) {
+  if (rhs != 0 && lhs > std::numeric_limits<uint64_t>::max() / rhs)
+    throw std::runtime_error("invalid netCDF header: variable " + name +
+                             " too large");
+  return lhs * rhs;
+}
+
+// Number of bytes of a variable, or of one record of a record variable
+static uint64_t Extent(const VariableInfo& variable) {
+  uint64_t result = SizeOf(variable.type);
+  for (size_t ix = variable.record ? 1 : 0; ix < variable.shape.size();
+       ++ix) {
+    result = Multiply(result, variable.shape[ix], variable.name);
+  }
+  return result;
+}
+
+size_t SizeOf(const type::Primitive type) {
+  switch (type) {
+    case type::Primitive::kByte:
+    case type::Primitive::kChar:
+    case type::Primitive::kUByte:
+      return 1;
+    case type::Primitive::kShort:
+    case type::Primitive::kUShort:
+      return 2;
+    case type::Primitive::kInt:
+    case type::Primitive::kUInt:
+    case type::Primitive::kFloat:
+      return 4;
+    case type::Primitive::kDouble:
+    case type::Primitive::kInt64:
+    case type::Primitive::kUInt64:
+      return 8;
+    default:
+      throw std::invalid_argument("type not supported by the classic format");
+  }
+}
+
+Header::Header(const void* data, const size_t size, const uint64_t file_size) {
+  if (Parse(data, size, *this, file_size) == 0)
+    throw std::runtime_error("the netCDF header is truncated");
+}
+
+size_t Header::Parse(const void* data, const size_t size, Header& header,
+                     const uint64_t file_size) {
+  auto bytes = static_cast<const unsigned char*>(data);
+  Cursor cursor(bytes, size);
+
+  try {
+    cursor.Require(4);
+    if (memcmp(bytes, "CDF", 3) != 0)
+      throw std::runtime_error("not a netCDF classic file");
+    switch (bytes[3]) {
+      case 1:
+      case 2:
+      case 5:
+        header.version_ = static_cast<Version>(bytes[3]);
+        break;
+      default:
+        throw std::runtime_error("unknown netCDF classic format version " +
+                                 std::to_string(bytes[3]));
+    }
+    cursor.ReadUInt32();
+    cursor.set_version(header.version_);
+
+    // A file written in streaming mode does not record the number of
+    // records
+    uint64_t records = cursor.ReadSize();
+    bool streaming = header.version_ == Version::k64BitData
+                         ? records == std::numeric_limits<uint64_t>::max()
+                         : records == std::numeric_limits<uint32_t>::max();
+
+    header.dimensions_.clear();
+    for (uint64_t remaining = ReadList(cursor, kDimension); remaining != 0;
+         --remaining) {
+      DimensionInfo item;
+      item.name = cursor.ReadName();
+      item.length = cursor.ReadSize();
+      header.dimensions_.push_back(std::move(item));
+    }
+
+    header.attributes_ = ReadAttributes(cursor, header.version_);
+
+    header.variables_.clear();
+    for (uint64_t remaining = ReadList(cursor, kVariable); remaining != 0;
+         --remaining) {
+      VariableInfo item;
+      item.name = cursor.ReadName();
+      uint64_t ndims = cursor.ReadSize();
+      for (uint64_t ix = 0; ix < ndims; ++ix) {
+        uint64_t id = cursor.ReadSize();
+        if (id >= header.dimensions_.size())
+          throw std::runtime_error("invalid netCDF header: variable " +
+                                   item.name + " uses an unknown dimension");
+        // Only the first dimension can be the record dimension
+        if (header.dimensions_[id].length == 0 && ix != 0)
+          throw std::runtime_error("invalid netCDF header: variable " +
+                                   item.name +
+                                   " uses the record dimension");
+        item.dimensions.push_back(id);
+        item.shape.push_back(header.dimensions_[id].length);
+      }
+      item.attributes = ReadAttributes(cursor, header.version_);
+      item.type = ReadType(cursor, header.version_);
+      // The size stored is not reliable for the variables larger than 4 GiB
+      // and is computed from the shape
+      cursor.ReadSize();
+      item.begin = cursor.ReadOffset();
+      item.record = !item.shape.empty() && item.shape[0] == 0;
+      // Rejects the variables whose size does not fit on 64 bits
+      Extent(item);
+      header.variables_.push_back(std::move(item));
+    }
+
+    // Records hold the values of each record variable, each padded to four
+    // bytes, unless there is only one record variable
+    uint64_t record_size = 0;
+    uint64_t last_size = 0;
+    uint64_t first_record = std::numeric_limits<uint64_t>::max();
+    size_t record_variables = 0;
+    for (auto& item : header.variables_) {
+      if (!item.record) continue;
+      uint64_t extent = Extent(item);
+      uint64_t padded = (extent + 3) & ~static_cast<uint64_t>(3);
+      if (padded < extent ||
+          record_size > std::numeric_limits<uint64_t>::max() - padded)
+        throw std::runtime_error("invalid netCDF header: records too large");
+      record_size += padded;
+      last_size = extent;
+      first_record = std::min(first_record, item.begin);
+      ++record_variables;
+    }
+    header.record_size_ = record_variables == 1 ? last_size : record_size;
+
+    if (streaming) {
+      records = 0;
+      if (file_size > first_record && header.record_size_ != 0)
+        records = (file_size - first_record) / header.record_size_;
+    }
+    header.records_ = records;
+    for (auto& item : header.variables_) {
+      if (item.record) item.shape[0] = records;
+    }
+  } catch (Truncated&) {
+    return 0;
+  }
+  header.size_ = cursor.position();
+  return cursor.position();
+}
+
+namespace {
+
+// Close a file descriptor when leaving the scope
+class Descriptor {
+ private:
+  int fd_;
+
+ public:
+  explicit Descriptor(const int fd) noexcept : fd_(fd) {}
+  ~Descriptor() {
+    if (fd_ != -1) close(fd_);
+  }
+  Descriptor(const Descriptor&) = delete;
+  Descriptor& operator=(const Descriptor&) = delete;
+  int fd() const noexcept { return fd_; }
+};
+
+}  // namespace
+
+// Read bytes at the given offset until the count is reached
+static void ReadAt(const int fd, unsigned char* buffer, size_t count,
+                   off_t offset, const std::string& path) {
+  while (count != 0) {
+    ssize_t read = pread(fd, buffer, count, offset);
+    if (read == -1 && errno == EINTR) continue;
+    if (read == -1) throw std::runtime_error(path + ": " + strerror(errno));
+    if (read == 0) throw std::runtime_error(path + ": unexpected end of file");
+    buffer += read;
+    count -= read;
+    offset += read;
+  }
+}
+
+Header Header::Scan(const std::string& path, size_t read_size) {
+  Descriptor file(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  if (file.fd() == -1) throw std::runtime_error(path + ": " + strerror(errno));
+
+  struct stat st;
+  if (fstat(file.fd(), &st) == -1)
+    throw std::runtime_error(path + ": " + strerror(errno));
+  const size_t file_size = static_cast<size_t>(st.st_size);
+
+  Header result;
+  std::vector<unsigned char> buffer;
+  read_size = std::max<size_t>(read_size, 4);
+  while (true) {
+    size_t size = std::min(read_size, file_size);
+    size_t available = buffer.size();
+    buffer.resize(size);
+    ReadAt(file.fd(), buffer.data() + available, size - available,
+           static_cast<off_t>(available), path);
+    if (Parse(buffer.data(), size, result, file_size) != 0) return result;
+    if (size == file_size)
+      throw std::runtime_error(path + ": the netCDF header is truncated");
+    read_size = size * 4;
+  }
+}
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Reverse the bytes of the values by vector of 32 bytes. Returns the number
+// of values processed.
+__attribute__((target("avx2"))) static size_t ByteSwapAvx2(
+    const unsigned char* in, unsigned char* out, const size_t count,
+    const size_t width) {
+  __m256i mask;
+  switch (width) {
+    case 2:
+      mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15,
+                              14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12,
+                              15, 14);
+      break;
+    case 4:
+      mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13,
+                              12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14,
+                              13, 12);
+      break;
+    default:
+      mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9,
+                              8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11,
+                              10, 9, 8);
+      break;
+  }
+  const size_t bytes = count * width;
+  size_t ix = 0;
+  for (; ix + 32 <= bytes; ix += 32) {
+    __m256i values =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + ix));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + ix),
+                        _mm256_shuffle_epi8(values, mask));
+  }
+  return ix / width;
+}
+#endif
+
+template <size_t Width>
+static void ByteSwapScalar(const unsigned char* in, unsigned char* out,
+                           const size_t count) {
+  unsigned char value[Width];
+  for (size_t ix = 0; ix < count; ++ix, in += Width, out += Width) {
+    for (size_t jx = 0; jx < Width; ++jx) value[jx] = in[Width - 1 - jx];
+    memcpy(out, value, Width);
+  }
+}
+
+void ByteSwap(const void* in, void* out, const size_t count,
+              const size_t width) {
+  auto src = static_cast<const unsigned char*>(in);
+  auto dst = static_cast<unsigned char*>(out);
+
+  if (width != 1 && width != 2 && width != 4 && width != 8)
+    throw std::invalid_argument("the size of the values must be 1, 2, 4 or 8");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  if (src != dst) memcpy(dst, src, count * width);
+  return;
+#endif
+  if (width == 1) {
+    if (src != dst) memcpy(dst, src, count);
+    return;
+  }
+
+  size_t processed = 0;
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2) processed = ByteSwapAvx2(src, dst, count, width);
+#endif
+  src += processed * width;
+  dst += processed * width;
+  switch (width) {
+    case 2:
+      ByteSwapScalar<2>(src, dst, count - processed);
+      break;
+    case 4:
+      ByteSwapScalar<4>(src, dst, count - processed);
+      break;
+    default:
+      ByteSwapScalar<8>(src, dst, count - processed);
+      break;
+  }
+}
+
+MappedFile::MappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1) throw std::runtime_error(path + ": " + strerror(errno));
+
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    int error = errno;
+    close(fd);
+    throw std::runtime_error(path + ": " + strerror(error));
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    throw std::runtime_error(path + ": the file is empty");
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  int error = errno;
+  // The mapping remains valid once the file descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED)
+    throw std::runtime_error(path + ": " + strerror(error));
+  data_ = static_cast<const unsigned char*>(data);
+  size_ = static_cast<size_t>(st.st_size);
+}
+
+MappedFile::~MappedFile() noexcept {
+  if (data_ != nullptr) munmap(const_cast<unsigned char*>(data_), size_);
+}
+
+Reader::Reader(const std::string& path)
+    : file_(path), header_(file_.data(), file_.size(), file_.size()) {}
+
+const VariableInfo& Reader::GetVariable(const std::string& name,
+                                        const type::Primitive type) const {
+  auto result = header_.FindVariable(name);
+  if (result == nullptr)
+    throw std::invalid_argument("variable not found: " + name);
+  if (result->type != type)
+    throw std::invalid_argument("the type requested does not match the type "
+                                "of the variable " +
+                                name);
+  return *result;
+}
+
+void Reader::Locate(const VariableInfo& variable, size_t& block,
+                    size_t& blocks, size_t& stride) const {
+  const size_t size = SizeOf(variable.type);
+  const uint64_t extent = Extent(variable);
+  block = extent / size;
+  blocks = variable.record ? header_.records() : 1;
+  stride = variable.record ? header_.record_size() : extent;
+  if (blocks == 0) return;
+
+  // The last block must lie within the file. The number of records comes
+  // from the header: the offset of the last block may not fit on 64 bits.
+  const uint64_t last = Multiply(blocks - 1, stride, variable.name);
+  if (variable.begin > file_.size() ||
+      last > file_.size() - variable.begin ||
+      extent > file_.size() - variable.begin - last)
+    throw std::runtime_error("the values of the variable " + variable.name +
+                             " are past the end of the file");
+}
+
+}  // namespace classic
+}  // namespace netcdf
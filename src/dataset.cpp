@@ -31,14 +31,7 @@ static std::string to_lower_copy(const std::string& s) {
 }
 
 std::list<Attribute> DataSet::GetAttributes() const {
-  int natts;
-
-  if (id_ == NC_GLOBAL) {
-    Check(nc_inq_natts(nc_id_, &natts));
-  } else {
-    Check(nc_inq_varnatts(nc_id_, id_, &natts));
-  }
-
+  int natts = GetNumberOfAttributes();
   std::list<Attribute> result;
   char name[NC_MAX_NAME + 1];
 
@@ -54,12 +47,13 @@ std::shared_ptr<Attribute> DataSet::FindAttribute(const std::string& name,
   // Search an attribute by its name, if ignore case
   if (ignore_case) {
     auto lower_name = to_lower_copy(name);
-    auto attributes = GetAttributes();
-    auto it = std::find_if(
-        attributes.begin(), attributes.end(), [&](const Attribute& attribute) {
-          return to_lower_copy(attribute.name()) == lower_name;
-        });
-    if (it != attributes.end()) return std::make_shared<Attribute>(*it);
+    std::shared_ptr<Attribute> result(nullptr);
+    VisitAttributes([&](const Attribute& attribute) {
+      if (to_lower_copy(attribute.name()) != lower_name) return true;
+      result = std::make_shared<Attribute>(attribute);
+      return false;
+    });
+    return result;
   } else {
     // Query the C-API to get the attribute by its name
     int id;
@@ -14,10 +14,26 @@
    along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <netcdf_mem.h>
 #include <netcdf4_cxx/file.hpp>
 
 namespace netcdf {
 
+// Get the creation mode flags selecting a binary format
+static int FormatMode(const Format format) {
+  switch (format) {
+    case Format::kNetCdf4:
+      return NC_NETCDF4;
+    case Format::kClassicNetCdf4:
+      return NC_NETCDF4 | NC_CLASSIC_MODEL;
+    case Format::kClassicNetCdf3:
+      return 0;
+    case Format::k64BitsNetCdf3:
+      return NC_64BIT_OFFSET;
+  }
+  throw std::invalid_argument("unknown file format");
+}
+
 void File::Open(const std::string& filename, const std::string& mode,
                 bool clobber, const bool diskless, const bool persist,
                 const Format format) {
@@ -62,6 +78,44 @@ void File::Open(const std::string& filename, const std::string& mode,
   nc_id_ = ident;
 }
 
+void File::OpenMemory(const void* data, const size_t size,
+                      const std::string& name) {
+  int ident;
+
+  nc_close(nc_id_);
+  // The library does not modify the buffer of a file opened read-only
+  Check(nc_open_mem(name.c_str(), NC_NOWRITE, size, const_cast<void*>(data),
+                    &ident));
+  nc_id_ = ident;
+}
+
+void File::CreateInMemory(const Format format, const size_t initial_size,
+                          const std::string& name) {
+#ifdef NC_MEMIO_LOCKED
+  int ident;
+
+  nc_close(nc_id_);
+  Check(nc_create_mem(name.c_str(), FormatMode(format), initial_size, &ident));
+  nc_id_ = ident;
+#else
+  throw std::runtime_error(
+      "the netCDF library does not support the creation of files in memory");
+#endif
+}
+
+MemoryImage File::CloseToBuffer() {
+#ifdef NC_MEMIO_LOCKED
+  NC_memio info{0, nullptr, 0};
+
+  Check(nc_close_memio(nc_id_, &info));
+  nc_id_ = 0;
+  return MemoryImage(info.memory, info.size);
+#else
+  throw std::runtime_error(
+      "the netCDF library does not support the creation of files in memory");
+#endif
+}
+
 void File::SetRedefineMode(bool redefine_mode) const {
   if (redefine_mode) {
     int status = nc_redef(nc_id_);
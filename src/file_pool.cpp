@@ -0,0 +1,149 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <sys/stat.h>
+#include <netcdf4_cxx/file_pool.hpp>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace netcdf {
+
+// Key of a file in the pool
+static std::string Key(const std::string& path, const std::string& mode) {
+  return mode + ':' + path;
+}
+
+bool FilePool::GetStamp(const std::string& path, Stamp& stamp) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) return false;
+  // A file rewritten within a second is detected by the nanoseconds
+#ifdef __APPLE__
+  const struct timespec& mtime = info.st_mtimespec;
+#else
+  const struct timespec& mtime = info.st_mtim;
+#endif
+  stamp.mtime = static_cast<int64_t>(mtime.tv_sec) * 1000000000 +
+                static_cast<int64_t>(mtime.tv_nsec);
+  stamp.size = static_cast<int64_t>(info.st_size);
+  stamp.inode = static_cast<uint64_t>(info.st_ino);
+  return true;
+}
+
+FilePool& FilePool::Instance() {
+  static FilePool pool;
+  return pool;
+}
+
+void FilePool::Shrink(const size_t size, Released& released) {
+  Entry entry;
+  while (entries_.size() > size && entries_.Evict(entry)) {
+    released.push_back(std::move(entry.file));
+  }
+}
+
+std::shared_ptr<File> FilePool::Open(const std::string& path,
+                                     const std::string& mode) {
+  if (mode.empty() || mode[0] == 'w')
+    throw std::invalid_argument("a file created cannot be pooled");
+
+  // Declared before the lock: the files released are closed after the lock
+  // is released
+  Released released;
+  std::unique_lock<std::mutex> lock(mutex_);
+  const std::string key = Key(path, mode);
+  Stamp stamp{};
+  auto entry = entries_.Find(key);
+
+  // A file open for writing is modified through its handle: only the files
+  // open read-only are checked against their content on disk
+  if (entry != nullptr) {
+    if (mode != "r") return entry->file;
+    if (GetStamp(path, stamp) && stamp.mtime == entry->stamp.mtime &&
+        stamp.size == entry->stamp.size && stamp.inode == entry->stamp.inode)
+      return entry->file;
+    released.push_back(std::move(entry->file));
+    entries_.Erase(key);
+  } else {
+    GetStamp(path, stamp);
+  }
+
+  // Another thread is opening the file
+  auto it = pending_.find(key);
+  if (it != pending_.end()) {
+    auto future = it->second;
+    lock.unlock();
+    return future.get();
+  }
+
+  std::promise<std::shared_ptr<File>> promise;
+  pending_.emplace(key, promise.get_future().share());
+  lock.unlock();
+
+  std::shared_ptr<File> file;
+  try {
+    file = std::make_shared<File>(path, mode);
+  } catch (...) {
+    lock.lock();
+    pending_.erase(key);
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+
+  // The entry is checked again before the insertion: an entry replaced must
+  // be closed outside of the lock
+  lock.lock();
+  pending_.erase(key);
+  entry = entries_.Find(key);
+  if (entry != nullptr) {
+    released.push_back(std::move(entry->file));
+    entries_.Erase(key);
+  }
+  Shrink(entries_.capacity() - 1, released);
+  entries_.Insert(key, Entry{file, stamp});
+  lock.unlock();
+  promise.set_value(file);
+  return file;
+}
+
+bool FilePool::Erase(const std::string& path, const std::string& mode) {
+  const std::string key = Key(path, mode);
+  Released released;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto entry = entries_.Find(key);
+  if (entry == nullptr) return false;
+  released.push_back(std::move(entry->file));
+  return entries_.Erase(key);
+}
+
+void FilePool::Clear() {
+  Released released;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Shrink(0, released);
+}
+
+void FilePool::SetCapacity(const size_t capacity) {
+  if (capacity == 0)
+    throw std::invalid_argument("the capacity of the pool must be > 0");
+  Released released;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Shrink(capacity, released);
+  entries_.SetCapacity(capacity);
+}
+
+}  // namespace netcdf
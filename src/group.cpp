@@ -189,6 +189,23 @@ std::shared_ptr<Variable> Group::FindVariableOrInParent(
   return result;
 }
 
+std::shared_ptr<Variable> Group::FindVariableByPath(
+    const std::string& path) const {
+  if (path.empty()) return std::shared_ptr<Variable>(nullptr);
+  auto split = SplitGroupsAndVariable(path);
+  if (split.second.empty()) return std::shared_ptr<Variable>(nullptr);
+
+  Group group = path.front() == '/' ? GetRootGroup() : *this;
+  for (auto& item : split.first) {
+    int nc_id;
+    if (item.empty()) continue;
+    if (nc_inq_grp_ncid(group.nc_id(), item.c_str(), &nc_id) != NC_NOERR)
+      return std::shared_ptr<Variable>(nullptr);
+    group = Group(nc_id);
+  }
+  return group.FindVariable(split.second);
+}
+
 std::list<Group> Group::Walk() const {
   std::list<Group> result, groups = GetGroups();
   for (auto& item : groups) {
@@ -199,6 +216,56 @@ std::list<Group> Group::Walk() const {
   return result;
 }
 
+GroupTreeIterator::GroupTreeIterator(const Group& root,
+                                     const TraversalOrder order)
+    : order_(order) {
+  frames_.reserve(8);
+  ids_.reserve(32);
+  Push(root.nc_id());
+  Next();
+}
+
+void GroupTreeIterator::Push(const int nc_id) {
+  int num_groups;
+  Check(nc_inq_grps(nc_id, &num_groups, nullptr));
+
+  size_t first = ids_.size();
+  ids_.resize(first + num_groups);
+  if (num_groups != 0) Check(nc_inq_grps(nc_id, nullptr, &ids_[first]));
+  frames_.push_back(
+      Frame{nc_id, first, static_cast<size_t>(num_groups), 0});
+}
+
+void GroupTreeIterator::Next() {
+  while (!frames_.empty()) {
+    Frame& frame = frames_.back();
+    if (frame.next < frame.count) {
+      int nc_id = ids_[frame.first + frame.next++];
+      if (order_ == TraversalOrder::kPreOrder) {
+        current_ = Group(nc_id);
+        return;
+      }
+      // In post-order, go down to the deepest group first
+      Push(nc_id);
+      continue;
+    }
+    int nc_id = frame.nc_id;
+    Pop();
+    // The traversed group itself is not part of the range
+    if (order_ == TraversalOrder::kPostOrder && !frames_.empty()) {
+      current_ = Group(nc_id);
+      return;
+    }
+  }
+}
+
+GroupTreeIterator& GroupTreeIterator::operator++() {
+  if (order_ == TraversalOrder::kPreOrder && !prune_) Push(current_.nc_id());
+  prune_ = false;
+  Next();
+  return *this;
+}
+
 std::shared_ptr<type::Generic> Group::FindDataType(
     const std::string& name) const {
   std::shared_ptr<type::Generic> result(nullptr);
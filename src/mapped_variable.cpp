@@ -0,0 +1,249 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <netcdf.h>
+#include <stdint.h>
+#include <string.h>
+#include <netcdf4_cxx/mapped_variable.hpp>
+#include <netcdf4_cxx/selection.hpp>
+#include <stdexcept>
+#include <string>
+#ifdef NETCDF4_CXX_HAVE_HDF5
+#include <hdf5.h>
+#endif
+
+namespace netcdf {
+
+#ifdef NETCDF4_CXX_HAVE_HDF5
+
+namespace {
+
+// Close an HDF5 object when leaving the scope
+class Handle {
+ private:
+  hid_t id_;
+  herr_t (*close_)(hid_t);
+
+ public:
+  Handle(const hid_t id, herr_t (*close)(hid_t)) : id_(id), close_(close) {}
+  ~Handle() {
+    if (id_ >= 0) close_(id_);
+  }
+  Handle(const Handle&) = delete;
+  Handle& operator=(const Handle&) = delete;
+  hid_t id() const noexcept { return id_; }
+  bool IsValid() const noexcept { return id_ >= 0; }
+};
+
+}  // namespace
+
+// Get the offset in the file of the values of a variable stored
+// contiguously, without filter, in the native byte order. Returns false if
+// the variable is not stored so.
+static bool LocateStorage(const std::string& path, const std::string& name,
+                          const uint64_t size, const size_t element_size,
+                          uint64_t& offset) {
+  // The file is already open by the netCDF library, with the default close
+  // degree of the HDF5 library
+  Handle fapl(H5Pcreate(H5P_FILE_ACCESS), H5Pclose);
+  if (!fapl.IsValid() || H5Pset_fclose_degree(fapl.id(), H5F_CLOSE_WEAK) < 0)
+    return false;
+  Handle file(H5Fopen(path.c_str(), H5F_ACC_RDONLY, fapl.id()), H5Fclose);
+  if (!file.IsValid()) return false;
+
+  // A variable sharing the name of a dimension without being its coordinate
+  // is renamed by the netCDF library
+  std::string dataset_name = name;
+  if (H5Lexists(file.id(), dataset_name.c_str(), H5P_DEFAULT) <= 0) {
+    auto ix = name.rfind('/');
+    dataset_name =
+        name.substr(0, ix + 1) + "_nc4_non_coord_" + name.substr(ix + 1);
+    if (H5Lexists(file.id(), dataset_name.c_str(), H5P_DEFAULT) <= 0)
+      return false;
+  }
+
+  Handle dataset(H5Dopen2(file.id(), dataset_name.c_str(), H5P_DEFAULT),
+                 H5Dclose);
+  if (!dataset.IsValid()) return false;
+
+  Handle dcpl(H5Dget_create_plist(dataset.id()), H5Pclose);
+  if (!dcpl.IsValid() || H5Pget_layout(dcpl.id()) != H5D_CONTIGUOUS ||
+      H5Pget_nfilters(dcpl.id()) != 0 ||
+      H5Pget_external_count(dcpl.id()) != 0)
+    return false;
+
+  Handle type(H5Dget_type(dataset.id()), H5Tclose);
+  if (!type.IsValid() || H5Tget_size(type.id()) != element_size ||
+      H5Tget_order(type.id()) != H5Tget_order(H5T_NATIVE_INT))
+    return false;
+
+  // The storage is allocated when the first value is written
+  haddr_t address = H5Dget_offset(dataset.id());
+  if (address == HADDR_UNDEF || H5Dget_storage_size(dataset.id()) != size)
+    return false;
+
+  // The address is an offset from the beginning of the file, user block
+  // included
+  offset = address;
+  return true;
+}
+
+#endif
+
+MappedVariable::MappedVariable(const Variable& variable)
+    : variable_(variable), shape_(variable.GetShape()) {
+#ifdef NETCDF4_CXX_HAVE_HDF5
+  // Only the files opened read-only, on disk, can be mapped: otherwise, the
+  // file may not hold the last values written
+  int format, mode;
+  Check(nc_inq_format_extended(variable.nc_id(), &format, &mode));
+  if (format != NC_FORMATX_NC4) return;
+  if (mode & (NC_WRITE | NC_DISKLESS | NC_INMEMORY)) return;
+
+  nc_type xtype;
+  Check(nc_inq_vartype(variable.nc_id(), variable.id(), &xtype));
+  if (xtype < NC_BYTE || xtype > NC_UINT64) return;
+
+  int storage;
+  Check(nc_inq_var_chunking(variable.nc_id(), variable.id(), &storage,
+                            nullptr));
+  if (storage != NC_CONTIGUOUS) return;
+
+  element_size_ = classic::SizeOf(static_cast<type::Primitive>(xtype));
+  uint64_t size = element_size_;
+  for (auto& item : shape_) size *= item;
+  if (size == 0) return;
+
+  size_t length;
+  Check(nc_inq_path(variable.nc_id(), &length, nullptr));
+  std::string path(length, '\0');
+  Check(nc_inq_path(variable.nc_id(), nullptr, &path[0]));
+
+  Check(nc_inq_grpname_full(variable.nc_id(), &length, nullptr));
+  std::string name(length, '\0');
+  Check(nc_inq_grpname_full(variable.nc_id(), nullptr, &name[0]));
+  if (name.back() != '/') name += '/';
+  name += variable.GetShortName();
+
+  // The HDF5 error stack is not printed: a failure only means that the
+  // variable is read with the netCDF library
+  uint64_t offset;
+  bool located = false;
+  H5E_BEGIN_TRY {
+    located = LocateStorage(path, name, size, element_size_, offset);
+  }
+  H5E_END_TRY;
+  if (!located) return;
+
+  try {
+    file_ = std::make_shared<classic::MappedFile>(path);
+  } catch (std::runtime_error&) {
+    return;
+  }
+  if (offset + size > file_->size()) {
+    file_.reset();
+    return;
+  }
+  data_ = file_->data() + offset;
+#endif
+}
+
+// Copy the values selected by a range of the last dimension
+template <typename T>
+static void Gather(const unsigned char* src, const Range& range,
+                   const size_t count, unsigned char* dst) {
+  for (size_t ix = 0; ix < count; ++ix) {
+    memcpy(dst + ix * sizeof(T), src + range[ix] * sizeof(T), sizeof(T));
+  }
+}
+
+void MappedVariable::Copy(const Hyperslab& hyperslab, void* out) const {
+  const size_t rank = shape_.size();
+  if (rank == 0) return;
+  if (hyperslab.IsReversed()) {
+    Copy(hyperslab.Forward(), out);
+    Reverse(hyperslab, out, element_size_);
+    return;
+  }
+  if (hyperslab.GetRank() != rank)
+    throw std::invalid_argument(
+        "the rank of the Hyperslab does not match the rank of the variable");
+
+  std::vector<Range> ranges = hyperslab.range();
+  bool empty = false;
+  for (size_t ix = 0; ix < rank; ++ix) {
+    // The end of a range may be past the last value selected
+    const size_t size = ranges[ix].GetSize();
+    if (size != 0 && ranges[ix][size - 1] >= shape_[ix])
+      throw std::invalid_argument(
+          "Hyperslab defined overlap the "
+          "variable definition");
+    empty |= size == 0;
+  }
+  if (empty) return;
+
+  // Number of bytes between two consecutive values of each dimension
+  std::vector<size_t> strides(rank);
+  size_t stride = element_size_;
+  for (size_t ix = rank; ix-- > 0;) {
+    strides[ix] = stride;
+    stride *= shape_[ix];
+  }
+
+  // The values of the last dimension are copied by runs
+  const Range& last = ranges.back();
+  const size_t count = last.GetSize();
+  const size_t run = count * element_size_;
+  auto dst = static_cast<unsigned char*>(out);
+  std::vector<size_t> index(rank, 0);
+
+  while (true) {
+    const unsigned char* src = data_;
+    for (size_t ix = 0; ix < rank - 1; ++ix) {
+      src += ranges[ix][index[ix]] * strides[ix];
+    }
+    if (last.OnlyAdjacent()) {
+      memcpy(dst, src + last.First() * element_size_, run);
+    } else {
+      switch (element_size_) {
+        case 1:
+          Gather<uint8_t>(src, last, count, dst);
+          break;
+        case 2:
+          Gather<uint16_t>(src, last, count, dst);
+          break;
+        case 4:
+          Gather<uint32_t>(src, last, count, dst);
+          break;
+        default:
+          Gather<uint64_t>(src, last, count, dst);
+          break;
+      }
+    }
+    dst += run;
+
+    // Move to the next run, the last dimension varying fastest
+    size_t dim = rank - 1;
+    while (true) {
+      if (dim == 0) return;
+      --dim;
+      if (++index[dim] < ranges[dim].GetSize()) break;
+      index[dim] = 0;
+    }
+  }
+}
+
+}  // namespace netcdf
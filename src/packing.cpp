@@ -0,0 +1,136 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <netcdf4_cxx/packing.hpp>
+#include <stdexcept>
+#include <string>
+#include "simd.hpp"
+
+namespace netcdf {
+
+Packing Packing::Compute(const double min, const double max, const int bits,
+                         const double precision) {
+  if (bits < 2 || bits > 32)
+    throw std::invalid_argument("the number of bits must be in [2, 32]");
+  if (!std::isfinite(min) || !std::isfinite(max) || min > max)
+    throw std::invalid_argument("the range of the values is not valid");
+  if (!(precision >= 0))
+    throw std::invalid_argument("the precision must be positive");
+
+  // Number of intervals between the integers available, the smallest one
+  // being reserved for the missing values
+  const double intervals = std::ldexp(1.0, bits) - 2;
+  double step = (max - min) / intervals;
+  if (precision > 0) {
+    if (step > 2 * precision)
+      throw std::invalid_argument(
+          "the precision requested can not be reached with " +
+          std::to_string(bits) + " bits");
+    step = 2 * precision;
+  }
+  if (step == 0) step = 1;
+  const double center = min + (max - min) * 0.5;
+  return Packing(step, center, step * 0.5);
+}
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Process the values by vector. The values that are not finite are replaced
+// by the neutral element of the reduction. Returns the number of values
+// processed.
+__attribute__((target("avx2"))) static size_t MinMaxAvx2(const double* values,
+                                                         const size_t size,
+                                                         double& min,
+                                                         double& max) {
+  const __m256d abs =
+      _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+  const __m256d inf = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+  const __m256d minus_inf = _mm256_sub_pd(_mm256_setzero_pd(), inf);
+  __m256d lower = inf;
+  __m256d upper = minus_inf;
+  size_t ix = 0;
+  for (; ix + 4 <= size; ix += 4) {
+    const __m256d x = _mm256_loadu_pd(values + ix);
+    const __m256d finite =
+        _mm256_cmp_pd(_mm256_and_pd(x, abs), inf, _CMP_LT_OQ);
+    lower = _mm256_min_pd(lower, _mm256_blendv_pd(inf, x, finite));
+    upper = _mm256_max_pd(upper, _mm256_blendv_pd(minus_inf, x, finite));
+  }
+  double buffer[8];
+  _mm256_storeu_pd(buffer, lower);
+  _mm256_storeu_pd(buffer + 4, upper);
+  min = *std::min_element(buffer, buffer + 4);
+  max = *std::max_element(buffer + 4, buffer + 8);
+  return ix;
+}
+
+__attribute__((target("avx2"))) static size_t MinMaxAvx2(const float* values,
+                                                         const size_t size,
+                                                         double& min,
+                                                         double& max) {
+  const __m256 abs = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  const __m256 minus_inf = _mm256_sub_ps(_mm256_setzero_ps(), inf);
+  __m256 lower = inf;
+  __m256 upper = minus_inf;
+  size_t ix = 0;
+  for (; ix + 8 <= size; ix += 8) {
+    const __m256 x = _mm256_loadu_ps(values + ix);
+    const __m256 finite = _mm256_cmp_ps(_mm256_and_ps(x, abs), inf, _CMP_LT_OQ);
+    lower = _mm256_min_ps(lower, _mm256_blendv_ps(inf, x, finite));
+    upper = _mm256_max_ps(upper, _mm256_blendv_ps(minus_inf, x, finite));
+  }
+  float buffer[16];
+  _mm256_storeu_ps(buffer, lower);
+  _mm256_storeu_ps(buffer + 8, upper);
+  min = *std::min_element(buffer, buffer + 8);
+  max = *std::max_element(buffer + 8, buffer + 16);
+  return ix;
+}
+#endif
+
+// Combine the range computed by the SIMD kernel with the range of the
+// remaining values
+template <typename T>
+static bool MinMaxDispatch(const T* const values, const size_t size,
+                           double& min, double& max,
+                           bool (*scalar)(const T*, size_t, double&, double&)) {
+  size_t processed = 0;
+  double lower = std::numeric_limits<double>::infinity();
+  double upper = -std::numeric_limits<double>::infinity();
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2) processed = MinMaxAvx2(values, size, lower, upper);
+#endif
+  scalar(values + processed, size - processed, min, max);
+  min = std::min(min, lower);
+  max = std::max(max, upper);
+  return min <= max;
+}
+
+template <>
+bool Packing::MinMax(const float* const values, const size_t size,
+                     double& min, double& max) {
+  return MinMaxDispatch(values, size, min, max, &MinMaxScalar<float>);
+}
+
+template <>
+bool Packing::MinMax(const double* const values, const size_t size,
+                     double& min, double& max) {
+  return MinMaxDispatch(values, size, min, max, &MinMaxScalar<double>);
+}
+
+}  // namespace netcdf
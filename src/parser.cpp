@@ -14,6 +14,8 @@
    along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cctype>
 #include <netcdf4_cxx/parser.hpp>
 #include <valarray>
 
@@ -48,6 +50,26 @@ std::map<std::string, std::function<Any(Any, Any)>> LiteralExpression::binary_ =
 std::map<std::string, std::function<Any(Any, Any, Any)>>
     LiteralExpression::ternary_ = {{"iif", Any::iif}};
 
+std::map<std::string, Function> LiteralExpression::function_;
+
+void LiteralExpression::Register(const std::string& name,
+                                 const Function& function) {
+  if (name.empty() || !std::isalpha(static_cast<unsigned char>(name[0])) ||
+      std::find_if(name.begin(), name.end(), [](const unsigned char item) {
+        return !(std::isalnum(item) || item == '_');
+      }) != name.end())
+    throw std::invalid_argument("'" + name + "' is not a valid identifier");
+
+  if (unary_.count(name) || binary_.count(name) || ternary_.count(name) ||
+      constant_.count(name))
+    throw std::invalid_argument("'" + name +
+                                "' is a built-in function or constant");
+
+  auto it = function_.find(name);
+  if (it != function_.end()) function_.erase(it);
+  function_.insert(std::make_pair(name, function));
+}
+
 const Kind& TokenStream::Get() {
   char current, next;
 
@@ -154,9 +176,31 @@ const Kind& TokenStream::Get() {
   throw SyntaxError("bad token: ", *this);
 }
 
+std::string TokenStream::GetReference() {
+  std::string result;
+  char current;
+  bool closed = false;
+
+  while (stream_.get(current)) {
+    if (current == '}') {
+      closed = true;
+      break;
+    }
+    result += current;
+  }
+  if (!closed) throw SyntaxError("'}' expected", *this);
+
+  auto space = [](unsigned char ch) { return std::isspace(ch) != 0; };
+  auto first = std::find_if_not(result.begin(), result.end(), space);
+  auto last = std::find_if_not(result.rbegin(), result.rend(), space).base();
+  if (first >= last) throw SyntaxError("variable reference expected", *this);
+  return std::string(first, last);
+}
+
 Any LiteralExpression::Call(const std::string& identifier,
                             const IdentifierType function_type) {
   Any result, args[3];
+  profile::Scope scope(profiler_, identifier + "()");
 
   if (stream_.Get() != Kind::kLeftParenthesis)
     throw SyntaxError("'(' expected", stream_);
@@ -179,31 +223,104 @@ Any LiteralExpression::Call(const std::string& identifier,
   if (stream_.Get() != Kind::kRightParenthesis)
     throw SyntaxError("')' expected", stream_);
 
+  origin_ = nullptr;
   switch (function_type) {
     case IdentifierType::kTernary:
-      return ternary_[identifier](args[0], args[1], args[2]);
+      result = ternary_[identifier](args[0], args[1], args[2]);
+      break;
     case IdentifierType::kBinary:
-      return binary_[identifier](args[1], args[2]);
+      result = binary_[identifier](args[1], args[2]);
+      break;
     default:
-      return unary_[identifier](args[2]);
+      result = unary_[identifier](args[2]);
+      break;
   }
+  scope.SetResult(GetSize(result), GetAllocatedSize(result));
+  return result;
+}
+
+Any LiteralExpression::CallFunction(const std::string& identifier) {
+  const Function& function = function_.at(identifier);
+  std::vector<Any> args;
+  profile::Scope scope(profiler_, identifier + "()");
+
+  if (stream_.Get() != Kind::kLeftParenthesis)
+    throw SyntaxError("'(' expected", stream_);
+
+  Kind token = stream_.Get();
+  if (token != Kind::kRightParenthesis) {
+    stream_.PutBack(token);
+    while (true) {
+      args.push_back(Or());
+      token = stream_.Get();
+      if (token == Kind::kRightParenthesis) break;
+      if (token != Kind::kComma) throw SyntaxError("',' expected", stream_);
+    }
+  }
+
+  if (args.size() != function.arity())
+    throw SyntaxError(identifier + "() takes " +
+                          std::to_string(function.arity()) +
+                          " argument(s), " + std::to_string(args.size()) +
+                          " given",
+                      stream_);
+
+  // Scalars are broadcast to the size of the arrays
+  bool scalar = true;
+  size_t size = 1;
+  for (auto& item : args) {
+    if (item.IsTyped(typeid(double))) continue;
+    const size_t item_size = item.Cast<std::valarray<double>>().size();
+    if (!scalar && item_size != size)
+      throw std::runtime_error(identifier +
+                               "(): the arguments do not have the same size");
+    scalar = false;
+    size = item_size;
+  }
+
+  std::vector<std::valarray<double>> blocks;
+  for (auto& item : args) {
+    if (item.IsTyped(typeid(double)))
+      blocks.push_back(std::valarray<double>(item.Cast<double>(), size));
+    else
+      blocks.push_back(std::move(item.Cast<std::valarray<double>>()));
+  }
+
+  std::valarray<double> result = function(blocks);
+  if (result.size() != size)
+    throw std::runtime_error(identifier + "(): expected " +
+                             std::to_string(size) + " value(s), got " +
+                             std::to_string(result.size()));
+
+  origin_ = &function;
+  if (scalar) {
+    scope.SetResult(1, 0);
+    return result[0];
+  }
+  scope.SetResult(size, size * sizeof(double));
+  return result;
 }
 
 Any LiteralExpression::HandleIdentifier(const std::string& identifier) {
   const IdentifierType identifier_type = GetIdentifierType(identifier);
 
+  // Identifier is a user-defined function
+  if (identifier_type == IdentifierType::kUserDefined)
+    return CallFunction(identifier);
+
   // Identifier is a constant
   if (identifier_type == IdentifierType::kConstant)
-    return constant_[identifier];
+    return Leaf(identifier, constant_[identifier]);
 
   // Identifier is unknown
   if (identifier_type == IdentifierType::kNotAFunction) {
     Kind token = stream_.Get();
-    if (token == Kind::kAssign)
+    if (token == Kind::kAssign) {
       SetValue(identifier, Or());
-    else
-      stream_.PutBack(token);
-    return GetValue(identifier);
+      return Apply(identifier + " =", 1, [&] { return GetValue(identifier); });
+    }
+    stream_.PutBack(token);
+    return Leaf(identifier, GetValue(identifier), true);
   }
 
   // Identifier is a function
@@ -213,17 +330,34 @@ Any LiteralExpression::HandleIdentifier(const std::string& identifier) {
 Any LiteralExpression::LoadVariable() {
   Kind token = stream_.Get();
   if (token != Kind::kLeftAccolade) throw SyntaxError("'{' expected", stream_);
-  token = stream_.Get();
-  if (token != Kind::kName) throw SyntaxError("identifier expected", stream_);
-  std::string identifier = stream_.value();
-  token = stream_.Get();
-  if (token != Kind::kRightAccolade) throw SyntaxError("'}' expected", stream_);
-  return query_.LoadVariable(identifier);
+  std::string identifier = stream_.GetReference();
+  profile::Scope scope(profiler_, "${" + identifier + "}");
+  std::valarray<double> result = query_.LoadVariable(identifier);
+  scope.SetResult(result.size(), 0);
+  return result;
+}
+
+std::list<std::string> LiteralExpression::GetVariables(
+    const std::string& string) {
+  std::list<std::string> result;
+  TokenStream stream(string);
+  Kind token;
+
+  while ((token = stream.Get()) != Kind::kEnd) {
+    if (token != Kind::kVariable) continue;
+    if (stream.Get() != Kind::kLeftAccolade)
+      throw SyntaxError("'{' expected", stream);
+    std::string identifier = stream.GetReference();
+    if (std::find(result.begin(), result.end(), identifier) == result.end())
+      result.push_back(identifier);
+  }
+  return result;
 }
 
 Any LiteralExpression::Primary() {
   Any result;
   Kind token = stream_.Get();
+  origin_ = nullptr;
   switch (token) {
     // handle '(' or ')'
     case Kind::kLeftParenthesis: {
@@ -235,6 +369,11 @@ Any LiteralExpression::Primary() {
 
     // handle a number value
     case Kind::kNumber:
+      if (profiler_ != nullptr) {
+        std::ostringstream ss;
+        ss << stream_.value().Cast<double>();
+        return Leaf(ss.str(), stream_.value());
+      }
       return stream_.value();
 
     // handle a variable
@@ -249,7 +388,10 @@ Any LiteralExpression::Primary() {
 
     // handle -Or()
     case Kind::kMinus:
-      return Unary(-1, Or());
+      result = Or();
+      result = Apply("-", 1, [&] { return Unary(-1, std::move(result)); });
+      origin_ = nullptr;
+      return result;
 
     // handle +Or()
     case Kind::kPlus:
@@ -262,6 +404,9 @@ Any LiteralExpression::Primary() {
 
 Any& LiteralExpression::BinaryOperator(const Kind kind, Any&& left,
                                        Any&& right) {
+  // The result is no longer the one returned by a user-defined function
+  origin_ = nullptr;
+
   // Operation on scalars
   switch (kind) {
     case Kind::kPlus:
@@ -296,18 +441,30 @@ Any LiteralExpression::Term() {
 
   while (true) {
     switch (token) {
-      case Kind::kMul:
-        left = BinaryOperator(Kind::kMul, std::move(left), Primary());
+      case Kind::kMul: {
+        Any right = Primary();
+        left = Apply("*", 2, [&] {
+          return BinaryOperator(Kind::kMul, std::move(left), std::move(right));
+        });
         token = stream_.Get();
         break;
-      case Kind::kDiv:
-        left = BinaryOperator(Kind::kDiv, std::move(left), Primary());
+      }
+      case Kind::kDiv: {
+        Any right = Primary();
+        left = Apply("/", 2, [&] {
+          return BinaryOperator(Kind::kDiv, std::move(left), std::move(right));
+        });
         token = stream_.Get();
         break;
-      case Kind::kModulo:
-        left = BinaryOperator(Kind::kModulo, std::move(left), Primary());
+      }
+      case Kind::kModulo: {
+        Any right = Primary();
+        left = Apply("%", 2, [&] {
+          return BinaryOperator(Kind::kModulo, std::move(left), std::move(right));
+        });
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -321,14 +478,22 @@ Any LiteralExpression::Expression() {
 
   while (true) {
     switch (token) {
-      case Kind::kPlus:
-        left = BinaryOperator(Kind::kPlus, std::move(left), Term());
+      case Kind::kPlus: {
+        Any right = Term();
+        left = Apply("+", 2, [&] {
+          return BinaryOperator(Kind::kPlus, std::move(left), std::move(right));
+        });
         token = stream_.Get();
         break;
-      case Kind::kMinus:
-        left = BinaryOperator(Kind::kMinus, std::move(left), Term());
+      }
+      case Kind::kMinus: {
+        Any right = Term();
+        left = Apply("-", 2, [&] {
+          return BinaryOperator(Kind::kMinus, std::move(left), std::move(right));
+        });
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -342,22 +507,34 @@ Any LiteralExpression::Comparison() {
 
   while (true) {
     switch (token) {
-      case Kind::kGreaterThanOrEqualTo:
-        left = left >= Expression();
+      case Kind::kGreaterThanOrEqualTo: {
+        Any right = Expression();
+        left = Apply(">=", 2, [&] { return left >= right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
-      case Kind::kGreaterThan:
-        left = left > Expression();
+      }
+      case Kind::kGreaterThan: {
+        Any right = Expression();
+        left = Apply(">", 2, [&] { return left > right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
-      case Kind::kLessThan:
-        left = left < Expression();
+      }
+      case Kind::kLessThan: {
+        Any right = Expression();
+        left = Apply("<", 2, [&] { return left < right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
-      case Kind::kLessThanOrEqualTo:
-        left = left <= Expression();
+      }
+      case Kind::kLessThanOrEqualTo: {
+        Any right = Expression();
+        left = Apply("<=", 2, [&] { return left <= right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -371,14 +548,20 @@ Any LiteralExpression::Equality() {
 
   while (true) {
     switch (token) {
-      case Kind::kEquals:
-        left = left == Comparison();
+      case Kind::kEquals: {
+        Any right = Comparison();
+        left = Apply("==", 2, [&] { return left == right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
-      case Kind::kNotEquals:
-        left = left != Comparison();
+      }
+      case Kind::kNotEquals: {
+        Any right = Comparison();
+        left = Apply("!=", 2, [&] { return left != right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -392,10 +575,13 @@ Any LiteralExpression::And() {
 
   while (true) {
     switch (token) {
-      case Kind::kAnd:
-        left = left && Equality();
+      case Kind::kAnd: {
+        Any right = Equality();
+        left = Apply("&&", 2, [&] { return left && right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -409,10 +595,13 @@ Any LiteralExpression::Or() {
 
   while (true) {
     switch (token) {
-      case Kind::kOr:
-        left = left || And();
+      case Kind::kOr: {
+        Any right = And();
+        left = Apply("||", 2, [&] { return left || right; });
+        origin_ = nullptr;
         token = stream_.Get();
         break;
+      }
       default:
         stream_.PutBack(token);
         return left;
@@ -0,0 +1,190 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sys/resource.h>
+#include <iomanip>
+#include <netcdf4_cxx/profile.hpp>
+#include <sstream>
+#include <stdexcept>
+
+namespace netcdf {
+namespace profile {
+
+// Get the peak resident memory of the process since its start, in bytes
+static size_t GetProcessPeakMemory() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss);
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+void Profiler::Open(const std::string& name) {
+  Node& parent = Current();
+  parent.children_.emplace_back(name);
+  stack_.push_back(Frame{&parent.children_.back(), Clock::now()});
+}
+
+void Profiler::Close(const size_t elements, const size_t bytes_allocated) {
+  if (stack_.empty()) throw std::logic_error("no node opened");
+  Frame frame = stack_.back();
+  stack_.pop_back();
+
+  Node& node = *frame.node;
+  node.wall_time_ =
+      std::chrono::duration<double>(Clock::now() - frame.start).count();
+  node.elements_ = elements;
+  if (bytes_allocated != 0) {
+    ++node.allocations_;
+    node.bytes_allocated_ += bytes_allocated;
+  }
+
+  Node& parent = Current();
+  parent.bytes_read_ += node.bytes_read_;
+  parent.allocations_ += node.allocations_;
+  parent.bytes_allocated_ += node.bytes_allocated_;
+
+  if (stack_.empty()) Update(node);
+}
+
+void Profiler::Reduce(const std::string& name, const size_t arity,
+                      const double wall_time, const size_t elements,
+                      const size_t bytes_allocated) {
+  Node& parent = Current();
+  if (parent.children_.size() < arity)
+    throw std::logic_error("not enough nodes to reduce");
+
+  Node node(name);
+  auto first = std::prev(parent.children_.end(), arity);
+  node.children_.splice(node.children_.end(), parent.children_, first,
+                        parent.children_.end());
+  node.wall_time_ = wall_time;
+  for (auto& item : node.children_) {
+    node.wall_time_ += item.wall_time_;
+    node.bytes_read_ += item.bytes_read_;
+    node.allocations_ += item.allocations_;
+    node.bytes_allocated_ += item.bytes_allocated_;
+  }
+  node.elements_ = elements;
+  if (bytes_allocated != 0) {
+    ++node.allocations_;
+    node.bytes_allocated_ += bytes_allocated;
+    // The children already accounted for in the parent node
+    parent.allocations_ += 1;
+    parent.bytes_allocated_ += bytes_allocated;
+  }
+  parent.children_.push_back(std::move(node));
+  if (stack_.empty()) Update(parent.children_.back());
+}
+
+void Profiler::Update(const Node& last) {
+  root_.wall_time_ = 0;
+  for (auto& item : root_.children_) root_.wall_time_ += item.wall_time_;
+  root_.elements_ = last.elements_;
+  process_peak_memory_ = GetProcessPeakMemory();
+}
+
+void Profiler::AddBytesRead(const std::string& variable, const size_t bytes) {
+  Current().bytes_read_ += bytes;
+  bytes_read_[variable] += bytes;
+}
+
+// Write a node and its children as an indented tree
+static void WriteText(std::ostream& os, const Node& node, const size_t level) {
+  os << std::string(level * 2, ' ') << (level ? "-> " : "") << node.name()
+     << "  (time=" << std::fixed << std::setprecision(3)
+     << node.wall_time() * 1e3 << " ms, elements=" << node.elements();
+  if (node.bytes_read()) os << ", read=" << node.bytes_read() << " B";
+  if (node.allocations())
+    os << ", allocations=" << node.allocations() << " ("
+       << node.bytes_allocated() << " B)";
+  os << ")\n";
+  for (auto& item : node.children()) WriteText(os, item, level + 1);
+}
+
+// Escape a string to be written in a JSON document
+static std::string Escape(const std::string& string) {
+  std::ostringstream ss;
+  for (auto ch : string) {
+    switch (ch) {
+      case '"':
+        ss << "\\\"";
+        break;
+      case '\\':
+        ss << "\\\\";
+        break;
+      case '\n':
+        ss << "\\n";
+        break;
+      case '\t':
+        ss << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(ch) < 0x20)
+          ss << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(ch) << std::dec << std::setfill(' ');
+        else
+          ss << ch;
+    }
+  }
+  return ss.str();
+}
+
+// Write a node and its children as a JSON object
+static void WriteJson(std::ostream& os, const Node& node) {
+  os << "{\"name\":\"" << Escape(node.name()) << "\",\"wall_time\":"
+     << std::scientific << std::setprecision(6) << node.wall_time()
+     << ",\"elements\":" << node.elements()
+     << ",\"bytes_read\":" << node.bytes_read()
+     << ",\"allocations\":" << node.allocations()
+     << ",\"bytes_allocated\":" << node.bytes_allocated() << ",\"children\":[";
+  bool first = true;
+  for (auto& item : node.children()) {
+    if (!first) os << ",";
+    WriteJson(os, item);
+    first = false;
+  }
+  os << "]}";
+}
+
+std::string Profiler::ToString() const {
+  std::ostringstream ss;
+  WriteText(ss, root_, 0);
+  for (auto& item : bytes_read_)
+    ss << "Read " << item.first << ": " << item.second << " B\n";
+  ss << "Process peak memory: " << process_peak_memory_ << " B\n";
+  return ss.str();
+}
+
+std::string Profiler::ToJson() const {
+  std::ostringstream ss;
+  ss << "{\"plan\":";
+  WriteJson(ss, root_);
+  ss << ",\"bytes_read\":{";
+  bool first = true;
+  for (auto& item : bytes_read_) {
+    if (!first) ss << ",";
+    ss << "\"" << Escape(item.first) << "\":" << item.second;
+    first = false;
+  }
+  ss << "},\"process_peak_memory\":" << process_peak_memory_ << "}";
+  return ss.str();
+}
+
+}  // namespace profile
+}  // namespace netcdf
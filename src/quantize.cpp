@@ -0,0 +1,320 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <netcdf4_cxx/quantize.hpp>
+#include <stdexcept>
+#include <string>
+#include "simd.hpp"
+
+namespace netcdf {
+
+// Layout of the floating point numbers
+template <typename T>
+struct Layout;
+
+template <>
+struct Layout<float> {
+  using Bits = uint32_t;
+  static constexpr int kMantissa = 23;
+  static constexpr int kDigits = 7;
+  static constexpr Bits kExponent = 0x7f800000U;
+  static constexpr Bits kAbs = 0x7fffffffU;
+};
+
+template <>
+struct Layout<double> {
+  using Bits = uint64_t;
+  static constexpr int kMantissa = 52;
+  static constexpr int kDigits = 15;
+  static constexpr Bits kExponent = 0x7ff0000000000000ULL;
+  static constexpr Bits kAbs = 0x7fffffffffffffffULL;
+};
+
+// Number of binary digits per decimal digit
+static const double kBitsPerDigit = std::log2(10.0);
+
+// Access to the bits of a value
+template <typename T>
+static inline typename Layout<T>::Bits ToBits(const T value) {
+  typename Layout<T>::Bits result;
+  memcpy(&result, &value, sizeof(T));
+  return result;
+}
+
+template <typename T>
+static inline T FromBits(const typename Layout<T>::Bits bits) {
+  T result;
+  memcpy(&result, &bits, sizeof(T));
+  return result;
+}
+
+// Check if the value must be left unchanged: NaN, infinite or fill value
+template <typename T>
+static inline bool IsSpecial(const T value, const T fill_value) {
+  return (ToBits(value) & Layout<T>::kExponent) == Layout<T>::kExponent ||
+         value == fill_value;
+}
+
+// Round the mantissa to the nearest value with the given number of trailing
+// bits cleared, ties to even
+template <typename T>
+static inline T Round(const T value, const int zeroed) {
+  using Bits = typename Layout<T>::Bits;
+  const Bits bits = ToBits(value);
+  const Bits mask = ~((Bits(1) << zeroed) - 1);
+  const Bits half = Bits(1) << (zeroed - 1);
+  return FromBits<T>((bits + half - 1 + ((bits >> zeroed) & 1)) & mask);
+}
+
+// Alternately clear and set the trailing bits of the mantissa, starting from
+// the value of index first
+template <typename T>
+static void BitGroomScalar(T* const values, const size_t first,
+                           const size_t size, const int zeroed,
+                           const T fill_value) {
+  using Bits = typename Layout<T>::Bits;
+  const Bits mask = ~((Bits(1) << zeroed) - 1);
+  for (size_t ix = first; ix < size; ++ix) {
+    const T x = values[ix];
+    if (IsSpecial(x, fill_value)) continue;
+    const Bits bits = ToBits(x);
+    if (ix & 1)
+      values[ix] =
+          (bits & Layout<T>::kAbs) != 0 ? FromBits<T>(bits | ~mask) : x;
+    else
+      values[ix] = FromBits<T>(bits & mask);
+  }
+}
+
+// Round the trailing bits of the mantissa, starting from the value of index
+// first
+template <typename T>
+static void BitRoundScalar(T* const values, const size_t first,
+                           const size_t size, const int zeroed,
+                           const T fill_value) {
+  for (size_t ix = first; ix < size; ++ix) {
+    const T x = values[ix];
+    if (!IsSpecial(x, fill_value)) values[ix] = Round(x, zeroed);
+  }
+}
+
+// Round the trailing bits of the mantissa that are not needed to represent
+// the requested number of significant digits of each value
+template <typename T>
+static void GranularBitRound(T* const values, const size_t size,
+                             const int nsd, const T fill_value) {
+  const double digits_per_bit = 1 / kBitsPerDigit;
+  for (size_t ix = 0; ix < size; ++ix) {
+    const T x = values[ix];
+    if (x == 0 || IsSpecial(x, fill_value)) continue;
+    int exponent;
+    const double mantissa = std::frexp(static_cast<double>(x), &exponent);
+    const double log10_mantissa = std::log10(std::abs(mantissa));
+    const int digits = static_cast<int>(std::floor(
+                           exponent * digits_per_bit + log10_mantissa)) +
+                       1;
+    const int power =
+        static_cast<int>(std::floor(kBitsPerDigit * (digits - nsd)));
+    const int required =
+        std::abs(static_cast<int>(std::floor(
+                     exponent - kBitsPerDigit * log10_mantissa)) -
+                 power) -
+        1;
+    const int zeroed = Layout<T>::kMantissa - required;
+    if (zeroed > 0 && zeroed <= Layout<T>::kMantissa)
+      values[ix] = Round(x, zeroed);
+  }
+}
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Integer operations on the lanes holding the bits of the values
+__attribute__((target("avx2"))) static inline __m256i Set1(const uint32_t x) {
+  return _mm256_set1_epi32(static_cast<int>(x));
+}
+
+__attribute__((target("avx2"))) static inline __m256i Set1(const uint64_t x) {
+  return _mm256_set1_epi64x(static_cast<long long>(x));
+}
+
+__attribute__((target("avx2"))) static inline __m256i Add(const __m256i a,
+                                                          const __m256i b,
+                                                          uint32_t) {
+  return _mm256_add_epi32(a, b);
+}
+
+__attribute__((target("avx2"))) static inline __m256i Add(const __m256i a,
+                                                          const __m256i b,
+                                                          uint64_t) {
+  return _mm256_add_epi64(a, b);
+}
+
+__attribute__((target("avx2"))) static inline __m256i ShiftRight(
+    const __m256i a, const __m128i count, uint32_t) {
+  return _mm256_srl_epi32(a, count);
+}
+
+__attribute__((target("avx2"))) static inline __m256i ShiftRight(
+    const __m256i a, const __m128i count, uint64_t) {
+  return _mm256_srl_epi64(a, count);
+}
+
+__attribute__((target("avx2"))) static inline __m256i Equal(const __m256i a,
+                                                            const __m256i b,
+                                                            uint32_t) {
+  return _mm256_cmpeq_epi32(a, b);
+}
+
+__attribute__((target("avx2"))) static inline __m256i Equal(const __m256i a,
+                                                            const __m256i b,
+                                                            uint64_t) {
+  return _mm256_cmpeq_epi64(a, b);
+}
+
+// Lanes holding a NaN, an infinite or the fill value
+__attribute__((target("avx2"))) static inline __m256i Special(
+    const __m256i bits, const float fill_value) {
+  const __m256i exponent = Set1(Layout<float>::kExponent);
+  return _mm256_or_si256(
+      _mm256_cmpeq_epi32(_mm256_and_si256(bits, exponent), exponent),
+      _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(bits),
+                                        _mm256_set1_ps(fill_value),
+                                        _CMP_EQ_OQ)));
+}
+
+__attribute__((target("avx2"))) static inline __m256i Special(
+    const __m256i bits, const double fill_value) {
+  const __m256i exponent = Set1(Layout<double>::kExponent);
+  return _mm256_or_si256(
+      _mm256_cmpeq_epi64(_mm256_and_si256(bits, exponent), exponent),
+      _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(bits),
+                                        _mm256_set1_pd(fill_value),
+                                        _CMP_EQ_OQ)));
+}
+
+// Process the values by vector, the even lanes being cleared and the odd
+// lanes being set. Returns the number of values processed.
+template <typename T>
+__attribute__((target("avx2"))) static size_t BitGroomAvx2(
+    T* const values, const size_t size, const int zeroed, const T fill_value) {
+  using Bits = typename Layout<T>::Bits;
+  constexpr size_t kLanes = 32 / sizeof(T);
+  const Bits mask = ~((Bits(1) << zeroed) - 1);
+  const __m256i shave = Set1(mask);
+  const __m256i set = Set1(static_cast<Bits>(~mask));
+  const __m256i abs = Set1(Layout<T>::kAbs);
+  const __m256i zero = _mm256_setzero_si256();
+  // Odd lanes: the high half of each 64-bit lane for float, every other
+  // 64-bit lane for double
+  const __m256i odd = sizeof(T) == 4
+                          ? _mm256_set1_epi64x(static_cast<long long>(
+                                0xffffffff00000000ULL))
+                          : _mm256_setr_epi64x(0, -1, 0, -1);
+  size_t ix = 0;
+  for (; ix + kLanes <= size; ix += kLanes) {
+    __m256i* const p = reinterpret_cast<__m256i*>(values + ix);
+    const __m256i bits = _mm256_loadu_si256(p);
+    const __m256i is_zero = Equal(_mm256_and_si256(bits, abs), zero, Bits());
+    __m256i result = _mm256_blendv_epi8(_mm256_and_si256(bits, shave),
+                                        _mm256_or_si256(bits, set),
+                                        _mm256_andnot_si256(is_zero, odd));
+    result = _mm256_blendv_epi8(result, bits, Special(bits, fill_value));
+    _mm256_storeu_si256(p, result);
+  }
+  return ix;
+}
+
+// Process the values by vector. Returns the number of values processed.
+template <typename T>
+__attribute__((target("avx2"))) static size_t BitRoundAvx2(
+    T* const values, const size_t size, const int zeroed, const T fill_value) {
+  using Bits = typename Layout<T>::Bits;
+  constexpr size_t kLanes = 32 / sizeof(T);
+  const __m256i mask = Set1(static_cast<Bits>(~((Bits(1) << zeroed) - 1)));
+  const __m256i half = Set1(static_cast<Bits>((Bits(1) << (zeroed - 1)) - 1));
+  const __m256i one = Set1(static_cast<Bits>(1));
+  const __m128i count = _mm_cvtsi32_si128(zeroed);
+  size_t ix = 0;
+  for (; ix + kLanes <= size; ix += kLanes) {
+    __m256i* const p = reinterpret_cast<__m256i*>(values + ix);
+    const __m256i bits = _mm256_loadu_si256(p);
+    const __m256i even =
+        _mm256_and_si256(ShiftRight(bits, count, Bits()), one);
+    __m256i result = _mm256_and_si256(
+        Add(Add(bits, half, Bits()), even, Bits()), mask);
+    result = _mm256_blendv_epi8(result, bits, Special(bits, fill_value));
+    _mm256_storeu_si256(p, result);
+  }
+  return ix;
+}
+#endif
+
+// Number of trailing bits of the mantissa cleared
+template <typename T>
+static int GetZeroedBits(const QuantizeMode mode, const int nsd) {
+  const int max_nsd = mode == QuantizeMode::kBitRound ? Layout<T>::kMantissa
+                                                      : Layout<T>::kDigits;
+  if (nsd < 1 || nsd > max_nsd)
+    throw std::invalid_argument("the number of significant " +
+                                std::string(mode == QuantizeMode::kBitRound
+                                                ? "bits"
+                                                : "digits") +
+                                " must be in [1, " + std::to_string(max_nsd) +
+                                "]");
+  if (mode == QuantizeMode::kBitRound) return Layout<T>::kMantissa - nsd;
+  const int required = static_cast<int>(std::ceil(nsd * kBitsPerDigit)) + 1;
+  return std::max(0, Layout<T>::kMantissa - required);
+}
+
+template <typename T>
+static void QuantizeValues(T* const values, const size_t size,
+                           const QuantizeMode mode, const int nsd,
+                           const T fill_value) {
+  if (mode == QuantizeMode::kNone) return;
+  const int zeroed = GetZeroedBits<T>(mode, nsd);
+  if (mode == QuantizeMode::kGranularBitRound)
+    return GranularBitRound(values, size, nsd, fill_value);
+  if (zeroed == 0) return;
+
+  size_t processed = 0;
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2)
+    processed = mode == QuantizeMode::kBitGroom
+                    ? BitGroomAvx2(values, size, zeroed, fill_value)
+                    : BitRoundAvx2(values, size, zeroed, fill_value);
+#endif
+  if (mode == QuantizeMode::kBitGroom)
+    BitGroomScalar(values, processed, size, zeroed, fill_value);
+  else
+    BitRoundScalar(values, processed, size, zeroed, fill_value);
+}
+
+void Quantize(float* values, size_t size, QuantizeMode mode, int nsd,
+              float fill_value) {
+  QuantizeValues(values, size, mode, nsd, fill_value);
+}
+
+void Quantize(double* values, size_t size, QuantizeMode mode, int nsd,
+              double fill_value) {
+  QuantizeValues(values, size, mode, nsd, fill_value);
+}
+
+}  // namespace netcdf
@@ -14,19 +14,447 @@
    along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <memory>
+#include <netcdf4_cxx/cf.hpp>
 #include <netcdf4_cxx/parser.hpp>
 #include <netcdf4_cxx/query.hpp>
+#include <netcdf4_cxx/scale_missing.hpp>
+#include <numeric>
+#include <thread>
 
 namespace netcdf {
 
-std::valarray<double> Query::Evaluate(const File& file,
-                                      const std::string& query,
-                                      const std::string& unit) {
-  parser::LiteralExpression expr(QueryProxy(*this, file, unit), query);
+// Get the dimensions, defined in the target group, used to store the result of
+// an expression evaluated on variables using the given dimensions
+static std::vector<Dimension> GetTargetDimensions(
+    const Group& target, const std::vector<Dimension>& dimensions) {
+  std::vector<Dimension> result;
+
+  for (auto& item : dimensions) {
+    std::string name = item.GetShortName();
+    auto dimension = target.FindDimension(name);
+    if (dimension == nullptr) {
+      result.push_back(item.IsUnlimited()
+                           ? target.AddUnlimitedDimension(name)
+                           : target.AddDimension(name, item.GetLength()));
+    } else {
+      if (!dimension->IsUnlimited() &&
+          dimension->GetLength() != item.GetLength())
+        throw std::invalid_argument("the dimension '" + name +
+                                    "' is already defined with a different "
+                                    "length");
+      result.push_back(*dimension);
+    }
+  }
+  return result;
+}
+
+// Get the unit shared by all variables or an empty string if the variables do
+// not use the same unit
+static std::string GetCommonUnit(const std::vector<Variable>& variables) {
+  std::string result;
+
+  for (auto& item : variables) {
+    auto attribute = item.FindAttribute(CF::UNITS);
+    if (attribute == nullptr) return std::string();
+    std::string unit = attribute->ReadText();
+    if (!result.empty() && result != unit) return std::string();
+    result = unit;
+  }
+  return result;
+}
+
+// Get the result of an expression as an array of the expected size, values
+// undefined being replaced by the fill value.
+static std::valarray<double> GetValues(Any& result, const size_t size,
+                                       const double fill_value) {
+  std::valarray<double> values =
+      result.IsTyped(typeid(double))
+          ? std::valarray<double>(result.Cast<double>(), size)
+          : result.Cast<std::valarray<double>>();
+
+  if (values.size() != size)
+    throw std::runtime_error(
+        "the result of the expression does not match the shape of the "
+        "variables used");
+
+  for (auto& item : values) {
+    if (std::isnan(item)) item = fill_value;
+  }
+  return values;
+}
+
+void QueryContext::Add(const std::string& alias, const File& file) {
+  if (alias.empty() || !std::isalpha(static_cast<unsigned char>(alias[0])) ||
+      std::find_if(alias.begin(), alias.end(), [](unsigned char ch) {
+        return !std::isalnum(ch) && ch != '_';
+      }) != alias.end())
+    throw std::invalid_argument("'" + alias + "' is not a valid alias");
+  files_[alias] = &file;
+}
+
+const File& QueryContext::GetFile(const std::string& alias) const {
+  if (alias.empty()) {
+    if (default_ == nullptr) throw std::runtime_error("no default file");
+    return *default_;
+  }
+  auto it = files_.find(alias);
+  if (it == files_.end())
+    throw std::runtime_error(alias + ": no file registered under this alias");
+  return *it->second;
+}
+
+std::pair<std::string, std::string> QueryContext::SplitReference(
+    const std::string& reference) {
+  auto pos = reference.find(':');
+  if (pos == std::string::npos || reference.find('/') < pos)
+    return std::make_pair(std::string(), reference);
+  return std::make_pair(reference.substr(0, pos), reference.substr(pos + 1));
+}
+
+std::shared_ptr<Variable> QueryContext::FindVariable(
+    const std::string& reference) const {
+  auto split = SplitReference(reference);
+  return GetFile(split.first).FindVariableByPath(split.second);
+}
+
+// Values of a NetCDF variable read, masked and scaled
+struct VariableData {
+  std::valarray<double> values;
+  std::string units;
+  size_t bytes_read;
+  double read_time;
+  double scale_time;
+};
+
+// Read a NetCDF variable and apply its scale factor and its missing values
+static VariableData ReadVariable(const QueryContext& context,
+                                 const std::string& reference,
+                                 const Hyperslab& hyperslab,
+                                 const bool units) {
+  using Clock = profile::Profiler::Clock;
+  using Seconds = std::chrono::duration<double>;
+
+  auto variable = context.FindVariable(reference);
+  if (!variable) throw std::runtime_error(reference + ": no such variable");
+
+  VariableData result;
+  auto start = Clock::now();
+  result.values = hyperslab.IsEmpty() ? variable->Read<double>()
+                                      : variable->Read<double>(hyperslab);
+  result.bytes_read = result.values.size() * variable->GetDataType().GetSize();
+  auto end = Clock::now();
+  result.read_time = Seconds(end - start).count();
+
+  start = end;
+  ScaleMissing scale_missing(*variable);
+  scale_missing.MaskAndDeflate(result.values,
+                               std::numeric_limits<double>::quiet_NaN());
+  result.scale_time = Seconds(Clock::now() - start).count();
+
+  if (units) {
+    auto attribute = variable->FindAttribute(CF::UNITS);
+    result.units = attribute ? attribute->ReadText() : "1";
+  }
+  return result;
+}
+
+// Reads the variables used by an expression in a background thread, in order
+// of appearance, so that the reading of a variable overlaps the evaluation of
+// the expression on the variables already read.
+class Prefetcher {
+ public:
+  Prefetcher(const QueryContext& context, const Hyperslab& hyperslab,
+             const std::list<std::string>& references, const bool units)
+      : context_(context),
+        hyperslab_(hyperslab),
+        units_(units),
+        cancel_(false),
+        joined_(false) {
+    for (auto& item : references) {
+      if (futures_.count(item)) continue;
+      tasks_.emplace_back(item, std::promise<VariableData>());
+      futures_[item] = tasks_.back().second.get_future();
+    }
+    thread_ = std::thread([this] { Run(); });
+  }
+
+  ~Prefetcher() { Join(); }
+
+  // Get the data of a variable. The data prefetched is moved out: the
+  // variables not prefetched, or loaded again, are read once the background
+  // thread stopped.
+  VariableData Load(const std::string& reference, double& wait) {
+    auto it = futures_.find(reference);
+    if (it != futures_.end() &&
+        (!joined_ || it->second.wait_for(std::chrono::seconds(0)) ==
+                         std::future_status::ready)) {
+      auto start = profile::Profiler::Clock::now();
+      it->second.wait();
+      wait = std::chrono::duration<double>(profile::Profiler::Clock::now() -
+                                           start)
+                 .count();
+      VariableData result = it->second.get();
+      futures_.erase(it);
+      return result;
+    }
+    Join();
+    return ReadVariable(context_, reference, hyperslab_, units_);
+  }
+
+  // Stop the background thread
+  void Join() {
+    if (joined_) return;
+    cancel_ = true;
+    thread_.join();
+    joined_ = true;
+  }
+
+ private:
+  QueryContext context_;
+  Hyperslab hyperslab_;
+  bool units_;
+  std::list<std::pair<std::string, std::promise<VariableData>>> tasks_;
+  std::map<std::string, std::future<VariableData>> futures_;
+  std::atomic<bool> cancel_;
+  bool joined_;
+  std::thread thread_;
+
+  void Run() {
+    for (auto& item : tasks_) {
+      if (cancel_) return;
+      try {
+        item.second.set_value(
+            ReadVariable(context_, item.first, hyperslab_, units_));
+      } catch (...) {
+        item.second.set_exception(std::current_exception());
+      }
+    }
+  }
+};
+
+QueryProxy::QueryProxy(const Query& query, const QueryContext& context,
+                       const std::string& unit, const Hyperslab& hyperslab,
+                       profile::Profiler* profiler)
+    : query_(query),
+      context_(context),
+      unit_(unit),
+      hyperslab_(hyperslab),
+      profiler_(profiler),
+      prefetcher_() {}
+
+void QueryProxy::Prefetch(const std::list<std::string>& references) {
+  prefetcher_ = std::make_shared<Prefetcher>(context_, hyperslab_, references,
+                                             !unit_.empty());
+}
+
+std::valarray<double> QueryProxy::LoadVariable(const std::string& name) const {
+  double wait = -1;
+  VariableData data =
+      prefetcher_ ? prefetcher_->Load(name, wait)
+                  : ReadVariable(context_, name, hyperslab_, !unit_.empty());
+
+  if (profiler_ != nullptr) {
+    const size_t size = data.values.size();
+    // Time during which the evaluation waited for the background thread
+    if (wait >= 0) profiler_->Reduce("wait", 0, wait, size, 0);
+    profiler_->Reduce("read", 0, data.read_time, size, size * sizeof(double));
+    profiler_->Reduce("mask_and_scale", 0, data.scale_time, size, 0);
+    profiler_->AddBytesRead(name, data.bytes_read);
+  }
+  if (!unit_.empty()) {
+    profile::Scope scope(profiler_, "convert_units");
+    query_.ConvertToSamePysicalUnit(unit_, data.units, data.values);
+    scope.SetResult(data.values.size(), 0);
+  }
+  return std::move(data.values);
+}
+
+// Evaluate an expression and get its result as an array. The variables are
+// prefetched if the expression uses several variables.
+static std::valarray<double> Evaluate(QueryProxy& proxy,
+                                      const std::string& query) {
+  auto references = parser::LiteralExpression::GetVariables(query);
+  if (references.size() > 1) proxy.Prefetch(references);
+  parser::LiteralExpression expr(proxy, query);
   Any result = expr.Evaluate();
   if (result.IsTyped(typeid(double)))
     return std::valarray<double>{result.Cast<double>()};
   return result;
 }
 
-}  // namespace netcdf
\ No newline at end of file
+std::valarray<double> Query::Evaluate(const QueryContext& context,
+                                      const std::string& query,
+                                      const std::string& unit) {
+  QueryProxy proxy(*this, context, unit);
+  return netcdf::Evaluate(proxy, query);
+}
+
+std::valarray<double> Query::Evaluate(const QueryContext& context,
+                                      const std::string& query,
+                                      profile::Profiler& profiler,
+                                      const std::string& unit) {
+  QueryProxy proxy(*this, context, unit, Hyperslab(), &profiler);
+  return netcdf::Evaluate(proxy, query);
+}
+
+// Create the variable storing the result of an expression
+static Variable DefineVariable(const Group& target, const std::string& name,
+                               const std::vector<Dimension>& dimensions,
+                               const std::string& unit,
+                               const type::Primitive data_type,
+                               const EvaluateOptions& options) {
+  const type::Generic type(target, data_type);
+  Variable result = target.AddVariable(name, type, dimensions);
+
+  if (!unit.empty()) result.AddAttribute(CF::UNITS).WriteText(unit);
+  if (data_type == type::Primitive::kFloat)
+    result.AddAttribute(CF::FILL_VALUE)
+        .Write(type, std::vector<float>{static_cast<float>(options.fill_value)});
+  else
+    result.AddAttribute(CF::FILL_VALUE)
+        .Write(type, std::vector<double>{options.fill_value});
+  if (!options.chunk_sizes.empty()) result.SetChunking(options.chunk_sizes);
+  if (options.deflate_level > 0 || options.shuffle)
+    result.SetDeflate(options.shuffle, options.deflate_level);
+
+  // Files using the classic model must leave the define mode to be written
+  int status = nc_enddef(target.nc_id());
+  if (status != NC_ENOTINDEFINE) Check(status);
+
+  return result;
+}
+
+// Write the values computed using the type of the variable
+static void WriteValues(const Variable& variable, const Hyperslab& hyperslab,
+                        const std::valarray<double>& values) {
+  if (variable.GetDataType().GetPrimitive() == type::Primitive::kFloat) {
+    std::valarray<float> buffer(values.size());
+    for (size_t ix = 0; ix < values.size(); ++ix) {
+      buffer[ix] = static_cast<float>(values[ix]);
+    }
+    variable.Write(hyperslab, buffer);
+  } else {
+    variable.Write(hyperslab, values);
+  }
+}
+
+Variable Query::EvaluateInto(const QueryContext& context,
+                             const std::string& query, const Group& target,
+                             const std::string& name,
+                             const EvaluateOptions& options) {
+  const auto references = parser::LiteralExpression::GetVariables(query);
+  std::vector<Variable> variables;
+  for (auto& item : references) {
+    auto variable = context.FindVariable(item);
+    if (!variable) throw std::runtime_error(item + ": no such variable");
+    variables.push_back(*variable);
+  }
+
+  // The variables used by the expression define the shape of the result
+  std::vector<Dimension> dimensions;
+  std::vector<size_t> shape;
+  if (!variables.empty()) {
+    dimensions = variables.front().GetDimensions();
+    shape = variables.front().GetShape();
+    for (auto& item : variables) {
+      if (item.GetShape() != shape)
+        throw std::invalid_argument(
+            "the variables used by the expression do not have the same "
+            "shape");
+    }
+  }
+  dimensions = GetTargetDimensions(target, dimensions);
+
+  // The unit and the type of the result are known once the expression has
+  // been evaluated: the variable is created after the evaluation of the first
+  // tile.
+  const std::string common_unit = GetCommonUnit(variables);
+  const std::string& unit = options.unit;
+  std::string result_unit = unit;
+  type::Primitive data_type = type::Primitive::kDouble;
+  std::shared_ptr<Variable> result;
+  auto define = [&]() {
+    if (result_unit.empty()) result_unit = common_unit;
+    result = std::make_shared<Variable>(DefineVariable(
+        target, name, dimensions, result_unit, data_type, options));
+  };
+
+  // Evaluate the expression on a tile. The proxy is destroyed before
+  // returning: its background thread no longer calls the NetCDF library
+  // while the results are written.
+  auto evaluate = [&](const Hyperslab& hyperslab) {
+    QueryProxy proxy(*this, context, unit, hyperslab, options.profiler);
+    if (references.size() > 1) proxy.Prefetch(references);
+    parser::LiteralExpression expr(proxy, query);
+    Any value = expr.Evaluate();
+    if (unit.empty()) result_unit = expr.GetUnit();
+    data_type = expr.GetDataType();
+    return value;
+  };
+
+  // Write the values computed for a tile
+  auto write = [&](const Hyperslab& hyperslab, Any& value, const size_t size) {
+    profile::Scope scope(options.profiler, "write");
+    WriteValues(*result, hyperslab, GetValues(value, size, options.fill_value));
+    scope.SetResult(size, size * sizeof(double));
+  };
+
+  // The expression does not use NetCDF variables: the result is a scalar
+  if (shape.empty()) {
+    Any value = evaluate(Hyperslab());
+    define();
+    write(Hyperslab(), value, 1);
+    return *result;
+  }
+
+  // Number of rows of the first dimension processed by each tile, aligned on
+  // the chunks of the variable created
+  const size_t row_size =
+      std::accumulate(shape.begin() + 1, shape.end(), static_cast<size_t>(1),
+                      std::multiplies<size_t>());
+  size_t rows = std::max<size_t>(1, options.tile_size /
+                                        std::max<size_t>(1, row_size));
+  if (!options.chunk_sizes.empty() && options.chunk_sizes[0] != 0) {
+    const size_t chunk = options.chunk_sizes[0];
+    rows = std::max(chunk, rows / chunk * chunk);
+  }
+
+  std::vector<size_t> start(shape.size(), 0);
+  std::vector<size_t> end(shape);
+  for (size_t first = 0; first < shape[0]; first += rows) {
+    start[0] = first;
+    end[0] = std::min(first + rows, shape[0]);
+
+    profile::Scope scope(options.profiler,
+                         "tile [" + std::to_string(start[0]) + ", " +
+                             std::to_string(end[0]) + ")");
+    Hyperslab hyperslab(start, end);
+    Any value = evaluate(hyperslab);
+    if (result == nullptr) define();
+    write(hyperslab, value, hyperslab.GetSize());
+    scope.SetResult(hyperslab.GetSize(), 0);
+  }
+
+  // Nothing to evaluate: the first dimension is empty
+  if (result == nullptr) define();
+  return *result;
+}
+
+void Query::RegisterFunction(const std::string& name,
+                             const Function& function) {
+  parser::LiteralExpression::Register(name, function);
+}
+
+bool Query::UnregisterFunction(const std::string& name) {
+  return parser::LiteralExpression::Unregister(name);
+}
+
+}  // namespace netcdf
@@ -15,11 +15,16 @@
 */
 
 #include <netcdf.h>
+#include <bitset>
+#include <cmath>
+#include <limits>
 #include <memory>
 #include <netcdf4_cxx/attribute.hpp>
 #include <netcdf4_cxx/cf.hpp>
 #include <netcdf4_cxx/dataset.hpp>
 #include <netcdf4_cxx/scale_missing.hpp>
+#include <stdexcept>
+#include "simd.hpp"
 
 namespace netcdf {
 
@@ -35,7 +40,11 @@ constexpr ScaleMissing::ScaleMissing() noexcept
       scale_(1),
       offset_(0),
       fill_value_(NC_FILL_DOUBLE),
-      missing_value_(NC_FILL_DOUBLE) {}
+      missing_value_(NC_FILL_DOUBLE),
+      mask_min_(-std::numeric_limits<double>::infinity()),
+      mask_max_(std::numeric_limits<double>::infinity()),
+      mask_fill_value_(std::numeric_limits<double>::quiet_NaN()),
+      mask_missing_value_(std::numeric_limits<double>::quiet_NaN()) {}
 
 // ___________________________________________________________________________//
 
@@ -80,6 +89,429 @@ ScaleMissing::ScaleMissing(const DataSet& dataset)
   if (has_missing_value_) {
     missing_value_ = attribute->ReadScalar<double>();
   }
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  mask_min_ = HasInvalidData() ? valid_min_ : -inf;
+  mask_max_ = HasInvalidData() ? valid_max_ : inf;
+  mask_fill_value_ = has_fill_value_ ? fill_value_ : nan;
+  mask_missing_value_ = has_missing_value_ ? missing_value_ : nan;
+}
+
+// Parameters of the kernels applied on the values
+struct Parameters {
+  double min;
+  double max;
+  double fill_value;
+  double missing_value;
+  double scale;
+  double offset;
+  double value;
+};
+
+// Operations performed by the kernels
+enum { kMask = 1, kInflate = 2, kDeflate = 4 };
+
+// Process the values one by one
+template <typename T, int Operations>
+static void Scalar(T* data, const size_t size, const Parameters& p) {
+  for (size_t ix = 0; ix < size; ++ix) {
+    const double x = data[ix];
+    const bool missing = (x != x) | (x == p.fill_value) |
+                         (x == p.missing_value) | (x < p.min) | (x > p.max);
+    double y = x;
+    if (Operations & kInflate) y = (x - p.offset) / p.scale;
+    if (Operations & kDeflate) y = x * p.scale + p.offset;
+    if (Operations & kMask)
+      data[ix] = static_cast<T>(missing ? p.value : y);
+    else
+      data[ix] = missing ? data[ix] : static_cast<T>(y);
+  }
+}
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Load and store four values as doubles
+__attribute__((target("avx2"))) static inline __m256d Load4(const double* p) {
+  return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2"))) static inline __m256d Load4(const float* p) {
+  return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+__attribute__((target("avx2"))) static inline void Store4(double* p,
+                                                          const __m256d x) {
+  _mm256_storeu_pd(p, x);
+}
+
+__attribute__((target("avx2"))) static inline void Store4(float* p,
+                                                          const __m256d x) {
+  _mm_storeu_ps(p, _mm256_cvtpd_ps(x));
+}
+
+// Process the values four by four. The missing values are selected by a mask
+// combining all the tests.
+template <typename T, int Operations>
+__attribute__((target("avx2"))) static void Avx2(T* data, const size_t size,
+                                                 const Parameters& p) {
+  const __m256d min = _mm256_set1_pd(p.min);
+  const __m256d max = _mm256_set1_pd(p.max);
+  const __m256d fill_value = _mm256_set1_pd(p.fill_value);
+  const __m256d missing_value = _mm256_set1_pd(p.missing_value);
+  const __m256d scale = _mm256_set1_pd(p.scale);
+  const __m256d offset = _mm256_set1_pd(p.offset);
+  const __m256d value = _mm256_set1_pd(p.value);
+
+  size_t ix = 0;
+  for (; ix + 4 <= size; ix += 4) {
+    const __m256d x = Load4(data + ix);
+    __m256d mask = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+    mask = _mm256_or_pd(mask, _mm256_cmp_pd(x, fill_value, _CMP_EQ_OQ));
+    mask = _mm256_or_pd(mask, _mm256_cmp_pd(x, missing_value, _CMP_EQ_OQ));
+    mask = _mm256_or_pd(mask, _mm256_cmp_pd(x, min, _CMP_LT_OQ));
+    mask = _mm256_or_pd(mask, _mm256_cmp_pd(x, max, _CMP_GT_OQ));
+    __m256d y = x;
+    if (Operations & kInflate)
+      y = _mm256_div_pd(_mm256_sub_pd(x, offset), scale);
+    if (Operations & kDeflate)
+      y = _mm256_add_pd(_mm256_mul_pd(x, scale), offset);
+    Store4(data + ix,
+           _mm256_blendv_pd(y, (Operations & kMask) ? value : x, mask));
+  }
+  Scalar<T, Operations>(data + ix, size - ix, p);
+}
+
+// Load and store eight values as doubles
+__attribute__((target("avx512f"))) static inline __m512d Load8(
+    const double* p) {
+  return _mm512_loadu_pd(p);
+}
+
+__attribute__((target("avx512f"))) static inline __m512d Load8(const float* p) {
+  return _mm512_cvtps_pd(_mm256_loadu_ps(p));
+}
+
+__attribute__((target("avx512f"))) static inline void Store8(double* p,
+                                                             const __m512d x) {
+  _mm512_storeu_pd(p, x);
+}
+
+__attribute__((target("avx512f"))) static inline void Store8(float* p,
+                                                             const __m512d x) {
+  _mm256_storeu_ps(p, _mm512_cvtpd_ps(x));
+}
+
+// Process the values eight by eight, the tests being combined in a mask
+// register
+template <typename T, int Operations>
+__attribute__((target("avx512f"))) static void Avx512(T* data,
+                                                      const size_t size,
+                                                      const Parameters& p) {
+  const __m512d min = _mm512_set1_pd(p.min);
+  const __m512d max = _mm512_set1_pd(p.max);
+  const __m512d fill_value = _mm512_set1_pd(p.fill_value);
+  const __m512d missing_value = _mm512_set1_pd(p.missing_value);
+  const __m512d scale = _mm512_set1_pd(p.scale);
+  const __m512d offset = _mm512_set1_pd(p.offset);
+  const __m512d value = _mm512_set1_pd(p.value);
+
+  size_t ix = 0;
+  for (; ix + 8 <= size; ix += 8) {
+    const __m512d x = Load8(data + ix);
+    const __mmask8 mask = _mm512_cmp_pd_mask(x, x, _CMP_UNORD_Q) |
+                          _mm512_cmp_pd_mask(x, fill_value, _CMP_EQ_OQ) |
+                          _mm512_cmp_pd_mask(x, missing_value, _CMP_EQ_OQ) |
+                          _mm512_cmp_pd_mask(x, min, _CMP_LT_OQ) |
+                          _mm512_cmp_pd_mask(x, max, _CMP_GT_OQ);
+    __m512d y = x;
+    // The explicit rounding prevents the contraction into a fused
+    // multiply-add, which would not round like the other kernels.
+    if (Operations & kInflate)
+      y = _mm512_div_pd(_mm512_sub_pd(x, offset), scale);
+    if (Operations & kDeflate)
+      y = _mm512_add_round_pd(
+          _mm512_mul_round_pd(x, scale, _MM_FROUND_CUR_DIRECTION), offset,
+          _MM_FROUND_CUR_DIRECTION);
+    Store8(data + ix,
+           _mm512_mask_blend_pd(mask, y, (Operations & kMask) ? value : x));
+  }
+  Scalar<T, Operations>(data + ix, size - ix, p);
+}
+#endif
+
+// Kernel processing an array
+template <typename T>
+using Kernel = void (*)(T*, const size_t, const Parameters&);
+
+// Get the fastest kernel supported by the CPU
+template <typename T, int Operations>
+static Kernel<T> GetKernel() {
+#ifdef NETCDF4_CXX_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return Avx512<T, Operations>;
+  if (__builtin_cpu_supports("avx2")) return Avx2<T, Operations>;
+#endif
+  return Scalar<T, Operations>;
+}
+
+// Apply the kernel implementing the operations requested
+template <typename T>
+static void Dispatch(T* data, const size_t size, const int operations,
+                     const Parameters& p) {
+  // The kernels are selected once
+  static const Kernel<T> mask = GetKernel<T, kMask>();
+  static const Kernel<T> inflate = GetKernel<T, kInflate>();
+  static const Kernel<T> deflate = GetKernel<T, kDeflate>();
+  static const Kernel<T> mask_inflate = GetKernel<T, kMask | kInflate>();
+  static const Kernel<T> mask_deflate = GetKernel<T, kMask | kDeflate>();
+
+  switch (operations) {
+    case kMask:
+      return mask(data, size, p);
+    case kInflate:
+      return inflate(data, size, p);
+    case kDeflate:
+      return deflate(data, size, p);
+    case kMask | kInflate:
+      return mask_inflate(data, size, p);
+    case kMask | kDeflate:
+      return mask_deflate(data, size, p);
+    default:
+      throw std::invalid_argument("unknown operations");
+  }
+}
+
+template <>
+void ScaleMissing::Apply(std::valarray<float>& array, const int operations,
+                         const float value) const {
+  if (array.size() == 0) return;
+  Dispatch(&array[0], array.size(), operations,
+           Parameters{mask_min_, mask_max_, mask_fill_value_,
+                      mask_missing_value_, scale_, offset_, value});
+}
+
+template <>
+void ScaleMissing::Apply(std::valarray<double>& array, const int operations,
+                         const double value) const {
+  if (array.size() == 0) return;
+  Dispatch(&array[0], array.size(), operations,
+           Parameters{mask_min_, mask_max_, mask_fill_value_,
+                      mask_missing_value_, scale_, offset_, value});
+}
+
+// Number of values processed by a validity kernel and number of missing
+// values found
+struct ValidityCount {
+  size_t processed;
+  size_t missing;
+};
+
+#ifdef NETCDF4_CXX_X86_SIMD
+// Tests applied on 16-bit integers. The tests are disabled by a null mask.
+struct ShortTests {
+  short fill_value;
+  short missing_value;
+  short min;
+  short max;
+  short has_fill_value;
+  short has_missing_value;
+  short has_min;
+  short has_max;
+};
+
+// Compute the validity of 16-bit integers sixteen by sixteen
+__attribute__((target("avx2"))) static ValidityCount ValidityAvx2(
+    const short* values, const size_t size, uint8_t* validity,
+    uint8_t* reasons, const ShortTests& t) {
+  const __m256i fill_value = _mm256_set1_epi16(t.fill_value);
+  const __m256i missing_value = _mm256_set1_epi16(t.missing_value);
+  const __m256i min = _mm256_set1_epi16(t.min);
+  const __m256i max = _mm256_set1_epi16(t.max);
+  const __m256i has_fill_value = _mm256_set1_epi16(t.has_fill_value);
+  const __m256i has_missing_value = _mm256_set1_epi16(t.has_missing_value);
+  const __m256i has_min = _mm256_set1_epi16(t.has_min);
+  const __m256i has_max = _mm256_set1_epi16(t.has_max);
+
+  ValidityCount result{0, 0};
+  for (; result.processed + 16 <= size; result.processed += 16) {
+    const size_t ix = result.processed;
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + ix));
+    const __m256i is_fill_value =
+        _mm256_and_si256(_mm256_cmpeq_epi16(x, fill_value), has_fill_value);
+    const __m256i is_missing_value = _mm256_and_si256(
+        _mm256_cmpeq_epi16(x, missing_value), has_missing_value);
+    const __m256i is_below =
+        _mm256_and_si256(_mm256_cmpgt_epi16(min, x), has_min);
+    const __m256i is_above =
+        _mm256_and_si256(_mm256_cmpgt_epi16(x, max), has_max);
+    const __m256i invalid =
+        _mm256_or_si256(_mm256_or_si256(is_fill_value, is_missing_value),
+                        _mm256_or_si256(is_below, is_above));
+
+    // One bit per value: the 16-bit masks are narrowed to bytes
+    const unsigned bits = static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_packs_epi16(_mm256_castsi256_si128(invalid),
+                        _mm256_extracti128_si256(invalid, 1))));
+    validity[ix >> 3] = static_cast<uint8_t>(~bits);
+    validity[(ix >> 3) + 1] = static_cast<uint8_t>(~bits >> 8);
+    result.missing += std::bitset<16>(bits).count();
+
+    if (reasons != nullptr) {
+      // The last blend has the highest priority
+      __m256i code = _mm256_setzero_si256();
+      code = _mm256_blendv_epi8(code, _mm256_set1_epi16(5), is_above);
+      code = _mm256_blendv_epi8(code, _mm256_set1_epi16(4), is_below);
+      code = _mm256_blendv_epi8(code, _mm256_set1_epi16(3), is_missing_value);
+      code = _mm256_blendv_epi8(code, _mm256_set1_epi16(2), is_fill_value);
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(reasons + ix),
+          _mm_packus_epi16(_mm256_castsi256_si128(code),
+                           _mm256_extracti128_si256(code, 1)));
+    }
+  }
+  return result;
+}
+
+// Compute the validity of floating point values eight by eight, the tests
+// being done in double precision
+template <typename T>
+__attribute__((target("avx2"))) static ValidityCount ValidityAvx2(
+    const T* values, const size_t size, uint8_t* validity, uint8_t* reasons,
+    const Parameters& p) {
+  const __m256d min = _mm256_set1_pd(p.min);
+  const __m256d max = _mm256_set1_pd(p.max);
+  const __m256d fill_value = _mm256_set1_pd(p.fill_value);
+  const __m256d missing_value = _mm256_set1_pd(p.missing_value);
+
+  ValidityCount result{0, 0};
+  for (; result.processed + 8 <= size; result.processed += 8) {
+    const size_t ix = result.processed;
+    int bits = 0;
+    __m128i codes[2];
+    for (int jx = 0; jx < 2; ++jx) {
+      const __m256d x = Load4(values + ix + jx * 4);
+      const __m256d is_nan = _mm256_cmp_pd(x, x, _CMP_UNORD_Q);
+      const __m256d is_fill_value = _mm256_cmp_pd(x, fill_value, _CMP_EQ_OQ);
+      const __m256d is_missing_value =
+          _mm256_cmp_pd(x, missing_value, _CMP_EQ_OQ);
+      const __m256d is_below = _mm256_cmp_pd(x, min, _CMP_LT_OQ);
+      const __m256d is_above = _mm256_cmp_pd(x, max, _CMP_GT_OQ);
+      const __m256d invalid = _mm256_or_pd(
+          _mm256_or_pd(_mm256_or_pd(is_nan, is_fill_value), is_missing_value),
+          _mm256_or_pd(is_below, is_above));
+      bits |= _mm256_movemask_pd(invalid) << (jx * 4);
+
+      if (reasons != nullptr) {
+        __m256d code = _mm256_setzero_pd();
+        code = _mm256_blendv_pd(code, _mm256_set1_pd(5), is_above);
+        code = _mm256_blendv_pd(code, _mm256_set1_pd(4), is_below);
+        code = _mm256_blendv_pd(code, _mm256_set1_pd(3), is_missing_value);
+        code = _mm256_blendv_pd(code, _mm256_set1_pd(2), is_fill_value);
+        code = _mm256_blendv_pd(code, _mm256_set1_pd(1), is_nan);
+        codes[jx] = _mm256_cvtpd_epi32(code);
+      }
+    }
+    validity[ix >> 3] = static_cast<uint8_t>(~bits);
+    result.missing += std::bitset<8>(bits).count();
+
+    if (reasons != nullptr) {
+      const __m128i code = _mm_packs_epi32(codes[0], codes[1]);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(reasons + ix),
+                       _mm_packus_epi16(code, code));
+    }
+  }
+  return result;
+}
+
+// Get a value tested as a 16-bit integer. Returns false if the value is not
+// a 16-bit integer: the test never matches.
+static bool ToShort(const double value, short& result) {
+  if (!(value >= std::numeric_limits<short>::min() &&
+        value <= std::numeric_limits<short>::max()) ||
+      value != std::floor(value))
+    return false;
+  result = static_cast<short>(value);
+  return true;
+}
+#endif
+
+template <>
+size_t ScaleMissing::ComputeValidity(const short* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const {
+  ValidityCount count{0, 0};
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+
+  // The valid range is converted into bounds tested on integers: x < min is
+  // equivalent to x < ceil(min). A range excluding all the 16-bit integers is
+  // handled by the scalar loop.
+  const double min = std::ceil(mask_min_);
+  const double max = std::floor(mask_max_);
+  const bool has_min = min > std::numeric_limits<short>::min();
+  const bool has_max = max < std::numeric_limits<short>::max();
+  if (avx2 && !(has_min && min > std::numeric_limits<short>::max()) &&
+      !(has_max && max < std::numeric_limits<short>::min())) {
+    ShortTests tests{0, 0, 0, 0, 0, 0, 0, 0};
+    tests.has_fill_value = ToShort(mask_fill_value_, tests.fill_value) ? -1 : 0;
+    tests.has_missing_value =
+        ToShort(mask_missing_value_, tests.missing_value) ? -1 : 0;
+    if (has_min) {
+      tests.min = static_cast<short>(min);
+      tests.has_min = -1;
+    }
+    if (has_max) {
+      tests.max = static_cast<short>(max);
+      tests.has_max = -1;
+    }
+    count = ValidityAvx2(values, size, validity, reasons, tests);
+  }
+#endif
+  return count.missing +
+         ComputeValidityScalar(values + count.processed, size - count.processed,
+                               validity + (count.processed >> 3),
+                               reasons ? reasons + count.processed : nullptr);
+}
+
+template <>
+size_t ScaleMissing::ComputeValidity(const float* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const {
+  ValidityCount count{0, 0};
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2)
+    count = ValidityAvx2(values, size, validity, reasons,
+                         Parameters{mask_min_, mask_max_, mask_fill_value_,
+                                    mask_missing_value_, scale_, offset_, 0});
+#endif
+  return count.missing +
+         ComputeValidityScalar(values + count.processed, size - count.processed,
+                               validity + (count.processed >> 3),
+                               reasons ? reasons + count.processed : nullptr);
+}
+
+template <>
+size_t ScaleMissing::ComputeValidity(const double* const values,
+                                     const size_t size,
+                                     uint8_t* const validity,
+                                     uint8_t* const reasons) const {
+  ValidityCount count{0, 0};
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2)
+    count = ValidityAvx2(values, size, validity, reasons,
+                         Parameters{mask_min_, mask_max_, mask_fill_value_,
+                                    mask_missing_value_, scale_, offset_, 0});
+#endif
+  return count.missing +
+         ComputeValidityScalar(values + count.processed, size - count.processed,
+                               validity + (count.processed >> 3),
+                               reasons ? reasons + count.processed : nullptr);
 }
 
 }  // namespace netcdf
@@ -0,0 +1,446 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <netcdf4_cxx/selection.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "simd.hpp"
+
+namespace netcdf {
+
+// A box holding at most this number of values is read whatever the number
+// of points it serves
+static const size_t kMinBoxSize = 1024;
+
+// Above, a box is read if it holds at most this number of values per point
+static const size_t kMaxValuesPerPoint = 8;
+
+// Points of the selection, given by their position in the sorted list
+struct Span {
+  size_t first;
+  size_t last;
+};
+
+std::vector<PointBlock> Coalesce(const PointSelection& selection,
+                                 const std::vector<size_t>& shape,
+                                 const std::vector<size_t>& chunks) {
+  const size_t rank = selection.GetRank();
+  if (shape.size() != rank)
+    throw std::invalid_argument(
+        "the rank of the selection does not match the rank of the variable");
+  if (!chunks.empty() && chunks.size() != rank)
+    throw std::invalid_argument(
+        "the chunk sizes do not match the rank of the variable");
+
+  // Index of the chunk holding each point, the chunks being numbered in
+  // row-major order. A variable stored contiguously is a single chunk.
+  const size_t size = selection.GetSize();
+  std::vector<size_t> keys(size);
+  for (size_t ix = 0; ix < size; ++ix) {
+    const size_t* point = selection[ix];
+    size_t key = 0;
+    for (size_t dim = 0; dim < rank; ++dim) {
+      if (point[dim] >= shape[dim])
+        throw std::invalid_argument(
+            "a point is outside the variable definition");
+      const size_t chunk = chunks.empty() ? shape[dim] : chunks[dim];
+      key = key * ((shape[dim] + chunk - 1) / chunk) + point[dim] / chunk;
+    }
+    keys[ix] = key;
+  }
+
+  std::vector<size_t> order(size);
+  for (size_t ix = 0; ix < size; ++ix) order[ix] = ix;
+  std::sort(order.begin(), order.end(),
+            [&](const size_t lhs, const size_t rhs) {
+              if (keys[lhs] != keys[rhs]) return keys[lhs] < keys[rhs];
+              if (std::equal(selection[lhs], selection[lhs] + rank,
+                             selection[rhs]))
+                return lhs < rhs;
+              return std::lexicographical_compare(
+                  selection[lhs], selection[lhs] + rank, selection[rhs],
+                  selection[rhs] + rank);
+            });
+
+  std::vector<PointBlock> result;
+  std::vector<size_t> lower(rank);
+  std::vector<size_t> upper(rank);
+  std::vector<Span> spans;
+
+  for (size_t first = 0; first < size;) {
+    size_t last = first + 1;
+    while (last < size && keys[order[last]] == keys[order[first]]) ++last;
+    spans.push_back(Span{first, last});
+    first = last;
+
+    // The points of a chunk are read with their bounding box, split in two
+    // at the largest gap between the points while it holds too many values
+    // not selected
+    while (!spans.empty()) {
+      Span span = spans.back();
+      spans.pop_back();
+
+      std::copy(selection[order[span.first]],
+                selection[order[span.first]] + rank, lower.begin());
+      upper = lower;
+      for (size_t ix = span.first + 1; ix < span.last; ++ix) {
+        const size_t* point = selection[order[ix]];
+        for (size_t dim = 0; dim < rank; ++dim) {
+          lower[dim] = std::min(lower[dim], point[dim]);
+          upper[dim] = std::max(upper[dim], point[dim]);
+        }
+      }
+
+      size_t volume = 1;
+      size_t widest = 0;
+      for (size_t dim = 0; dim < rank; ++dim) {
+        volume *= upper[dim] - lower[dim] + 1;
+        if (upper[dim] - lower[dim] > upper[widest] - lower[widest])
+          widest = dim;
+      }
+
+      const size_t count = span.last - span.first;
+      if (volume > std::max(kMinBoxSize, kMaxValuesPerPoint * count)) {
+        auto begin = order.begin() + span.first;
+        auto end = order.begin() + span.last;
+        std::stable_sort(begin, end, [&](const size_t lhs, const size_t rhs) {
+          return selection[lhs][widest] < selection[rhs][widest];
+        });
+        size_t split = span.first + 1;
+        size_t gap = 0;
+        for (size_t ix = span.first + 1; ix < span.last; ++ix) {
+          const size_t distance = selection[order[ix]][widest] -
+                                  selection[order[ix - 1]][widest];
+          if (distance > gap) {
+            gap = distance;
+            split = ix;
+          }
+        }
+        spans.push_back(Span{split, span.last});
+        spans.push_back(Span{span.first, split});
+        continue;
+      }
+
+      PointBlock block;
+      std::vector<size_t> end(rank);
+      for (size_t dim = 0; dim < rank; ++dim) end[dim] = upper[dim] + 1;
+      block.box = Hyperslab(lower, end);
+      for (size_t ix = span.first; ix < span.last; ++ix) {
+        const size_t* point = selection[order[ix]];
+        size_t offset = 0;
+        for (size_t dim = 0; dim < rank; ++dim) {
+          offset = offset * (upper[dim] - lower[dim] + 1) +
+                   (point[dim] - lower[dim]);
+        }
+        block.points.push_back(order[ix]);
+        block.offsets.push_back(offset);
+      }
+      result.push_back(std::move(block));
+    }
+  }
+  return result;
+}
+
+// Check that an hyperslab selects values of a variable
+static void CheckBounds(const Hyperslab& hyperslab,
+                        const std::vector<size_t>& shape) {
+  if (hyperslab.GetRank() != shape.size())
+    throw std::invalid_argument(
+        "the rank of the Hyperslab does not match the rank of the variable");
+  for (size_t ix = 0; ix < shape.size(); ++ix) {
+    // The end of a range may be past the last value selected
+    const Range range = hyperslab.GetRange(ix).Forward();
+    if (range.GetSize() != 0 && range[range.GetSize() - 1] >= shape[ix])
+      throw std::invalid_argument(
+          "Hyperslab defined overlap the "
+          "variable definition");
+  }
+}
+
+// Get the indices [first, last[ of the elements of a range within the
+// interval [lower, upper[
+static void Clip(const Range& range, const size_t lower, const size_t upper,
+                 size_t& first, size_t& last) {
+  const size_t step = range.step();
+  first = range.start() >= lower
+              ? 0
+              : (lower - range.start() + step - 1) / step;
+  last = upper <= range.start()
+             ? 0
+             : std::min(range.GetSize(),
+                        (upper - range.start() + step - 1) / step);
+}
+
+std::vector<ChunkRead> ScheduleChunkReads(
+    const std::vector<Hyperslab>& hyperslabs, const std::vector<size_t>& shape,
+    const std::vector<size_t>& chunks) {
+  const size_t rank = shape.size();
+  if (chunks.size() != rank)
+    throw std::invalid_argument(
+        "the chunk sizes do not match the rank of the variable");
+
+  // Number of chunks along each dimension
+  std::vector<size_t> grid(rank);
+  for (size_t dim = 0; dim < rank; ++dim) {
+    grid[dim] = (shape[dim] + chunks[dim] - 1) / chunks[dim];
+  }
+
+  // Chunks touched by each hyperslab, identified by their index in
+  // row-major order
+  std::vector<std::pair<size_t, size_t>> touched;
+  std::vector<std::vector<size_t>> indices(rank);
+  for (size_t item = 0; item < hyperslabs.size(); ++item) {
+    const Hyperslab& hyperslab = hyperslabs[item];
+    CheckBounds(hyperslab, shape);
+    if (hyperslab.GetSize() == 0) continue;
+
+    for (size_t dim = 0; dim < rank; ++dim) {
+      const Range range = hyperslab.GetRange(dim);
+      indices[dim].clear();
+      const size_t back = range[range.GetSize() - 1];
+      for (size_t chunk = range.First() / chunks[dim];
+           chunk <= back / chunks[dim]; ++chunk) {
+        size_t first, last;
+        Clip(range, chunk * chunks[dim], (chunk + 1) * chunks[dim], first,
+             last);
+        if (first < last) indices[dim].push_back(chunk);
+      }
+    }
+
+    std::vector<size_t> index(rank, 0);
+    while (true) {
+      size_t key = 0;
+      for (size_t dim = 0; dim < rank; ++dim) {
+        key = key * grid[dim] + indices[dim][index[dim]];
+      }
+      touched.emplace_back(key, item);
+
+      size_t dim = rank;
+      while (dim-- > 0) {
+        if (++index[dim] < indices[dim].size()) break;
+        index[dim] = 0;
+      }
+      if (dim == static_cast<size_t>(-1)) break;
+    }
+  }
+  std::sort(touched.begin(), touched.end());
+
+  std::vector<ChunkRead> result;
+  std::vector<size_t> lower(rank), upper(rank);
+  std::vector<size_t> first(rank * hyperslabs.size());
+  std::vector<size_t> last(rank * hyperslabs.size());
+
+  for (size_t begin = 0; begin < touched.size();) {
+    const size_t key = touched[begin].first;
+    size_t end = begin + 1;
+    while (end < touched.size() && touched[end].first == key) ++end;
+
+    // Values of the chunk
+    size_t remaining = key;
+    for (size_t dim = rank; dim-- > 0;) {
+      lower[dim] = (remaining % grid[dim]) * chunks[dim];
+      upper[dim] = std::min(lower[dim] + chunks[dim], shape[dim]);
+      remaining /= grid[dim];
+    }
+
+    // Box bounding the values selected in the chunk
+    std::vector<size_t> start(rank, std::numeric_limits<size_t>::max());
+    std::vector<size_t> stop(rank, 0);
+    for (size_t ix = begin; ix < end; ++ix) {
+      const size_t item = touched[ix].second;
+      for (size_t dim = 0; dim < rank; ++dim) {
+        const Range range = hyperslabs[item].GetRange(dim);
+        size_t& head = first[item * rank + dim];
+        size_t& tail = last[item * rank + dim];
+        Clip(range, lower[dim], upper[dim], head, tail);
+        start[dim] = std::min(start[dim], range[head]);
+        stop[dim] = std::max(stop[dim], range[tail - 1] + 1);
+      }
+    }
+
+    ChunkRead read{Hyperslab(start, stop), {}};
+    std::vector<size_t> box_stride(rank);
+    size_t stride = 1;
+    for (size_t dim = rank; dim-- > 0;) {
+      box_stride[dim] = stride;
+      stride *= stop[dim] - start[dim];
+    }
+
+    for (size_t ix = begin; ix < end; ++ix) {
+      const size_t item = touched[ix].second;
+      const std::vector<Range> ranges = hyperslabs[item].range();
+      ChunkExtract extract{item, 0, 0, std::vector<size_t>(rank),
+                           std::vector<size_t>(rank),
+                           std::vector<size_t>(rank)};
+      stride = 1;
+      for (size_t dim = rank; dim-- > 0;) {
+        const size_t head = first[item * rank + dim];
+        extract.count[dim] = last[item * rank + dim] - head;
+        extract.src += (ranges[dim][head] - start[dim]) * box_stride[dim];
+        extract.src_stride[dim] = ranges[dim].step() * box_stride[dim];
+        extract.dst += head * stride;
+        extract.dst_stride[dim] = stride;
+        stride *= ranges[dim].GetSize();
+      }
+      read.extracts.push_back(std::move(extract));
+    }
+    result.push_back(std::move(read));
+    begin = end;
+  }
+  return result;
+}
+
+std::vector<size_t> SortByOffset(const std::vector<Hyperslab>& hyperslabs,
+                                 const std::vector<size_t>& shape) {
+  std::vector<size_t> offsets(hyperslabs.size());
+  for (size_t item = 0; item < hyperslabs.size(); ++item) {
+    CheckBounds(hyperslabs[item], shape);
+    for (size_t dim = 0; dim < shape.size(); ++dim) {
+      offsets[item] =
+          offsets[item] * shape[dim] + hyperslabs[item].GetRange(dim).First();
+    }
+  }
+
+  std::vector<size_t> result(hyperslabs.size());
+  for (size_t ix = 0; ix < result.size(); ++ix) result[ix] = ix;
+  std::stable_sort(result.begin(), result.end(),
+                   [&](const size_t lhs, const size_t rhs) {
+                     return offsets[lhs] < offsets[rhs];
+                   });
+  return result;
+}
+
+bool ReadEnclosingBox(const Hyperslab& hyperslab, const size_t request_cost) {
+  const size_t selected = hyperslab.GetSize();
+  if (selected == 0 || hyperslab.OnlyAdjacent()) return false;
+
+  // The last value selected may be before the end of a range
+  size_t box = 1;
+  for (auto& item : hyperslab.Forward().range()) {
+    box *= item[item.GetSize() - 1] - item.First() + 1;
+  }
+
+  const Range last = hyperslab.GetRange(hyperslab.GetRank() - 1);
+  const size_t requests =
+      last.OnlyAdjacent() ? selected / last.GetSize() : selected;
+  return box <= requests * request_cost + selected;
+}
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Reverse a row of values of 4 or 8 bytes, swapping 32 bytes from both ends
+// at a time. Returns the number of values swapped at each end.
+__attribute__((target("avx2"))) static size_t ReverseAvx2(
+    unsigned char* values, const size_t count, const size_t width) {
+  if (width != 4 && width != 8) return 0;
+  const size_t lanes = 32 / width;
+  const __m256i order = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  size_t ix = 0;
+  for (; (ix + lanes) * 2 <= count; ix += lanes) {
+    auto head = reinterpret_cast<__m256i*>(values + ix * width);
+    auto tail =
+        reinterpret_cast<__m256i*>(values + (count - ix - lanes) * width);
+    __m256i x = _mm256_loadu_si256(head);
+    __m256i y = _mm256_loadu_si256(tail);
+    if (width == 4) {
+      x = _mm256_permutevar8x32_epi32(x, order);
+      y = _mm256_permutevar8x32_epi32(y, order);
+    } else {
+      x = _mm256_permute4x64_epi64(x, 0x1B);
+      y = _mm256_permute4x64_epi64(y, 0x1B);
+    }
+    _mm256_storeu_si256(head, y);
+    _mm256_storeu_si256(tail, x);
+  }
+  return ix;
+}
+#endif
+
+// Reverse the values of width bytes between first and last
+template <typename T>
+static void ReverseRow(unsigned char* values, const size_t first,
+                       const size_t last) {
+  std::reverse(reinterpret_cast<T*>(values) + first,
+               reinterpret_cast<T*>(values) + last);
+}
+
+// Reverse a row of count values of width bytes
+static void ReverseRow(unsigned char* values, const size_t count,
+                       const size_t width) {
+  size_t processed = 0;
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2) processed = ReverseAvx2(values, count, width);
+#endif
+  const size_t last = count - processed;
+  switch (width) {
+    case 1:
+      ReverseRow<uint8_t>(values, processed, last);
+      break;
+    case 2:
+      ReverseRow<uint16_t>(values, processed, last);
+      break;
+    case 4:
+      ReverseRow<uint32_t>(values, processed, last);
+      break;
+    case 8:
+      ReverseRow<uint64_t>(values, processed, last);
+      break;
+    default:
+      for (size_t ix = processed; ix < count / 2; ++ix) {
+        std::swap_ranges(values + ix * width, values + (ix + 1) * width,
+                         values + (count - ix - 1) * width);
+      }
+      break;
+  }
+}
+
+void Reverse(const Hyperslab& hyperslab, void* values, const size_t width) {
+  const std::vector<size_t> size = hyperslab.GetSizeList();
+  const size_t total = hyperslab.GetSize();
+  auto data = static_cast<unsigned char*>(values);
+  if (total == 0) return;
+
+  // Number of bytes of the values following an element of each dimension
+  size_t block = width;
+  for (size_t dim = size.size(); dim-- > 0;) {
+    const size_t count = size[dim];
+    if (hyperslab.GetRange(dim).IsReversed() && count > 1) {
+      const size_t length = block * count;
+      for (size_t offset = 0; offset < total * width; offset += length) {
+        // The last dimension is reversed value by value, the others block
+        // by block
+        if (block == width) {
+          ReverseRow(data + offset, count, width);
+          continue;
+        }
+        for (size_t ix = 0; ix < count / 2; ++ix) {
+          std::swap_ranges(data + offset + ix * block,
+                           data + offset + (ix + 1) * block,
+                           data + offset + (count - ix - 1) * block);
+        }
+      }
+    }
+    block *= count;
+  }
+}
+
+}  // namespace netcdf
@@ -0,0 +1,41 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// The kernels using the x86 vector instructions are compiled with the
+// attribute target: the code generated runs on any CPU of the family and the
+// kernels are called only if the CPU supports them.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NETCDF4_CXX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace netcdf {
+
+#ifdef NETCDF4_CXX_X86_SIMD
+/**
+ * Check if the CPU supports AVX2
+ *
+ * @return true if the AVX2 instructions can be used
+ */
+inline bool HasAvx2() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+#endif
+
+}  // namespace netcdf
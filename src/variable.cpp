@@ -14,12 +14,18 @@
    along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
 #include <list>
 #include <netcdf4_cxx/abstract_dataset.hpp>
 #include <netcdf4_cxx/attribute.hpp>
 #include <netcdf4_cxx/group.hpp>
 #include <netcdf4_cxx/object.hpp>
+#include <netcdf4_cxx/selection.hpp>
 #include <netcdf4_cxx/variable.hpp>
+#include <vector>
+#include "simd.hpp"
 
 namespace netcdf {
 
@@ -59,22 +65,152 @@ bool Variable::IsCoordinate() const {
   return false;
 }
 
-#define __NETCDF4CXX_READ_VAR(_type, _sufix)                                \
-  template <>                                                               \
-  std::valarray<_type> Variable::Read(const Hyperslab& hyperslab) const {   \
-    if (hyperslab > GetShape())                                             \
-      throw std::invalid_argument(                                          \
-          "Hyperslab defined overlap the "                                  \
-          "variable definition");                                           \
-    std::valarray<_type> values(hyperslab.GetSize());                       \
-    if (hyperslab.OnlyAdjacent())                                           \
-      Check(nc_get_vara_##_sufix(nc_id_, id_, &hyperslab.start()[0],        \
-                                 &hyperslab.GetSizeList()[0], &values[0])); \
-    else                                                                    \
-      Check(nc_get_vars_##_sufix(nc_id_, id_, &hyperslab.start()[0],        \
-                                 &hyperslab.GetSizeList()[0],               \
-                                 &hyperslab.step()[0], &values[0]));        \
-    return values;                                                          \
+// Maximum number of values of a box read at once
+static const size_t kTileSize = 1 << 20;
+
+#ifdef NETCDF4_CXX_X86_SIMD
+
+// Gather the values of 4 or 8 bytes, eight or four at a time. Returns the
+// number of values processed.
+__attribute__((target("avx2"))) static size_t DecimateAvx2(
+    const unsigned char* src, const size_t stride, const size_t count,
+    const size_t width, unsigned char* dst) {
+  size_t ix = 0;
+  if (width == 4 && stride <= INT32_MAX / 8) {
+    const int step = static_cast<int>(stride);
+    const __m256i index = _mm256_setr_epi32(0, step, 2 * step, 3 * step,
+                                            4 * step, 5 * step, 6 * step,
+                                            7 * step);
+    for (; ix + 8 <= count; ix += 8) {
+      const __m256i x = _mm256_i32gather_epi32(
+          reinterpret_cast<const int*>(src + ix * stride * 4), index, 4);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ix * 4), x);
+    }
+  } else if (width == 8) {
+    const long long step = static_cast<long long>(stride);
+    const __m256i index = _mm256_setr_epi64x(0, step, 2 * step, 3 * step);
+    for (; ix + 4 <= count; ix += 4) {
+      const __m256i x = _mm256_i64gather_epi64(
+          reinterpret_cast<const long long*>(src + ix * stride * 8), index, 8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ix * 8), x);
+    }
+  }
+  return ix;
+}
+#endif
+
+// Copy count values of width bytes, spaced by stride values
+static void Decimate(const unsigned char* src, const size_t stride,
+                     const size_t count, const size_t width,
+                     unsigned char* dst) {
+  if (stride == 1) {
+    memcpy(dst, src, count * width);
+    return;
+  }
+  size_t processed = 0;
+#ifdef NETCDF4_CXX_X86_SIMD
+  static const bool avx2 = HasAvx2();
+  if (avx2) processed = DecimateAvx2(src, stride, count, width, dst);
+#endif
+  for (size_t ix = processed; ix < count; ++ix) {
+    memcpy(dst + ix * width, src + ix * stride * width, width);
+  }
+}
+
+// Read the values selected by an hyperslab with steps from the box enclosing
+// them, tile by tile along the first dimension. The tiles of a chunked
+// variable end on the boundary of a chunk, so that each chunk is read once.
+template <typename T>
+static void ReadBox(const int nc_id, const int id,
+                    const std::vector<size_t>& chunks,
+                    const Hyperslab& hyperslab, T* values,
+                    int (*get)(int, int, const size_t*, const size_t*, T*)) {
+  const std::vector<Range> ranges = hyperslab.range();
+  const size_t rank = ranges.size();
+  const size_t last = rank - 1;
+
+  // Shape of the box, and distance between two values of each dimension
+  std::vector<size_t> start(rank);
+  std::vector<size_t> count(rank);
+  std::vector<size_t> strides(rank);
+  size_t row = 1;
+  for (size_t dim = rank; dim-- > 1;) {
+    start[dim] = ranges[dim].First();
+    count[dim] = ranges[dim][ranges[dim].GetSize() - 1] - start[dim] + 1;
+    strides[dim] = row;
+    row *= count[dim];
+  }
+  strides[0] = row;
+
+  // Number of values selected per element of the first dimension
+  const size_t selected = hyperslab.GetSize() / ranges[0].GetSize();
+  const Range& outer = ranges[0];
+  const size_t step = outer.step();
+  const size_t budget = std::max<size_t>(1, kTileSize / row);
+  std::vector<T> staging;
+  std::vector<size_t> index(rank);
+  std::vector<size_t> size = hyperslab.GetSizeList();
+
+  for (size_t ix = 0; ix < outer.GetSize();) {
+    const size_t first = outer[ix];
+    size_t limit = first + budget;
+    if (!chunks.empty()) {
+      const size_t aligned = limit / chunks[0] * chunks[0];
+      limit = aligned > first ? aligned : (first / chunks[0] + 1) * chunks[0];
+    }
+    const size_t n =
+        std::min(outer.GetSize() - ix, (limit - first + step - 1) / step);
+    start[0] = first;
+    count[0] = (n - 1) * step + 1;
+    staging.resize(count[0] * row);
+    Check(get(nc_id, id, &start[0], &count[0], &staging[0]));
+
+    // Keep the values selected, row by row of the last dimension
+    size[0] = n;
+    std::fill(index.begin(), index.end(), 0);
+    auto dst = reinterpret_cast<unsigned char*>(values + ix * selected);
+    while (true) {
+      size_t offset = 0;
+      for (size_t dim = 0; dim < last; ++dim) {
+        offset += index[dim] * ranges[dim].step() * strides[dim];
+      }
+      Decimate(reinterpret_cast<const unsigned char*>(&staging[offset]),
+               ranges[last].step(), size[last], sizeof(T), dst);
+      dst += size[last] * sizeof(T);
+
+      size_t dim = last;
+      while (dim-- > 0) {
+        if (++index[dim] < size[dim]) break;
+        index[dim] = 0;
+      }
+      if (dim == static_cast<size_t>(-1)) break;
+    }
+    ix += n;
+  }
+}
+
+#define __NETCDF4CXX_READ_VAR(_type, _sufix)                                  \
+  template <>                                                                 \
+  void Variable::Read(const Hyperslab& hyperslab, _type* values) const {      \
+    if (hyperslab.IsReversed()) {                                             \
+      Read(hyperslab.Forward(), values);                                      \
+      Reverse(hyperslab, values, sizeof(_type));                              \
+      return;                                                                 \
+    }                                                                         \
+    if (hyperslab > GetShape())                                               \
+      throw std::invalid_argument(                                            \
+          "Hyperslab defined overlap the "                                    \
+          "variable definition");                                             \
+    if (hyperslab.OnlyAdjacent())                                             \
+      Check(nc_get_vara_##_sufix(nc_id_, id_, &hyperslab.start()[0],          \
+                                 &hyperslab.GetSizeList()[0], values));       \
+    else if (ReadEnclosingBox(hyperslab))                                     \
+      ReadBox(nc_id_, id_, GetChunking(), hyperslab, values,                  \
+              nc_get_vara_##_sufix);                                          \
+    else                                                                      \
+      Check(nc_get_vars_##_sufix(nc_id_, id_, &hyperslab.start()[0],          \
+                                 &hyperslab.GetSizeList()[0],                 \
+                                 &hyperslab.step()[0], values));              \
   }
 
 __NETCDF4CXX_READ_VAR(signed char, schar)
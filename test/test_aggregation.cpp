@@ -0,0 +1,167 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <memory>
+#include <netcdf4_cxx/aggregation.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_aggregation)
+
+// Write three files holding t(time, x) = time * 10 + x, the time
+// dimension having a length of 2, 3 and 4
+static std::vector<std::unique_ptr<TempFile>> WriteFiles() {
+  std::vector<std::unique_ptr<TempFile>> result;
+  TempFile base;
+  size_t offset = 0;
+  for (size_t length : {2, 3, 4}) {
+    result.emplace_back(new TempFile(base.Path() + "_" +
+                                     std::to_string(result.size()) + ".nc"));
+    netcdf::File file(result.back()->Path(), "w");
+    auto time = file.AddDimension("time", length);
+    auto x = file.AddDimension("x", 5);
+    auto coordinate =
+        file.AddVariable("time", netcdf::type::Double(file), {time});
+    auto variable =
+        file.AddVariable("t", netcdf::type::Double(file), {time, x});
+
+    std::valarray<double> times(length);
+    std::valarray<double> values(length * 5);
+    for (size_t ix = 0; ix < length; ++ix) {
+      times[ix] = (offset + ix) * 0.5;
+      for (size_t jx = 0; jx < 5; ++jx) {
+        values[ix * 5 + jx] = (offset + ix) * 10 + jx;
+      }
+    }
+    coordinate.Write(times);
+    variable.Write(values);
+    offset += length;
+  }
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE(test_join_existing) {
+  auto files = WriteFiles();
+  std::vector<std::string> paths(
+      {files[2]->Path(), files[0]->Path(), files[1]->Path()});
+
+  netcdf::AggregatedVariable variable(paths, "t");
+  BOOST_CHECK_EQUAL(variable.GetRank(), 2);
+  BOOST_CHECK_EQUAL(variable.GetShape()[0], 9);
+  BOOST_CHECK_EQUAL(variable.GetShape()[1], 5);
+  BOOST_CHECK_EQUAL(variable.GetPaths()[0], files[0]->Path());
+
+  auto& coordinate = variable.GetCoordinate();
+  BOOST_REQUIRE_EQUAL(coordinate.size(), 9);
+  for (size_t ix = 0; ix < 9; ++ix) BOOST_CHECK_EQUAL(coordinate[ix], ix * 0.5);
+
+  auto values = variable.Read<double>();
+  BOOST_REQUIRE_EQUAL(values.size(), 45);
+  for (size_t ix = 0; ix < 45; ++ix) {
+    BOOST_CHECK_EQUAL(values[ix], (ix / 5) * 10 + ix % 5);
+  }
+
+  // The values are converted to the type requested
+  BOOST_CHECK_EQUAL(variable.Read<int>()[44], 84);
+
+  // Every other element, across the three files
+  netcdf::Hyperslab strided(std::vector<size_t>({1, 1}),
+                            std::vector<size_t>({9, 4}),
+                            std::vector<ptrdiff_t>({2, 2}));
+  values = variable.Read<double>(strided);
+  BOOST_REQUIRE_EQUAL(values.size(), 8);
+  for (size_t ix = 0; ix < 4; ++ix) {
+    BOOST_CHECK_EQUAL(values[ix * 2], (1 + ix * 2) * 10 + 1);
+    BOOST_CHECK_EQUAL(values[ix * 2 + 1], (1 + ix * 2) * 10 + 3);
+  }
+
+  // Inside a single file
+  netcdf::Hyperslab subset(std::vector<size_t>({6, 2}),
+                           std::vector<size_t>({8, 3}));
+  values = variable.Read<double>(subset);
+  BOOST_REQUIRE_EQUAL(values.size(), 2);
+  BOOST_CHECK_EQUAL(values[0], 62);
+  BOOST_CHECK_EQUAL(values[1], 72);
+
+  // The end of the ranges is past the shape of the variable
+  netcdf::Hyperslab overshoot(std::vector<size_t>({0, 1}),
+                              std::vector<size_t>({10, 6}),
+                              std::vector<ptrdiff_t>({4, 3}));
+  values = variable.Read<double>(overshoot);
+  BOOST_REQUIRE_EQUAL(values.size(), 6);
+  for (size_t ix = 0; ix < 3; ++ix) {
+    BOOST_CHECK_EQUAL(values[ix * 2], ix * 40 + 1);
+    BOOST_CHECK_EQUAL(values[ix * 2 + 1], ix * 40 + 4);
+  }
+
+  BOOST_CHECK_THROW(variable.Read<double>(netcdf::Hyperslab(
+                        std::vector<size_t>({10, 5}))),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::AggregatedVariable(paths, "missing"),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(
+      netcdf::AggregatedVariable(std::vector<std::string>(), "t"),
+      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_join_new) {
+  auto files = WriteFiles();
+  std::vector<std::string> paths({files[1]->Path(), files[1]->Path()});
+
+  netcdf::AggregatedVariable variable(paths, "t",
+                                      netcdf::Aggregation::kJoinNew);
+  BOOST_CHECK_EQUAL(variable.GetRank(), 3);
+  BOOST_CHECK_EQUAL(variable.GetShape()[0], 2);
+  BOOST_CHECK_EQUAL(variable.GetShape()[1], 3);
+  BOOST_CHECK_EQUAL(variable.GetCoordinate()[1], 1);
+
+  netcdf::Hyperslab hyperslab(std::vector<size_t>({0, 1, 4}),
+                              std::vector<size_t>({2, 3, 5}));
+  auto values = variable.Read<double>(hyperslab);
+  BOOST_REQUIRE_EQUAL(values.size(), 4);
+  BOOST_CHECK_EQUAL(values[0], 34);
+  BOOST_CHECK_EQUAL(values[1], 44);
+  BOOST_CHECK_EQUAL(values[2], 34);
+  BOOST_CHECK_EQUAL(values[3], 44);
+
+  // The files must hold variables of the same shape
+  paths.push_back(files[2]->Path());
+  netcdf::AggregatedVariable mismatch(paths, "t",
+                                      netcdf::Aggregation::kJoinNew);
+  BOOST_CHECK_THROW(mismatch.Read<double>(), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_open_files) {
+  auto files = WriteFiles();
+  std::vector<std::string> paths;
+  for (auto& item : files) paths.push_back(item->Path());
+
+  netcdf::AggregatedVariable variable(
+      paths, "t", netcdf::Aggregation::kJoinExisting, 2);
+  BOOST_CHECK_EQUAL(variable.GetOpenFiles(), 2);
+  auto values = variable.Read<double>();
+  BOOST_CHECK_EQUAL(variable.GetOpenFiles(), 2);
+  BOOST_CHECK_EQUAL(values[44], 84);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
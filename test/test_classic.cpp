@@ -0,0 +1,252 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <netcdf4_cxx/classic.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_classic)
+
+BOOST_AUTO_TEST_CASE(test_byte_swap) {
+  std::vector<unsigned char> in(1003 * 8), out(in.size());
+  for (size_t ix = 0; ix < in.size(); ++ix) {
+    in[ix] = static_cast<unsigned char>(ix * 7 + 3);
+  }
+  for (size_t width : {1, 2, 4, 8}) {
+    size_t count = in.size() / width;
+    netcdf::classic::ByteSwap(in.data(), out.data(), count, width);
+    for (size_t ix = 0; ix < count * width; ++ix) {
+      size_t value = ix / width * width;
+      BOOST_REQUIRE_EQUAL(out[ix], in[value + width - 1 - ix % width]);
+    }
+    auto inplace = in;
+    netcdf::classic::ByteSwap(inplace.data(), inplace.data(), count, width);
+    BOOST_CHECK(inplace == out);
+  }
+  BOOST_CHECK_THROW(netcdf::classic::ByteSwap(in.data(), out.data(), 1, 3),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_header) {
+  netcdf::classic::Header header;
+  BOOST_CHECK_EQUAL(netcdf::classic::Header::Parse("CDF\1", 4, header), 0);
+  BOOST_CHECK_THROW(netcdf::classic::Header::Parse("HDF\1", 4, header),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(netcdf::classic::Header::Parse("CDF\3", 4, header),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(netcdf::classic::Header("CDF\1", 4), std::runtime_error);
+}
+
+// Encode a CDF-1 header defining the variable "v" of doubles over the
+// dimensions given, the first dimension being the record dimension if its
+// length is zero
+static std::string CorruptHeader(const uint32_t records,
+                                 const std::vector<uint32_t>& dimensions) {
+  std::string result("CDF\1");
+  auto append = [&result](const uint32_t value) {
+    for (int shift : {24, 16, 8, 0}) {
+      result.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+  };
+  append(records);
+  append(0x0A);
+  append(static_cast<uint32_t>(dimensions.size()));
+  for (size_t ix = 0; ix < dimensions.size(); ++ix) {
+    append(1);
+    result.push_back(static_cast<char>('a' + ix));
+    result.append(3, '\0');
+    append(dimensions[ix]);
+  }
+  append(0);
+  append(0);
+  append(0x0B);
+  append(1);
+  append(1);
+  result.append("v\0\0\0", 4);
+  append(static_cast<uint32_t>(dimensions.size()));
+  for (size_t ix = 0; ix < dimensions.size(); ++ix) {
+    append(static_cast<uint32_t>(ix));
+  }
+  append(0);
+  append(0);
+  append(NC_DOUBLE);
+  append(0);
+  append(static_cast<uint32_t>(result.size() + 4));
+  return result;
+}
+
+BOOST_AUTO_TEST_CASE(test_corrupt_header) {
+  netcdf::classic::Header header;
+
+  // The size of the variable does not fit on 64 bits
+  auto bytes = CorruptHeader(0, {0xFFFFFFFF, 0xFFFFFFFF});
+  BOOST_CHECK_THROW(
+      netcdf::classic::Header::Parse(bytes.data(), bytes.size(), header),
+      std::runtime_error);
+  bytes = CorruptHeader(1, {0, 0xFFFFFFFF, 0xFFFFFFFF});
+  BOOST_CHECK_THROW(
+      netcdf::classic::Header::Parse(bytes.data(), bytes.size(), header),
+      std::runtime_error);
+
+  // The end of the last record does not fit on 64 bits
+  TempFile temp;
+  {
+    std::ofstream stream(temp.Path(), std::ios::binary);
+    bytes = CorruptHeader(0x80000000, {0, 0x40000000});
+    stream.write(bytes.data(), bytes.size());
+    stream.write(std::string(64, '\0').data(), 64);
+  }
+  netcdf::classic::Reader reader(temp.Path());
+  BOOST_CHECK_EQUAL(reader.header().records(), 0x80000000);
+  BOOST_CHECK_THROW(reader.GetView<double>("v"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_reader) {
+  for (auto format :
+       {netcdf::Format::kClassicNetCdf3, netcdf::Format::k64BitsNetCdf3}) {
+    TempFile temp;
+    {
+      netcdf::File file(temp.Path(), "w", true, false, false, format);
+      auto time = file.AddUnlimitedDimension("time");
+      auto x = file.AddDimension("x", 5);
+      auto y = file.AddDimension("y", 3);
+      file.AddAttribute("title").WriteText("classic");
+      auto a = file.AddVariable("a", netcdf::type::Double(file),
+                                std::vector<netcdf::Dimension>({x, y}));
+      auto s = file.AddVariable("s", netcdf::type::Short(file),
+                                std::vector<netcdf::Dimension>({x}));
+      auto t = file.AddVariable("t", netcdf::type::Float(file),
+                                std::vector<netcdf::Dimension>({time, x}));
+      auto r = file.AddVariable("r", netcdf::type::Short(file),
+                                std::vector<netcdf::Dimension>({time}));
+      file.LeaveDefineMode();
+
+      std::valarray<double> a_values(15);
+      for (size_t ix = 0; ix < a_values.size(); ++ix) a_values[ix] = ix * 1.5;
+      a.Write(a_values);
+      std::valarray<short> s_values({0, -1, -2, -3, -4});
+      s.Write(s_values);
+      std::valarray<float> t_values(15);
+      for (size_t ix = 0; ix < t_values.size(); ++ix) {
+        t_values[ix] = (ix / 5) * 10 + ix % 5 + 0.25f;
+      }
+      t.Write(netcdf::Hyperslab(std::vector<size_t>({0, 0}),
+                                std::vector<size_t>({3, 5})),
+              t_values);
+      std::valarray<short> r_values({100, 101, 102});
+      r.Write(netcdf::Hyperslab(std::vector<size_t>({0}),
+                                std::vector<size_t>({3})),
+              r_values);
+    }
+
+    netcdf::classic::Reader reader(temp.Path());
+    auto& header = reader.header();
+    BOOST_CHECK_EQUAL(header.records(), 3);
+    BOOST_CHECK_EQUAL(header.dimensions().size(), 3);
+    BOOST_CHECK_EQUAL(header.variables().size(), 4);
+    BOOST_REQUIRE(header.FindAttribute("title") != nullptr);
+    BOOST_CHECK_EQUAL(header.FindAttribute("title")->value, "classic");
+
+    netcdf::File file(temp.Path());
+    auto a = reader.Read<double>("a");
+    auto a_expected = file.FindVariable("a")->Read<double>();
+    BOOST_REQUIRE_EQUAL(a.size(), a_expected.size());
+    for (size_t ix = 0; ix < a.size(); ++ix) {
+      BOOST_CHECK_EQUAL(a[ix], a_expected[ix]);
+    }
+
+    // Record variables are strided views over the records
+    auto t = reader.GetView<float>("t");
+    auto t_expected = file.FindVariable("t")->Read<float>();
+    BOOST_CHECK(!t.contiguous());
+    BOOST_REQUIRE_EQUAL(t.size(), t_expected.size());
+    for (size_t ix = 0; ix < t.size(); ++ix) {
+      BOOST_CHECK_EQUAL(t[ix], t_expected[ix]);
+    }
+
+    auto s = reader.GetView<short>("s");
+    BOOST_CHECK(s.contiguous());
+    BOOST_REQUIRE_EQUAL(s.size(), 5);
+    BOOST_CHECK_EQUAL(s[4], -4);
+
+    auto r = reader.Read<short>("r");
+    BOOST_REQUIRE_EQUAL(r.size(), 3);
+    BOOST_CHECK_EQUAL(r[0], 100);
+    BOOST_CHECK_EQUAL(r[2], 102);
+
+    std::vector<float> block(4);
+    reader.GetView<float>("t").CopyTo(3, 4, block.data());
+    BOOST_CHECK_EQUAL(block[0], 3.25f);
+    BOOST_CHECK_EQUAL(block[2], 10.25f);
+
+    BOOST_CHECK_THROW(reader.GetView<int>("a"), std::invalid_argument);
+    BOOST_CHECK_THROW(reader.GetView<int>("z"), std::invalid_argument);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_scan) {
+  TempFile temp;
+  {
+    netcdf::File file(temp.Path(), "w", true, false, false,
+                      netcdf::Format::k64BitsNetCdf3);
+    file.AddUnlimitedDimension("time");
+    auto x = file.AddDimension("x", 7);
+    file.AddAttribute("title").WriteText("scan");
+    auto var = file.AddVariable("var", netcdf::type::Short(file),
+                                std::vector<netcdf::Dimension>({x}));
+    var.AddAttribute("scale_factor")
+        .Write(netcdf::type::Double(file), std::vector<double>{0.01});
+    var.AddAttribute("valid_range")
+        .Write(netcdf::type::Short(file), std::vector<short>{-100, 100});
+  }
+
+  // Headers larger than the first read are completed
+  for (size_t read_size : {4, 64, 16384}) {
+    auto header = netcdf::classic::Header::Scan(temp.Path(), read_size);
+    BOOST_CHECK(header.version() == netcdf::classic::Version::k64BitOffset);
+    BOOST_REQUIRE_EQUAL(header.dimensions().size(), 2);
+    BOOST_CHECK_EQUAL(header.dimensions()[0].name, "time");
+    BOOST_CHECK_EQUAL(header.dimensions()[0].length, 0);
+    BOOST_CHECK_EQUAL(header.dimensions()[1].length, 7);
+    BOOST_CHECK_EQUAL(header.FindAttribute("title")->ReadText(), "scan");
+
+    auto var = header.FindVariable("var");
+    BOOST_REQUIRE(var != nullptr);
+    BOOST_CHECK_EQUAL(var->GetRank(), 1);
+    BOOST_CHECK(!var->record);
+    BOOST_CHECK(var->type == netcdf::type::Primitive::kShort);
+    BOOST_CHECK_EQUAL(
+        var->FindAttribute("scale_factor")->Read<double>().at(0), 0.01);
+    auto valid_range = var->FindAttribute("valid_range")->Read<short>();
+    BOOST_REQUIRE_EQUAL(valid_range.size(), 2);
+    BOOST_CHECK_EQUAL(valid_range[0], -100);
+    BOOST_CHECK_EQUAL(valid_range[1], 100);
+    BOOST_CHECK_THROW(var->FindAttribute("valid_range")->Read<int>(),
+                      std::invalid_argument);
+  }
+
+  TempFile missing;
+  BOOST_CHECK_THROW(netcdf::classic::Header::Scan(missing.Path()),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -75,6 +75,38 @@ BOOST_AUTO_TEST_CASE(type_constructors) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_memory) {
+  std::valarray<int> values({0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+
+  for (auto format :
+       {netcdf::Format::kNetCdf4, netcdf::Format::kClassicNetCdf3}) {
+    netcdf::File file;
+    file.CreateInMemory(format);
+    BOOST_CHECK(file.GetFormat() == format);
+    auto dim = file.AddDimension("x", 10);
+    auto var = file.AddVariable("var", netcdf::type::Int(file),
+                                std::vector<netcdf::Dimension>({dim}));
+    file.AddAttribute("title").WriteText("in memory");
+    file.LeaveDefineMode();
+    var.Write(values);
+
+    netcdf::MemoryImage image = file.CloseToBuffer();
+    BOOST_REQUIRE(!image.empty());
+    BOOST_CHECK(image.data() != nullptr);
+
+    netcdf::File copy;
+    copy.OpenMemory(image.data(), image.size());
+    BOOST_CHECK(copy.GetFormat() == format);
+    BOOST_CHECK_EQUAL(copy.GetTitle(), "in memory");
+    auto read = copy.FindVariable("var")->Read<int>();
+    BOOST_REQUIRE_EQUAL(read.size(), values.size());
+    for (size_t ix = 0; ix < read.size(); ++ix) {
+      BOOST_CHECK_EQUAL(read[ix], values[ix]);
+    }
+    copy.Close();
+  }
+}
+
 // BOOST_AUTO_TEST_CASE( test_copy ) {
 //   netcdf::File src, tgt;
 //   src.Open("/Users/fbriol/Documents/workspace/netcdfcpp/test/test.nc");
@@ -0,0 +1,104 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <stdio.h>
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <netcdf4_cxx/file_pool.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_file_pool)
+
+// Create a file holding a dimension of the given length
+static void Write(const std::string& path, const size_t length) {
+  netcdf::File file(path, "w");
+  file.AddDimension("x", length);
+}
+
+BOOST_AUTO_TEST_CASE(test_open) {
+  TempFile first, second, replacement;
+  Write(first.Path(), 1);
+  Write(second.Path(), 2);
+
+  netcdf::FilePool pool(1);
+  BOOST_CHECK_EQUAL(pool.capacity(), 1);
+  BOOST_CHECK_THROW(pool.Open(first.Path(), "w"), std::invalid_argument);
+
+  auto file = pool.Open(first.Path());
+  BOOST_CHECK_EQUAL(pool.Open(first.Path()), file);
+  BOOST_CHECK_EQUAL(pool.size(), 1);
+
+  // The first file is released but stays open while it is used
+  auto other = pool.Open(second.Path());
+  BOOST_CHECK_EQUAL(pool.size(), 1);
+  BOOST_CHECK_EQUAL(file->FindDimension("x")->GetLength(), 1);
+  BOOST_CHECK(pool.Open(first.Path()) != file);
+
+  // A file replaced on disk is opened again
+  pool.SetCapacity(2);
+  file = pool.Open(first.Path());
+  Write(replacement.Path(), 3);
+  BOOST_REQUIRE_EQUAL(
+      rename(replacement.Path().c_str(), first.Path().c_str()), 0);
+  auto reopened = pool.Open(first.Path());
+  BOOST_CHECK(reopened != file);
+  BOOST_CHECK_EQUAL(reopened->FindDimension("x")->GetLength(), 3);
+  BOOST_CHECK_EQUAL(pool.Open(first.Path()), reopened);
+
+  BOOST_CHECK(pool.Erase(first.Path()));
+  BOOST_CHECK(!pool.Erase(first.Path()));
+  pool.Clear();
+  BOOST_CHECK_EQUAL(pool.size(), 0);
+  BOOST_CHECK_EQUAL(&netcdf::FilePool::Instance(),
+                    &netcdf::FilePool::Instance());
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_open) {
+  TempFile temp, missing;
+  Write(temp.Path(), 1);
+
+  // The threads opening the same file share the handle opened by the first
+  netcdf::FilePool pool(2);
+  std::vector<std::shared_ptr<netcdf::File>> files(8);
+  std::vector<int> errors(files.size());
+  std::vector<std::thread> threads;
+  for (size_t ix = 0; ix < files.size(); ++ix) {
+    threads.emplace_back([&, ix] {
+      files[ix] = pool.Open(temp.Path());
+      try {
+        pool.Open(missing.Path());
+      } catch (std::runtime_error&) {
+        errors[ix] = 1;
+      }
+    });
+  }
+  for (auto& item : threads) item.join();
+  for (size_t ix = 0; ix < files.size(); ++ix) {
+    BOOST_CHECK_EQUAL(files[ix], files[0]);
+    BOOST_CHECK_EQUAL(errors[ix], 1);
+  }
+  BOOST_CHECK_EQUAL(pool.size(), 1);
+  BOOST_CHECK_THROW(pool.SetCapacity(0), std::invalid_argument);
+  BOOST_CHECK_EQUAL(pool.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
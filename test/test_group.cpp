@@ -192,6 +192,77 @@ BOOST_AUTO_TEST_CASE(test_walk) {
   BOOST_CHECK(d.FindGroup("c") == nullptr);
 }
 
+BOOST_AUTO_TEST_CASE(test_tree) {
+  Object object;
+  netcdf::Group root(object);
+  netcdf::Group a = root.AddGroup("a");
+  netcdf::Group b = root.AddGroup("b");
+  netcdf::Group c = b.AddGroup("c");
+  netcdf::Group d = b.AddGroup("d");
+  d.AddGroup("e");
+  a.AddAttribute("a1").WriteText("x");
+  a.AddAttribute("a2").WriteText("y");
+  a.AddAttribute("a3").WriteText("z");
+  a.AddVariable("v1", netcdf::type::Int(object));
+  a.AddVariable("v2", netcdf::type::Int(object));
+
+  auto names = [](const netcdf::Group& group, netcdf::TraversalOrder order) {
+    std::string result;
+    for (auto it = group.Tree(order).begin(); it != group.Tree(order).end();
+         ++it) {
+      result += it->GetShortName() + std::to_string(it.depth());
+    }
+    return result;
+  };
+  BOOST_CHECK_EQUAL(names(root, netcdf::TraversalOrder::kPreOrder),
+                    "a1b1c2d2e3");
+  BOOST_CHECK_EQUAL(names(root, netcdf::TraversalOrder::kPostOrder),
+                    "a1c2e3d2b1");
+  BOOST_CHECK_EQUAL(names(b, netcdf::TraversalOrder::kPreOrder), "c1d1e2");
+  BOOST_CHECK_EQUAL(names(c, netcdf::TraversalOrder::kPreOrder), "");
+
+  size_t count = 0;
+  for (auto& item : root.Tree()) {
+    BOOST_CHECK(item.id() != root.id());
+    ++count;
+  }
+  BOOST_CHECK_EQUAL(count, root.Walk().size());
+
+  std::string visited;
+  BOOST_CHECK(root.Visit([&](const netcdf::Group& group) {
+    visited += group.GetShortName();
+    return group.GetShortName() == "b" ? netcdf::VisitAction::kPrune
+                                       : netcdf::VisitAction::kContinue;
+  }));
+  BOOST_CHECK_EQUAL(visited, "ab");
+
+  visited.clear();
+  BOOST_CHECK(!root.Visit(
+      [&](const netcdf::Group& group) {
+        visited += group.GetShortName();
+        return group.GetShortName() == "c" ? netcdf::VisitAction::kStop
+                                           : netcdf::VisitAction::kContinue;
+      },
+      netcdf::TraversalOrder::kPostOrder));
+  BOOST_CHECK_EQUAL(visited, "ac");
+
+  visited.clear();
+  BOOST_CHECK(a.VisitVariables([&](const netcdf::Variable& variable) {
+    visited += variable.GetShortName();
+    return true;
+  }));
+  BOOST_CHECK_EQUAL(visited, "v1v2");
+
+  visited.clear();
+  BOOST_CHECK(!a.VisitAttributes([&](const netcdf::Attribute& attribute) {
+    visited += attribute.name();
+    return attribute.name() != "a2";
+  }));
+  BOOST_CHECK_EQUAL(visited, "a1a2");
+  BOOST_CHECK(a.FindAttribute("A3", true) != nullptr);
+  BOOST_CHECK(a.FindAttribute("A4", true) == nullptr);
+}
+
 BOOST_AUTO_TEST_CASE(test_split) {
   auto result = netcdf::Group::SplitGroupsAndVariable("a/b/c");
   BOOST_REQUIRE(result.first.size() == 2);
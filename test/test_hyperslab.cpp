@@ -119,6 +119,54 @@ BOOST_AUTO_TEST_CASE(test_built_from_reverse_range) {
   BOOST_CHECK_EQUAL_COLLECTIONS(ref.begin(), ref.end(), res.begin(), res.end());
 }
 
+BOOST_AUTO_TEST_CASE(test_reversed) {
+  netcdf::Range object(12, 1, -3);
+  BOOST_CHECK_EQUAL(object.IsReversed(), true);
+  BOOST_CHECK_EQUAL(object.GetSize(), 4);
+
+  // Same values in increasing order
+  netcdf::Range forward = object.Forward();
+  BOOST_CHECK_EQUAL(forward.IsReversed(), false);
+  std::vector<size_t> ref({3, 6, 9, 12});
+  std::vector<size_t> res = static_cast<std::vector<size_t> >(forward);
+  BOOST_CHECK_EQUAL_COLLECTIONS(ref.begin(), ref.end(), res.begin(), res.end());
+  res = static_cast<std::vector<size_t> >(forward.Reversed());
+  ref = static_cast<std::vector<size_t> >(object);
+  BOOST_CHECK_EQUAL_COLLECTIONS(ref.begin(), ref.end(), res.begin(), res.end());
+
+  // A reversed range including the first element
+  object = netcdf::Range(0, 5).Reversed();
+  BOOST_CHECK_EQUAL(object.IsReversed(), true);
+  ref = std::vector<size_t>({4, 3, 2, 1, 0});
+  res = static_cast<std::vector<size_t> >(object);
+  BOOST_CHECK_EQUAL_COLLECTIONS(ref.begin(), ref.end(), res.begin(), res.end());
+  BOOST_CHECK_EQUAL(object.Forward().First(), 0);
+  BOOST_CHECK_EQUAL(object.Forward().GetSize(), 5);
+  BOOST_CHECK_EQUAL(object.GetSize(), 5);
+  BOOST_CHECK_EQUAL(object.First(), 4);
+  BOOST_CHECK_EQUAL(object.Last(), 0);
+  BOOST_CHECK_EQUAL(object.Contains(0), true);
+  BOOST_CHECK_EQUAL(object.Contains(4), true);
+  BOOST_CHECK_EQUAL(object.Contains(5), false);
+  BOOST_CHECK_EQUAL(object.Index(0), 4);
+  BOOST_CHECK_EQUAL(object.Index(3), 1);
+  BOOST_CHECK_EQUAL(object.Item(4), 0);
+  object = netcdf::Range(0, 9, 3).Reversed();
+  BOOST_CHECK_EQUAL(object.Contains(0), true);
+  BOOST_CHECK_EQUAL(object.Contains(1), false);
+  BOOST_CHECK_EQUAL(object.Index(0), 2);
+
+  BOOST_CHECK_EQUAL(netcdf::Range().Reversed().GetSize(), 0);
+  BOOST_CHECK_EQUAL(netcdf::Range(12, 53, 7).Forward().First(), 12);
+
+  // A negative step from start to a greater end selects nothing
+  object = netcdf::Range(0, 4, -1);
+  BOOST_CHECK_EQUAL(object.IsEmpty(), true);
+  BOOST_CHECK_EQUAL(object.GetSize(), 0);
+  BOOST_CHECK_EQUAL(netcdf::Range(3, 3, -2).GetSize(), 0);
+  BOOST_CHECK_EQUAL(object.Forward().GetSize(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_SUITE(test_hyperslab)
@@ -201,4 +249,39 @@ BOOST_AUTO_TEST_CASE(constructor_with_strides) {
   BOOST_CHECK(object > shape);
 }
 
+BOOST_AUTO_TEST_CASE(constructor_with_negative_strides) {
+  netcdf::Hyperslab object(std::vector<size_t>({9, 2}),
+                           std::vector<size_t>({0, 8}),
+                           std::vector<ptrdiff_t>({-1, 3}));
+  BOOST_CHECK_EQUAL(object.OnlyAdjacent(), false);
+  BOOST_CHECK_EQUAL(object.IsReversed(), true);
+  BOOST_CHECK_EQUAL(object.GetSize(), 18);
+
+  netcdf::Hyperslab forward = object.Forward();
+  BOOST_CHECK_EQUAL(forward.IsReversed(), false);
+  BOOST_CHECK(forward.start() == std::vector<size_t>({1, 2}));
+  BOOST_CHECK(forward.end() == std::vector<size_t>({10, 8}));
+  BOOST_CHECK(forward.step() == std::vector<ptrdiff_t>({1, 3}));
+  BOOST_CHECK_EQUAL(forward.GetSize(), 18);
+
+  // Steps of -1 do not select adjacent values
+  netcdf::Hyperslab flipped(std::vector<netcdf::Range>(
+      {netcdf::Range(0, 4).Reversed(), netcdf::Range(0, 3).Reversed()}));
+  BOOST_CHECK_EQUAL(flipped.OnlyAdjacent(), false);
+  BOOST_CHECK_EQUAL(flipped.Forward().OnlyAdjacent(), true);
+
+  // No value between start and a greater end with a negative step
+  netcdf::Hyperslab empty(std::vector<size_t>({0, 0}),
+                          std::vector<size_t>({4, 3}),
+                          std::vector<ptrdiff_t>({-1, 1}));
+  BOOST_CHECK_EQUAL(empty.GetSize(0), 0);
+  BOOST_CHECK_EQUAL(empty.GetSize(), 0);
+  BOOST_CHECK_EQUAL(empty.Forward().GetSize(), 0);
+
+  BOOST_CHECK_THROW(
+      netcdf::Hyperslab(std::vector<size_t>({1}), std::vector<size_t>({2}),
+                        std::vector<ptrdiff_t>({0})),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
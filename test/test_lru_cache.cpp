@@ -0,0 +1,71 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <netcdf4_cxx/lru_cache.hpp>
+#include <stdexcept>
+#include <string>
+
+BOOST_AUTO_TEST_SUITE(test_lru_cache)
+
+BOOST_AUTO_TEST_CASE(test_eviction) {
+  BOOST_CHECK_THROW((netcdf::LruCache<int, std::string>(0)),
+                    std::invalid_argument);
+
+  netcdf::LruCache<int, std::string> cache(2);
+  BOOST_CHECK(cache.empty());
+  BOOST_CHECK_EQUAL(cache.Insert(1, "one"), "one");
+  cache.Insert(2, "two");
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+
+  // 1 becomes the most recently used: 2 is discarded
+  BOOST_REQUIRE(cache.Find(1) != nullptr);
+  cache.Insert(3, "three");
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK(cache.Find(2) == nullptr);
+  BOOST_CHECK_EQUAL(*cache.Find(1), "one");
+  BOOST_CHECK_EQUAL(*cache.Find(3), "three");
+
+  cache.Insert(3, "THREE");
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(*cache.Find(3), "THREE");
+
+  cache.SetCapacity(1);
+  BOOST_CHECK_EQUAL(cache.size(), 1);
+  BOOST_CHECK(cache.Find(1) == nullptr);
+  BOOST_CHECK(cache.Erase(3));
+  BOOST_CHECK(!cache.Erase(3));
+  BOOST_CHECK(cache.empty());
+
+  // The values are evicted from the least recently used
+  std::string value;
+  cache.SetCapacity(2);
+  cache.Insert(4, "four");
+  cache.Insert(5, "five");
+  BOOST_CHECK(cache.Evict(value));
+  BOOST_CHECK_EQUAL(value, "four");
+  BOOST_CHECK(cache.Evict(value));
+  BOOST_CHECK_EQUAL(value, "five");
+  BOOST_CHECK(!cache.Evict(value));
+
+  cache.Insert(4, "four");
+  cache.Clear();
+  BOOST_CHECK(cache.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
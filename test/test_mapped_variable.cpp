@@ -0,0 +1,93 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/mapped_variable.hpp>
+#include <string>
+#include <vector>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_mapped_variable)
+
+static void CheckEqual(const std::valarray<double>& values,
+                       const std::valarray<double>& expected) {
+  BOOST_REQUIRE_EQUAL(values.size(), expected.size());
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    BOOST_CHECK_EQUAL(values[ix], expected[ix]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_read) {
+  TempFile temp;
+  {
+    netcdf::File file(temp.Path(), "w");
+    auto group = file.AddGroup("grp");
+    auto x = group.AddDimension("x", 40);
+    auto y = group.AddDimension("y", 50);
+    std::vector<netcdf::Dimension> dims({x, y});
+    auto contiguous =
+        group.AddVariable("contiguous", netcdf::type::Double(file), dims);
+    contiguous.SetContiguous();
+    auto chunked =
+        group.AddVariable("chunked", netcdf::type::Double(file), dims);
+    chunked.SetChunking(std::vector<size_t>({10, 10}));
+    chunked.SetDeflate(true, 4);
+
+    std::valarray<double> values(40 * 50);
+    for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix * 0.5;
+    contiguous.Write(values);
+    chunked.Write(values);
+  }
+
+  netcdf::File file(temp.Path());
+  auto group = file.GetNamedGroup("grp");
+  netcdf::Hyperslab strided(std::vector<size_t>({3, 1}),
+                            std::vector<size_t>({40, 50}),
+                            std::vector<ptrdiff_t>({5, 3}));
+  netcdf::Hyperslab block(std::vector<size_t>({2, 7}),
+                          std::vector<size_t>({12, 19}));
+  // The end of the ranges is past the shape of the variable
+  netcdf::Hyperslab overshoot(std::vector<size_t>({3, 1}),
+                              std::vector<size_t>({42, 51}),
+                              std::vector<ptrdiff_t>({5, 3}));
+
+  for (auto& name : {"contiguous", "chunked"}) {
+    auto variable = *group.FindVariable(name);
+    netcdf::MappedVariable mapped(variable);
+#ifdef NETCDF4_CXX_HAVE_HDF5
+    BOOST_CHECK_EQUAL(mapped.IsMapped(), std::string(name) == "contiguous");
+#endif
+    BOOST_CHECK_EQUAL(mapped.data() != nullptr, mapped.IsMapped());
+    CheckEqual(mapped.Read<double>(), variable.Read<double>());
+    CheckEqual(mapped.Read<double>(strided), variable.Read<double>(strided));
+    CheckEqual(mapped.Read<double>(block), variable.Read<double>(block));
+    CheckEqual(mapped.Read<double>(overshoot),
+               variable.Read<double>(overshoot));
+  }
+  file.Close();
+
+  // A file open for writing is not mapped
+  file.Open(temp.Path(), "r+");
+  netcdf::MappedVariable mapped(
+      *file.GetNamedGroup("grp").FindVariable("contiguous"));
+  BOOST_CHECK(!mapped.IsMapped());
+  BOOST_CHECK_EQUAL(mapped.Read<double>()[3], 1.5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,147 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cmath>
+#include <limits>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/packing.hpp>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_packing)
+
+BOOST_AUTO_TEST_CASE(test_min_max) {
+  // The size is not a multiple of the SIMD width
+  std::vector<double> values(1001);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = std::sin(static_cast<double>(ix)) * 100;
+  }
+  values[10] = std::numeric_limits<double>::quiet_NaN();
+  values[11] = std::numeric_limits<double>::infinity();
+  values[12] = -std::numeric_limits<double>::infinity();
+  values[500] = -250;
+  values[1000] = 250;
+
+  double min, max;
+  BOOST_CHECK(netcdf::Packing::MinMax(values.data(), values.size(), min, max));
+  BOOST_CHECK_EQUAL(min, -250);
+  BOOST_CHECK_EQUAL(max, 250);
+
+  std::vector<float> floats(values.begin(), values.end());
+  BOOST_CHECK(netcdf::Packing::MinMax(floats.data(), floats.size(), min, max));
+  BOOST_CHECK_EQUAL(min, -250);
+  BOOST_CHECK_EQUAL(max, 250);
+
+  std::vector<int> integers{3, -7, 12};
+  BOOST_CHECK(
+      netcdf::Packing::MinMax(integers.data(), integers.size(), min, max));
+  BOOST_CHECK_EQUAL(min, -7);
+  BOOST_CHECK_EQUAL(max, 12);
+
+  std::vector<double> nan(5, std::numeric_limits<double>::quiet_NaN());
+  BOOST_CHECK(!netcdf::Packing::MinMax(nan.data(), nan.size(), min, max));
+}
+
+BOOST_AUTO_TEST_CASE(test_compute) {
+  netcdf::Packing packing = netcdf::Packing::Compute(-10, 10, 16);
+  BOOST_CHECK_CLOSE(packing.get_max_error(), 10.0 / 65534, 1e-9);
+
+  // The attributes follow the CF conventions: the step between two packed
+  // values and the center of the range
+  BOOST_CHECK_CLOSE(packing.get_scale_factor(), 20.0 / 65534, 1e-9);
+  BOOST_CHECK_EQUAL(packing.get_add_offset(), 0);
+
+  short packed[3];
+  const double values[3] = {-10, 10, std::numeric_limits<double>::quiet_NaN()};
+  packing.Pack(values, 3, packed);
+  BOOST_CHECK_EQUAL(packed[0], -32767);
+  BOOST_CHECK_EQUAL(packed[1], 32767);
+  BOOST_CHECK_EQUAL(packed[2], -32768);
+
+  packing = netcdf::Packing::Compute(0, 100, 16, 0.01);
+  BOOST_CHECK_CLOSE(packing.get_max_error(), 0.01, 1e-9);
+  BOOST_CHECK_THROW(netcdf::Packing::Compute(0, 100, 8, 0.01),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::Packing::Compute(1, 0, 16), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_pack_and_write) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 100);
+  netcdf::Dimension y = file.AddDimension("y", 30);
+  netcdf::type::Short type(file);
+  netcdf::Variable variable = file.AddVariable("a", type, {x, y});
+  variable.SetChunking({10, 30});
+
+  std::valarray<double> values(3000);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = ix % 13 == 0 ? std::numeric_limits<double>::quiet_NaN()
+                              : std::cos(static_cast<double>(ix)) * 40 + 273;
+  }
+  netcdf::Packing packing = variable.PackAndWrite(values);
+  BOOST_CHECK(variable.GetScaleMissing().has_fill_value());
+
+  BOOST_CHECK_EQUAL(
+      variable.FindAttribute("scale_factor")->ReadScalar<double>(),
+      packing.get_scale_factor());
+  BOOST_CHECK_EQUAL(variable.FindAttribute("add_offset")->ReadScalar<double>(),
+                    packing.get_add_offset());
+
+  std::valarray<short> packed = variable.Read<short>();
+  std::valarray<double> unpacked = variable.ReadMaskAndScale<double>();
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    if (ix % 13 == 0) {
+      BOOST_CHECK_EQUAL(packed[ix], -32768);
+      BOOST_CHECK(std::isnan(unpacked[ix]));
+    } else {
+      BOOST_CHECK_EQUAL(unpacked[ix], packed[ix] * packing.get_scale_factor() +
+                                          packing.get_add_offset());
+      BOOST_CHECK_LE(std::abs(unpacked[ix] - values[ix]),
+                     packing.get_max_error() * (1 + 1e-9));
+    }
+  }
+
+  // An existing fill value must not be one of the packed integers
+  netcdf::Variable masked = file.AddVariable("c", type, {x, y});
+  masked.AddAttribute("_FillValue").Write(type, std::vector<short>{-1});
+  BOOST_CHECK_THROW(masked.PackAndWrite(values), std::invalid_argument);
+  BOOST_CHECK(masked.FindAttribute("scale_factor") == nullptr);
+
+  netcdf::Variable filled = file.AddVariable("d", type, {x, y});
+  filled.AddAttribute("_FillValue").Write(type, std::vector<short>{-32768});
+  packing = filled.PackAndWrite(values);
+  packed = filled.Read<short>();
+  unpacked = filled.ReadMaskAndScale<double>();
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    if (ix % 13 == 0) {
+      BOOST_CHECK_EQUAL(packed[ix], -32768);
+      BOOST_CHECK(std::isnan(unpacked[ix]));
+    } else {
+      BOOST_CHECK_LE(std::abs(unpacked[ix] - values[ix]),
+                     packing.get_max_error() * (1 + 1e-9));
+    }
+  }
+
+  // Float variables can not receive packed values
+  netcdf::type::Float float_type(file);
+  netcdf::Variable other = file.AddVariable("b", float_type, {x, y});
+  BOOST_CHECK_THROW(other.PackAndWrite(values), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
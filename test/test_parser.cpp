@@ -98,6 +98,48 @@ BOOST_AUTO_TEST_CASE(test_function) {
   BOOST_CHECK_EQUAL(query.Evaluate("iif(0, 2, 3)"), 3);
 }
 
+BOOST_AUTO_TEST_CASE(test_user_defined_function) {
+  QueryProxy query;
+
+  netcdf::Query::RegisterFunction(
+      "hypot", netcdf::Function(
+                   2,
+                   [](const std::vector<std::valarray<double>>& args) {
+                     return static_cast<std::valarray<double>>(
+                         std::sqrt(args[0] * args[0] + args[1] * args[1]));
+                   },
+                   "m"));
+
+  BOOST_CHECK_EQUAL(query.Evaluate("hypot(3, 4)"), 5);
+  BOOST_CHECK_EQUAL(query.Evaluate("2 * hypot(3, 4)"), 10);
+  BOOST_CHECK_EQUAL(query.Evaluate("x=3; hypot(x, 2 + 2)"), 5);
+  BOOST_CHECK_THROW(query.Evaluate("hypot(3)"),
+                    netcdf::parser::SyntaxError);
+
+  netcdf::parser::LiteralExpression expr(query, "hypot(3, 4)");
+  expr.Evaluate();
+  BOOST_CHECK_EQUAL(expr.GetUnit(), "m");
+  netcdf::parser::LiteralExpression other(query, "hypot(3, 4) + 1");
+  other.Evaluate();
+  BOOST_CHECK_EQUAL(other.GetUnit(), "");
+
+  BOOST_CHECK_THROW(
+      netcdf::Query::RegisterFunction(
+          "sin", netcdf::Function(1, [](const std::vector<std::valarray<double>>&
+                                            args) { return args[0]; })),
+      std::invalid_argument);
+  // Characters outside the ASCII range are not letters
+  BOOST_CHECK_THROW(
+      netcdf::Query::RegisterFunction(
+          "\xe9t\xe9",
+          netcdf::Function(1, [](const std::vector<std::valarray<double>>&
+                                     args) { return args[0]; })),
+      std::invalid_argument);
+  BOOST_CHECK(netcdf::Query::UnregisterFunction("hypot"));
+  BOOST_CHECK(!netcdf::Query::UnregisterFunction("hypot"));
+  BOOST_CHECK_THROW(query.Evaluate("hypot(3, 4)"), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(test_comparison) {
   QueryProxy query;
 
@@ -152,4 +194,63 @@ BOOST_AUTO_TEST_CASE(test_basic) {
        (std::pow(std::cos(x), 2))));
 }
 
+BOOST_AUTO_TEST_CASE(test_references) {
+  auto references = netcdf::parser::LiteralExpression::GetVariables(
+      "${a} + ${ /forecast/member03/t2m } * ${obs:sst} - ${a}");
+  BOOST_REQUIRE_EQUAL(references.size(), 3);
+  BOOST_CHECK_EQUAL(references.front(), "a");
+  BOOST_CHECK_EQUAL(*std::next(references.begin()), "/forecast/member03/t2m");
+  BOOST_CHECK_EQUAL(references.back(), "obs:sst");
+
+  BOOST_CHECK_THROW(netcdf::parser::LiteralExpression::GetVariables("${a"),
+                    netcdf::parser::SyntaxError);
+  BOOST_CHECK_THROW(netcdf::parser::LiteralExpression::GetVariables("${ }"),
+                    netcdf::parser::SyntaxError);
+
+  auto split = netcdf::QueryContext::SplitReference("obs:/analysis/sst");
+  BOOST_CHECK_EQUAL(split.first, "obs");
+  BOOST_CHECK_EQUAL(split.second, "/analysis/sst");
+  split = netcdf::QueryContext::SplitReference("/g/a:b");
+  BOOST_CHECK_EQUAL(split.first, "");
+  BOOST_CHECK_EQUAL(split.second, "/g/a:b");
+}
+
+BOOST_AUTO_TEST_CASE(test_profile) {
+  netcdf::Query query;
+  netcdf::File file;
+  std::string unit;
+  netcdf::profile::Profiler profiler;
+  netcdf::QueryProxy proxy(query, file, unit, netcdf::Hyperslab(), &profiler);
+
+  double result = netcdf::parser::LiteralExpression(
+                      proxy, "x = 2; sqrt(x * 8) + 1").Evaluate();
+  BOOST_CHECK_EQUAL(result, 5);
+
+  auto& root = profiler.root();
+  BOOST_REQUIRE_EQUAL(root.children().size(), 2);
+  BOOST_CHECK_EQUAL(root.elements(), 1);
+
+  auto& assignment = root.children().front();
+  BOOST_CHECK_EQUAL(assignment.name(), "x =");
+  BOOST_REQUIRE_EQUAL(assignment.children().size(), 1);
+  BOOST_CHECK_EQUAL(assignment.children().front().name(), "2");
+
+  auto& plus = root.children().back();
+  BOOST_CHECK_EQUAL(plus.name(), "+");
+  BOOST_REQUIRE_EQUAL(plus.children().size(), 2);
+  auto& sqrt = plus.children().front();
+  BOOST_CHECK_EQUAL(sqrt.name(), "sqrt()");
+  BOOST_REQUIRE_EQUAL(sqrt.children().size(), 1);
+  auto& mul = sqrt.children().front();
+  BOOST_CHECK_EQUAL(mul.name(), "*");
+  BOOST_REQUIRE_EQUAL(mul.children().size(), 2);
+  BOOST_CHECK_EQUAL(mul.children().front().name(), "x");
+  BOOST_CHECK_EQUAL(mul.children().back().name(), "8");
+  BOOST_CHECK_EQUAL(plus.children().back().name(), "1");
+  BOOST_CHECK_GE(plus.wall_time(), sqrt.wall_time());
+
+  BOOST_CHECK(profiler.ToString().find("-> sqrt()") != std::string::npos);
+  BOOST_CHECK(profiler.ToJson().find("\"name\":\"*\"") != std::string::npos);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
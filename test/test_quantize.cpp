@@ -0,0 +1,130 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cmath>
+#include <limits>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/quantize.hpp>
+
+#include "tempfile.hpp"
+
+// Values covering the special cases. The size is not a multiple of the SIMD
+// width.
+template <typename T>
+static std::vector<T> GetValues(const T fill_value) {
+  std::vector<T> result(1001);
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    result[ix] = static_cast<T>(std::sin(static_cast<double>(ix)) * 1000);
+  }
+  result[1] = std::numeric_limits<T>::quiet_NaN();
+  result[2] = std::numeric_limits<T>::infinity();
+  result[3] = 0;
+  result[5] = fill_value;
+  return result;
+}
+
+template <typename T>
+static void CheckQuantize(const netcdf::QuantizeMode mode, const int nsd,
+                          const double tolerance) {
+  const T fill_value = static_cast<T>(NC_FILL_FLOAT);
+  const std::vector<T> values = GetValues<T>(fill_value);
+  std::vector<T> result(values);
+  netcdf::Quantize(result.data(), result.size(), mode, nsd, fill_value);
+
+  BOOST_CHECK(std::isnan(result[1]));
+  BOOST_CHECK_EQUAL(result[2], values[2]);
+  BOOST_CHECK_EQUAL(result[3], 0);
+  BOOST_CHECK_EQUAL(result[5], fill_value);
+  for (size_t ix = 6; ix < values.size(); ++ix) {
+    BOOST_CHECK_LE(std::abs(result[ix] - values[ix]),
+                   std::abs(values[ix]) * tolerance);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(test_quantize)
+
+BOOST_AUTO_TEST_CASE(test_algorithms) {
+  CheckQuantize<float>(netcdf::QuantizeMode::kBitRound, 10, std::ldexp(1, -11));
+  CheckQuantize<double>(netcdf::QuantizeMode::kBitRound, 20,
+                        std::ldexp(1, -21));
+  CheckQuantize<float>(netcdf::QuantizeMode::kBitGroom, 3, 1e-3);
+  CheckQuantize<double>(netcdf::QuantizeMode::kBitGroom, 6, 1e-6);
+  CheckQuantize<float>(netcdf::QuantizeMode::kGranularBitRound, 3, 5e-3);
+  CheckQuantize<double>(netcdf::QuantizeMode::kGranularBitRound, 6, 5e-6);
+
+  // Ties are rounded to even
+  std::vector<float> values{1.0f, 1.25f, 1.5f, 1.75f};
+  netcdf::Quantize(values.data(), values.size(),
+                   netcdf::QuantizeMode::kBitRound, 1, NC_FILL_FLOAT);
+  BOOST_CHECK_EQUAL(values[0], 1.0f);
+  BOOST_CHECK_EQUAL(values[1], 1.0f);
+  BOOST_CHECK_EQUAL(values[2], 1.5f);
+  BOOST_CHECK_EQUAL(values[3], 2.0f);
+
+  BOOST_CHECK_THROW(netcdf::Quantize(values.data(), values.size(),
+                                     netcdf::QuantizeMode::kBitGroom, 8,
+                                     NC_FILL_FLOAT),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::Quantize(values.data(), values.size(),
+                                     netcdf::QuantizeMode::kBitRound, 0,
+                                     NC_FILL_FLOAT),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_quantize_and_write) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 1001);
+  netcdf::type::Float type(file);
+  netcdf::Variable variable = file.AddVariable("a", type, {x});
+
+  std::vector<float> values = GetValues<float>(NC_FILL_FLOAT);
+  std::valarray<float> data(values.data(), values.size());
+  variable.QuantizeAndWrite(netcdf::Hyperslab(), data,
+                            netcdf::QuantizeMode::kBitRound, 10);
+  netcdf::Quantize(values.data(), values.size(),
+                   netcdf::QuantizeMode::kBitRound, 10, NC_FILL_FLOAT);
+  std::valarray<float> result = variable.Read<float>();
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    if (ix != 1) BOOST_CHECK_EQUAL(result[ix], values[ix]);
+  }
+
+  // The values must have the type of the variable
+  netcdf::Variable doubles =
+      file.AddVariable("c", netcdf::type::Double(file), {x});
+  BOOST_CHECK_THROW(
+      doubles.QuantizeAndWrite(netcdf::Hyperslab(), data,
+                               netcdf::QuantizeMode::kBitRound, 10),
+      std::invalid_argument);
+  std::valarray<double> wide(1001);
+  BOOST_CHECK_THROW(
+      variable.QuantizeAndWrite(netcdf::Hyperslab(), wide,
+                                netcdf::QuantizeMode::kBitRound, 10),
+      std::invalid_argument);
+
+#ifdef NC_QUANTIZE_BITGROOM
+  netcdf::Variable other = file.AddVariable("b", type, {x});
+  other.SetQuantize(netcdf::QuantizeMode::kGranularBitRound, 4);
+  int nsd;
+  BOOST_CHECK(other.GetQuantize(nsd) ==
+              netcdf::QuantizeMode::kGranularBitRound);
+  BOOST_CHECK_EQUAL(nsd, 4);
+#endif
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,190 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cmath>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/query.hpp>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_query)
+
+BOOST_AUTO_TEST_CASE(test_evaluate_into) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 10);
+  netcdf::Dimension y = file.AddDimension("y", 4);
+  netcdf::Variable a =
+      file.AddVariable("a", netcdf::type::Double(file), {x, y});
+  a.AddAttribute("units").WriteText("m");
+
+  std::valarray<double> values(40);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = static_cast<double>(ix);
+  }
+  a.Write(netcdf::Hyperslab(a.GetShape()), values);
+
+  netcdf::Query query;
+  netcdf::EvaluateOptions options;
+  options.tile_size = 8;
+  options.chunk_sizes = {3, 4};
+
+  netcdf::Variable b = query.EvaluateInto(file, "${a} * 2", file, "b", options);
+  BOOST_CHECK(b.GetShape() == a.GetShape());
+  BOOST_CHECK_EQUAL(b.FindAttribute("units")->ReadText(), "m");
+  std::valarray<double> result = b.Read<double>();
+  BOOST_REQUIRE_EQUAL(result.size(), values.size());
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], values[ix] * 2);
+  }
+
+  options.fill_value = -1;
+  netcdf::Variable c =
+      query.EvaluateInto(file, "sqrt(${a} - 5)", file, "c", options);
+  BOOST_CHECK_EQUAL(c.FindAttribute("_FillValue")->ReadScalar<double>(), -1);
+  result = c.Read<double>();
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], ix < 5 ? -1 : std::sqrt(values[ix] - 5));
+  }
+
+  BOOST_CHECK_THROW(query.EvaluateInto(file, "${z} * 2", file, "d"),
+                    std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_evaluate_into_user_defined_function) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 16);
+  netcdf::Variable a = file.AddVariable("a", netcdf::type::Double(file), {x});
+  a.AddAttribute("units").WriteText("m");
+  std::valarray<double> values(16);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = static_cast<double>(ix);
+  }
+  a.Write(netcdf::Hyperslab(a.GetShape()), values);
+
+  netcdf::Query::RegisterFunction(
+      "to_km", netcdf::Function(
+                   1,
+                   [](const std::vector<std::valarray<double>>& args) {
+                     return static_cast<std::valarray<double>>(args[0] *
+                                                               0.001);
+                   },
+                   "km", netcdf::type::Primitive::kFloat));
+
+  netcdf::Query query;
+  netcdf::EvaluateOptions options;
+  options.tile_size = 5;
+  netcdf::Variable b =
+      query.EvaluateInto(file, "to_km(${a})", file, "b", options);
+  BOOST_CHECK(b.GetDataType().GetPrimitive() ==
+              netcdf::type::Primitive::kFloat);
+  BOOST_CHECK_EQUAL(b.FindAttribute("units")->ReadText(), "km");
+  std::valarray<float> result = b.Read<float>();
+  BOOST_REQUIRE_EQUAL(result.size(), values.size());
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], static_cast<float>(values[ix] * 0.001));
+  }
+  netcdf::Query::UnregisterFunction("to_km");
+}
+
+BOOST_AUTO_TEST_CASE(test_evaluate_profile) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 10);
+  netcdf::Variable a = file.AddVariable("a", netcdf::type::Float(file), {x});
+  a.Write(netcdf::Hyperslab(a.GetShape()), std::valarray<float>(2, 10));
+
+  netcdf::Query query;
+  netcdf::profile::Profiler profiler;
+  std::valarray<double> result = query.Evaluate(file, "${a} * 3", profiler);
+  BOOST_REQUIRE_EQUAL(result.size(), 10);
+  BOOST_CHECK_EQUAL(result[0], 6);
+
+  BOOST_CHECK_EQUAL(profiler.bytes_read().at("a"), 10 * sizeof(float));
+  BOOST_CHECK_EQUAL(profiler.root().bytes_read(), 10 * sizeof(float));
+  BOOST_CHECK_EQUAL(profiler.root().elements(), 10);
+
+  auto& mul = profiler.root().children().front();
+  BOOST_CHECK_EQUAL(mul.name(), "*");
+  auto& load = mul.children().front();
+  BOOST_CHECK_EQUAL(load.name(), "${a}");
+  BOOST_REQUIRE_EQUAL(load.children().size(), 2);
+  BOOST_CHECK_EQUAL(load.children().front().name(), "read");
+  BOOST_CHECK_EQUAL(load.children().back().name(), "mask_and_scale");
+}
+
+BOOST_AUTO_TEST_CASE(test_evaluate_context) {
+  TempFile obs_path, model_path;
+  netcdf::File obs(obs_path.Path(), "w");
+  netcdf::Group analysis = obs.AddGroup("analysis");
+  netcdf::Dimension x = obs.AddDimension("x", 6);
+  netcdf::Variable sst =
+      analysis.AddVariable("sst", netcdf::type::Double(analysis), {x});
+  sst.Write(netcdf::Hyperslab(sst.GetShape()), std::valarray<double>(20, 6));
+
+  netcdf::File model(model_path.Path(), "w");
+  x = model.AddDimension("x", 6);
+  netcdf::Variable a = model.AddVariable("sst", netcdf::type::Double(model), {x});
+  std::valarray<double> values(6);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = static_cast<double>(ix);
+  }
+  a.Write(netcdf::Hyperslab(a.GetShape()), values);
+
+  netcdf::Query query;
+  std::valarray<double> result = query.Evaluate(obs, "${/analysis/sst} * 2");
+  BOOST_REQUIRE_EQUAL(result.size(), 6);
+  BOOST_CHECK_EQUAL(result[0], 40);
+
+  netcdf::QueryContext context(model);
+  context.Add("obs", obs);
+  netcdf::profile::Profiler profiler;
+  result = query.Evaluate(context, "${obs:/analysis/sst} - ${sst}", profiler);
+  BOOST_REQUIRE_EQUAL(result.size(), 6);
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], 20 - values[ix]);
+  }
+  BOOST_CHECK_EQUAL(profiler.bytes_read().at("obs:/analysis/sst"),
+                    6 * sizeof(double));
+
+  // A variable prefetched is loaded again when used twice
+  result = query.Evaluate(context, "${sst} * ${obs:/analysis/sst} + ${sst}");
+  BOOST_REQUIRE_EQUAL(result.size(), 6);
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], values[ix] * 21);
+  }
+
+  netcdf::EvaluateOptions options;
+  options.tile_size = 4;
+  netcdf::Variable b = query.EvaluateInto(
+      context, "${obs:/analysis/sst} + ${sst}", model, "b", options);
+  result = b.Read<double>();
+  BOOST_REQUIRE_EQUAL(result.size(), 6);
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix], 20 + values[ix]);
+  }
+
+  BOOST_CHECK_THROW(query.Evaluate(context, "${model:sst}"),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(query.Evaluate(context, "${obs:sst} + ${sst}"),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(context.Add("1obs", obs), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
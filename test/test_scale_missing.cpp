@@ -0,0 +1,213 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <cmath>
+#include <limits>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/masked_array.hpp>
+#include <netcdf4_cxx/scale_missing.hpp>
+
+#include "tempfile.hpp"
+
+// Values covering all the cases handled: valid, NaN, _FillValue,
+// missing_value and outside the valid range. The size is not a multiple of
+// the SIMD width.
+template <typename T>
+static std::valarray<T> GetValues() {
+  std::valarray<T> result(1003);
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    switch (ix % 7) {
+      case 0:
+        result[ix] = std::numeric_limits<T>::quiet_NaN();
+        break;
+      case 1:
+        result[ix] = -1;
+        break;
+      case 2:
+        result[ix] = 32767;
+        break;
+      case 3:
+        result[ix] = 20000;
+        break;
+      default:
+        result[ix] = static_cast<T>(ix % 1000);
+    }
+  }
+  return result;
+}
+
+template <typename T>
+static void CheckOperations(const netcdf::ScaleMissing& scale_missing) {
+  const std::valarray<T> values = GetValues<T>();
+  auto missing = [](const T x) {
+    return std::isnan(x) || x == -1 || x == 32767 || x < 0 || x > 10000;
+  };
+
+  std::valarray<T> result = values;
+  scale_missing.MaskAndDeflate(result, static_cast<T>(-999));
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix],
+                      missing(values[ix])
+                          ? static_cast<T>(-999)
+                          : static_cast<T>(values[ix] * 0.5 + 10.0));
+  }
+
+  result = values;
+  scale_missing.Mask(result, static_cast<T>(-999));
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    BOOST_CHECK_EQUAL(result[ix],
+                      missing(values[ix]) ? static_cast<T>(-999) : values[ix]);
+  }
+
+  result = values;
+  scale_missing.Inflate(result);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    if (std::isnan(values[ix]))
+      BOOST_CHECK(std::isnan(result[ix]));
+    else
+      BOOST_CHECK_EQUAL(result[ix],
+                        missing(values[ix])
+                            ? values[ix]
+                            : static_cast<T>((values[ix] - 10.0) / 0.5));
+  }
+}
+
+template <typename T>
+static void CheckValidity(const netcdf::ScaleMissing& scale_missing) {
+  std::valarray<T> values = GetValues<T>();
+  netcdf::MaskedArray<T> masked(std::valarray<T>(values), scale_missing, true);
+  BOOST_REQUIRE_EQUAL(masked.size(), values.size());
+  BOOST_REQUIRE_EQUAL(masked.validity().size(), (values.size() + 7) / 8);
+  BOOST_CHECK(masked.HasReasons());
+
+  size_t missing = 0;
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    const netcdf::MaskReason reason =
+        scale_missing.GetMaskReason(static_cast<double>(values[ix]));
+    BOOST_CHECK_EQUAL(masked.IsValid(ix), reason == netcdf::MaskReason::kValid);
+    BOOST_CHECK(masked.GetReason(ix) == reason);
+    missing += reason != netcdf::MaskReason::kValid;
+  }
+  BOOST_CHECK_EQUAL(masked.GetNullCount(), missing);
+
+  // Padding bits are cleared
+  BOOST_CHECK_EQUAL(masked.validity().back() >> (values.size() % 8), 0);
+}
+
+BOOST_AUTO_TEST_SUITE(test_scale_missing)
+
+BOOST_AUTO_TEST_CASE(test_operations) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 1);
+  netcdf::type::Double type(file);
+  netcdf::Variable variable = file.AddVariable("a", type, {x});
+  variable.AddAttribute("scale_factor").Write(type, std::vector<double>{0.5});
+  variable.AddAttribute("add_offset").Write(type, std::vector<double>{10});
+  variable.AddAttribute("_FillValue").Write(type, std::vector<double>{32767});
+  variable.AddAttribute("missing_value").Write(type, std::vector<double>{-1});
+  variable.AddAttribute("valid_range")
+      .Write(type, std::vector<double>{0, 10000});
+
+  netcdf::ScaleMissing scale_missing(variable);
+  BOOST_CHECK(scale_missing.IsMissing(-1));
+  BOOST_CHECK(scale_missing.IsMissing(32767));
+  BOOST_CHECK(scale_missing.IsMissing(20000));
+  BOOST_CHECK(scale_missing.IsMissing(std::nan("")));
+  BOOST_CHECK(!scale_missing.IsMissing(42));
+
+  CheckOperations<float>(scale_missing);
+  CheckOperations<double>(scale_missing);
+
+  // Integer types use the generic implementation
+  std::valarray<int> values{-1, 42, 20000, 32767, 7};
+  scale_missing.Mask(values, 0);
+  BOOST_CHECK_EQUAL(values[0], 0);
+  BOOST_CHECK_EQUAL(values[1], 42);
+  BOOST_CHECK_EQUAL(values[2], 0);
+  BOOST_CHECK_EQUAL(values[3], 0);
+  BOOST_CHECK_EQUAL(values[4], 7);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_mask_and_scale) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 4);
+  netcdf::type::Double double_type(file);
+  netcdf::type::Short type(file);
+  netcdf::Variable variable = file.AddVariable("a", type, {x});
+  variable.AddAttribute("scale_factor")
+      .Write(double_type, std::vector<double>{0.01});
+  variable.AddAttribute("add_offset")
+      .Write(double_type, std::vector<double>{280});
+  variable.AddAttribute("_FillValue").Write(type, std::vector<short>{-32768});
+  std::valarray<short> packed{0, 100, -500, -32768};
+  variable.Write(packed);
+
+  // The values are unpacked as defined by the CF conventions
+  std::valarray<double> values = variable.ReadMaskAndScale<double>();
+  BOOST_REQUIRE_EQUAL(values.size(), 4);
+  BOOST_CHECK_CLOSE(values[0], 280, 1e-9);
+  BOOST_CHECK_CLOSE(values[1], 281, 1e-9);
+  BOOST_CHECK_CLOSE(values[2], 275, 1e-9);
+  BOOST_CHECK(std::isnan(values[3]));
+}
+
+BOOST_AUTO_TEST_CASE(test_validity) {
+  TempFile temp;
+  netcdf::File file(temp.Path(), "w");
+  netcdf::Dimension x = file.AddDimension("x", 1003);
+  netcdf::type::Short type(file);
+  netcdf::Variable variable = file.AddVariable("a", type, {x});
+  variable.AddAttribute("_FillValue").Write(type, std::vector<short>{32767});
+  variable.AddAttribute("missing_value").Write(type, std::vector<short>{-1});
+  variable.AddAttribute("valid_range")
+      .Write(type, std::vector<short>{0, 10000});
+
+  const netcdf::ScaleMissing& scale_missing = variable.GetScaleMissing();
+  BOOST_CHECK(scale_missing.GetMaskReason(32767) ==
+              netcdf::MaskReason::kFillValue);
+  BOOST_CHECK(scale_missing.GetMaskReason(-1) ==
+              netcdf::MaskReason::kMissingValue);
+  BOOST_CHECK(scale_missing.GetMaskReason(-2) ==
+              netcdf::MaskReason::kBelowMinimum);
+  BOOST_CHECK(scale_missing.GetMaskReason(20000) ==
+              netcdf::MaskReason::kAboveMaximum);
+  BOOST_CHECK(scale_missing.GetMaskReason(std::nan("")) ==
+              netcdf::MaskReason::kNaN);
+  BOOST_CHECK(scale_missing.GetMaskReason(42) == netcdf::MaskReason::kValid);
+
+  CheckValidity<short>(scale_missing);
+  CheckValidity<int>(scale_missing);
+  CheckValidity<float>(scale_missing);
+  CheckValidity<double>(scale_missing);
+
+  // The values read keep their storage type
+  std::valarray<short> values = GetValues<short>();
+  variable.Write(netcdf::Hyperslab(std::vector<size_t>({1003})), values);
+  netcdf::MaskedArray<short> masked = variable.ReadMasked<short>();
+  BOOST_CHECK(!masked.HasReasons());
+  BOOST_CHECK_THROW(masked.GetReason(0), std::logic_error);
+  std::valarray<short> filled = masked.Filled(-999);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    BOOST_CHECK_EQUAL(masked.values()[ix], values[ix]);
+    BOOST_CHECK_EQUAL(filled[ix], masked.IsValid(ix) ? values[ix] : -999);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
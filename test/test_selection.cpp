@@ -0,0 +1,285 @@
+/* This file is part of NetCDF4_CXX library.
+
+   NetCDF4_CXX is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   NetCDF4_CXX is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with NetCDF4_CXX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <boost/test/test_tools.hpp>
+#include <boost/test/unit_test_suite.hpp>
+#include <netcdf4_cxx/file.hpp>
+#include <netcdf4_cxx/selection.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "tempfile.hpp"
+
+BOOST_AUTO_TEST_SUITE(test_selection)
+
+BOOST_AUTO_TEST_CASE(test_constructor) {
+  netcdf::PointSelection selection(
+      std::vector<std::vector<size_t>>({{1, 2, 3}, {4, 5, 6}}));
+  BOOST_CHECK_EQUAL(selection.GetRank(), 2);
+  BOOST_CHECK_EQUAL(selection.GetSize(), 3);
+  BOOST_CHECK_EQUAL(selection[1][0], 2);
+  BOOST_CHECK_EQUAL(selection[1][1], 5);
+
+  auto points = netcdf::PointSelection::FromPoints({{1, 4}, {2, 5}, {3, 6}});
+  BOOST_CHECK(points.coordinates() == selection.coordinates());
+
+  auto outer = netcdf::PointSelection::Outer({{1, 2}, {7, 8, 9}});
+  BOOST_CHECK_EQUAL(outer.GetSize(), 6);
+  BOOST_CHECK_EQUAL(outer[4][0], 2);
+  BOOST_CHECK_EQUAL(outer[4][1], 8);
+
+  BOOST_CHECK_THROW(netcdf::PointSelection(2, std::vector<size_t>({1, 2, 3})),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::PointSelection(
+                        std::vector<std::vector<size_t>>({{1, 2}, {3}})),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::PointSelection::FromPoints({{1, 2}, {3}}),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_coalesce) {
+  // Four points in two chunks of a 100 x 100 grid, one of them repeated
+  auto selection = netcdf::PointSelection::FromPoints(
+      {{12, 12}, {1, 2}, {2, 1}, {13, 13}, {1, 2}});
+  std::vector<size_t> shape({100, 100});
+
+  auto blocks = netcdf::Coalesce(selection, shape, {10, 10});
+  BOOST_REQUIRE_EQUAL(blocks.size(), 2);
+  BOOST_CHECK(blocks[0].box.start() == std::vector<size_t>({1, 1}));
+  BOOST_CHECK(blocks[0].box.end() == std::vector<size_t>({3, 3}));
+  BOOST_REQUIRE_EQUAL(blocks[0].points.size(), 3);
+  BOOST_CHECK_EQUAL(blocks[0].points[0], 1);
+  BOOST_CHECK_EQUAL(blocks[0].offsets[0], 1);
+  BOOST_CHECK_EQUAL(blocks[0].points[1], 4);
+  BOOST_CHECK_EQUAL(blocks[0].offsets[1], 1);
+  BOOST_CHECK_EQUAL(blocks[0].points[2], 2);
+  BOOST_CHECK_EQUAL(blocks[0].offsets[2], 2);
+  BOOST_CHECK(blocks[1].box.start() == std::vector<size_t>({12, 12}));
+  BOOST_CHECK_EQUAL(blocks[1].box.GetSize(), 4);
+
+  // Stored contiguously, the points are close enough to be read at once
+  blocks = netcdf::Coalesce(selection, shape, {});
+  BOOST_REQUIRE_EQUAL(blocks.size(), 1);
+  BOOST_CHECK_EQUAL(blocks[0].box.GetSize(), 13 * 13);
+
+  // Distant points are read separately
+  shape = std::vector<size_t>({10000, 10000});
+  selection = netcdf::PointSelection::FromPoints({{0, 0}, {9999, 9999}});
+  blocks = netcdf::Coalesce(selection, shape, {});
+  BOOST_REQUIRE_EQUAL(blocks.size(), 2);
+  BOOST_CHECK_EQUAL(blocks[0].box.GetSize(), 1);
+  BOOST_CHECK_EQUAL(blocks[1].points[0], 1);
+
+  BOOST_CHECK_THROW(netcdf::Coalesce(netcdf::PointSelection::FromPoints(
+                                         {{10000, 0}}),
+                                     shape, {}),
+                    std::invalid_argument);
+  BOOST_CHECK_THROW(netcdf::Coalesce(netcdf::PointSelection::FromPoints({{0}}),
+                                     shape, {}),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_read) {
+  TempFile temp;
+  {
+    netcdf::File file(temp.Path(), "w");
+    auto x = file.AddDimension("x", 120);
+    auto y = file.AddDimension("y", 80);
+    auto chunked = file.AddVariable("chunked", netcdf::type::Int(file),
+                                    std::vector<netcdf::Dimension>({x, y}));
+    chunked.SetChunking(std::vector<size_t>({16, 16}));
+    auto contiguous =
+        file.AddVariable("contiguous", netcdf::type::Int(file),
+                         std::vector<netcdf::Dimension>({x, y}));
+    contiguous.SetContiguous();
+
+    std::valarray<int> values(120 * 80);
+    for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix;
+    chunked.Write(values);
+    contiguous.Write(values);
+  }
+
+  std::vector<size_t> coordinates;
+  for (size_t ix = 0; ix < 500; ++ix) {
+    coordinates.push_back((ix * 7919) % 120);
+    coordinates.push_back((ix * 104729) % 80);
+  }
+  netcdf::PointSelection selection(2, coordinates);
+
+  netcdf::File file(temp.Path());
+  for (auto& name : {"chunked", "contiguous"}) {
+    auto variable = file.FindVariable(name);
+    auto values = variable->Read<double>(selection);
+    BOOST_REQUIRE_EQUAL(values.size(), 500);
+    for (size_t ix = 0; ix < 500; ++ix) {
+      BOOST_CHECK_EQUAL(values[ix],
+                        coordinates[ix * 2] * 80 + coordinates[ix * 2 + 1]);
+    }
+  }
+  BOOST_CHECK(file.FindVariable("chunked")->GetChunking() ==
+              std::vector<size_t>({16, 16}));
+  BOOST_CHECK(file.FindVariable("contiguous")->GetChunking().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_schedule) {
+  // Two boxes of a 20 x 20 grid, overlapping the same 10 x 10 chunk
+  std::vector<netcdf::Hyperslab> hyperslabs;
+  hyperslabs.emplace_back(std::vector<size_t>({12, 2}),
+                          std::vector<size_t>({14, 4}));
+  hyperslabs.emplace_back(std::vector<size_t>({1, 1}),
+                          std::vector<size_t>({13, 3}));
+  std::vector<size_t> shape({20, 20});
+
+  auto reads = netcdf::ScheduleChunkReads(hyperslabs, shape, {10, 10});
+  BOOST_REQUIRE_EQUAL(reads.size(), 2);
+  BOOST_CHECK(reads[0].box.start() == std::vector<size_t>({1, 1}));
+  BOOST_CHECK(reads[0].box.end() == std::vector<size_t>({10, 3}));
+  BOOST_REQUIRE_EQUAL(reads[0].extracts.size(), 1);
+  BOOST_CHECK(reads[1].box.start() == std::vector<size_t>({10, 1}));
+  BOOST_CHECK(reads[1].box.end() == std::vector<size_t>({14, 4}));
+  BOOST_REQUIRE_EQUAL(reads[1].extracts.size(), 2);
+
+  // Values of the second box in the chunk: rows 10 to 12, columns 1 to 2
+  std::vector<int> box(12);
+  for (size_t ix = 0; ix < box.size(); ++ix) box[ix] = ix;
+  std::vector<int> values(24, -1);
+  auto& extract = reads[1].extracts[1];
+  BOOST_CHECK_EQUAL(extract.hyperslab, 1);
+  extract.Copy(&box[0], &values[0]);
+  BOOST_CHECK_EQUAL(values[17], -1);
+  BOOST_CHECK_EQUAL(values[18], 0);
+  BOOST_CHECK_EQUAL(values[19], 1);
+  BOOST_CHECK_EQUAL(values[22], 6);
+  BOOST_CHECK_EQUAL(values[23], 7);
+
+  auto order = netcdf::SortByOffset(hyperslabs, shape);
+  BOOST_CHECK_EQUAL(order[0], 1);
+  BOOST_CHECK_EQUAL(order[1], 0);
+
+  // The end of the range is past the shape, the last row selected is not
+  hyperslabs.emplace_back(std::vector<size_t>({0, 0}),
+                          std::vector<size_t>({21, 20}),
+                          std::vector<ptrdiff_t>({6, 1}));
+  reads = netcdf::ScheduleChunkReads(hyperslabs, shape, {10, 10});
+  BOOST_CHECK_EQUAL(reads.size(), 4);
+  BOOST_CHECK_EQUAL(netcdf::SortByOffset(hyperslabs, shape)[0], 2);
+
+  hyperslabs.emplace_back(std::vector<size_t>({21, 20}));
+  BOOST_CHECK_THROW(netcdf::ScheduleChunkReads(hyperslabs, shape, {10, 10}),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_many) {
+  TempFile temp;
+  {
+    netcdf::File file(temp.Path(), "w");
+    auto x = file.AddDimension("x", 60);
+    auto y = file.AddDimension("y", 40);
+    auto chunked = file.AddVariable("chunked", netcdf::type::Float(file),
+                                    std::vector<netcdf::Dimension>({x, y}));
+    chunked.SetChunking(std::vector<size_t>({16, 16}));
+    chunked.SetDeflate(true, 4);
+    auto contiguous =
+        file.AddVariable("contiguous", netcdf::type::Float(file),
+                         std::vector<netcdf::Dimension>({x, y}));
+    contiguous.SetContiguous();
+
+    std::valarray<float> values(60 * 40);
+    for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix;
+    chunked.Write(values);
+    contiguous.Write(values);
+  }
+
+  std::vector<netcdf::Hyperslab> hyperslabs;
+  hyperslabs.emplace_back(std::vector<size_t>({5, 5}),
+                          std::vector<size_t>({20, 20}));
+  hyperslabs.emplace_back(std::vector<size_t>({0, 0}),
+                          std::vector<size_t>({60, 40}),
+                          std::vector<ptrdiff_t>({7, 3}));
+  hyperslabs.emplace_back(std::vector<size_t>({30, 17}),
+                          std::vector<size_t>({31, 18}));
+  hyperslabs.emplace_back(std::vector<size_t>({8, 8}),
+                          std::vector<size_t>({8, 12}));
+  hyperslabs.emplace_back(std::vector<size_t>({3, 0}),
+                          std::vector<size_t>({62, 40}),
+                          std::vector<ptrdiff_t>({7, 13}));
+
+  netcdf::File file(temp.Path());
+  for (auto& name : {"chunked", "contiguous"}) {
+    auto variable = file.FindVariable(name);
+    auto result = variable->ReadMany<double>(hyperslabs);
+    BOOST_REQUIRE_EQUAL(result.size(), hyperslabs.size());
+    for (size_t ix = 0; ix < hyperslabs.size(); ++ix) {
+      BOOST_REQUIRE_EQUAL(result[ix].size(), hyperslabs[ix].GetSize());
+      if (result[ix].size() == 0) continue;
+      auto expected = variable->Read<double>(hyperslabs[ix]);
+      for (size_t jx = 0; jx < expected.size(); ++jx) {
+        BOOST_CHECK_EQUAL(result[ix][jx], expected[jx]);
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_read_enclosing_box) {
+  // Adjacent values are read directly
+  BOOST_CHECK(!netcdf::ReadEnclosingBox(netcdf::Hyperslab(
+      std::vector<size_t>({0, 0}), std::vector<size_t>({10, 10}))));
+
+  // One value out of two, read one by one by the netCDF library
+  BOOST_CHECK(netcdf::ReadEnclosingBox(netcdf::Hyperslab(
+      std::vector<size_t>({0, 0}), std::vector<size_t>({100, 100}),
+      std::vector<ptrdiff_t>({2, 2}))));
+
+  // Sparse values
+  BOOST_CHECK(!netcdf::ReadEnclosingBox(netcdf::Hyperslab(
+      std::vector<size_t>({0, 0}), std::vector<size_t>({10000, 10000}),
+      std::vector<ptrdiff_t>({1000, 1000}))));
+
+  // Long rows, one out of two, are read row by row
+  netcdf::Hyperslab rows(std::vector<size_t>({0, 0}),
+                         std::vector<size_t>({100, 1000}),
+                         std::vector<ptrdiff_t>({2, 1}));
+  BOOST_CHECK(!netcdf::ReadEnclosingBox(rows));
+  BOOST_CHECK(netcdf::ReadEnclosingBox(rows, 1000));
+}
+
+BOOST_AUTO_TEST_CASE(test_reverse) {
+  // 3 x 20 values read in increasing order, the rows and the columns being
+  // selected in decreasing order
+  netcdf::Hyperslab hyperslab(std::vector<netcdf::Range>(
+      {netcdf::Range(0, 3).Reversed(), netcdf::Range(0, 20).Reversed()}));
+  std::vector<double> values(60);
+  for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix;
+  netcdf::Reverse(hyperslab, &values[0], sizeof(double));
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    BOOST_CHECK_EQUAL(values[ix], 59 - ix);
+  }
+
+  // Only the rows reversed
+  hyperslab = netcdf::Hyperslab(std::vector<netcdf::Range>(
+      {netcdf::Range(0, 3).Reversed(), netcdf::Range(0, 20)}));
+  std::vector<short> rows(60);
+  for (size_t ix = 0; ix < rows.size(); ++ix) rows[ix] = ix;
+  netcdf::Reverse(hyperslab, &rows[0], sizeof(short));
+  BOOST_CHECK_EQUAL(rows[0], 40);
+  BOOST_CHECK_EQUAL(rows[19], 59);
+  BOOST_CHECK_EQUAL(rows[20], 20);
+  BOOST_CHECK_EQUAL(rows[59], 19);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -16,6 +16,7 @@
 
 #include <boost/test/test_tools.hpp>
 #include <boost/test/unit_test_suite.hpp>
+#include <cmath>
 #include <netcdf4_cxx/object.hpp>
 #include <netcdf4_cxx/variable.hpp>
 
@@ -206,4 +207,254 @@ BOOST_AUTO_TEST_CASE(test_compound) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(test_read_unpacked) {
+  Object object;
+  std::vector<size_t> shape({20, 30});
+  std::vector<int> dimid(shape.size());
+  int varid;
+
+  nc_def_dim(object.nc_id(), "x", shape[0], &dimid[0]);
+  nc_def_dim(object.nc_id(), "y", shape[1], &dimid[1]);
+  nc_def_var(object.nc_id(), "packed", NC_SHORT, shape.size(), &dimid[0],
+             &varid);
+
+  netcdf::Variable netcdf_var(object, varid);
+  netcdf::type::Double type(object);
+  netcdf::type::Short short_type(object);
+  netcdf_var.AddAttribute("scale_factor").Write(type, std::vector<double>{0.01});
+  netcdf_var.AddAttribute("add_offset").Write(type, std::vector<double>{-5});
+  netcdf_var.AddAttribute("_FillValue")
+      .Write(short_type, std::vector<short>{-32767});
+
+  std::valarray<short> packed(shape[0] * shape[1]);
+  for (size_t ix = 0; ix < packed.size(); ++ix) {
+    packed[ix] = ix % 11 == 0 ? -32767 : static_cast<short>(ix * 3 - 700);
+  }
+  netcdf_var.Write(netcdf::Hyperslab(shape), packed);
+
+  // The fused path gives the result of ReadMaskAndScale
+  std::valarray<double> reference = netcdf_var.ReadMaskAndScale<double>();
+  std::valarray<float> result = netcdf_var.ReadUnpacked<float>();
+  BOOST_REQUIRE_EQUAL(result.size(), reference.size());
+  for (size_t ix = 0; ix < result.size(); ++ix) {
+    if (ix % 11 == 0)
+      BOOST_CHECK(std::isnan(result[ix]));
+    else
+      BOOST_CHECK_EQUAL(result[ix], static_cast<float>(reference[ix]));
+  }
+
+  // Region read with small tiles
+  netcdf::Hyperslab select(std::vector<size_t>({1, 2}),
+                           std::vector<size_t>({19, 29}),
+                           std::vector<ptrdiff_t>({3, 2}));
+  std::valarray<double> region =
+      netcdf_var.ReadUnpacked<double>(select, -999, 20);
+  BOOST_REQUIRE_EQUAL(region.size(), select.GetSize());
+  netcdf::Range rx = select.GetRange(0);
+  netcdf::Range ry = select.GetRange(1);
+  for (size_t i = 0; i < select.GetSize(0); ++i) {
+    for (size_t j = 0; j < select.GetSize(1); ++j) {
+      const size_t index = rx.Item(i) * shape[1] + ry.Item(j);
+      const double expected =
+          index % 11 == 0 ? -999 : packed[index] * 0.01 - 5.0;
+      BOOST_CHECK_EQUAL(region[j + i * select.GetSize(1)], expected);
+    }
+  }
+
+  // The description of the packing follows the attributes modified
+  netcdf_var.RemoveAttribute("_FillValue");
+  BOOST_CHECK(!netcdf_var.GetScaleMissing().has_fill_value());
+}
+
+BOOST_AUTO_TEST_CASE(test_read_packed) {
+  Object object;
+  std::vector<size_t> shape({10, 12});
+  std::vector<int> dimid(shape.size());
+  std::vector<int> varid(5);
+
+  nc_def_dim(object.nc_id(), "x", shape[0], &dimid[0]);
+  nc_def_dim(object.nc_id(), "y", shape[1], &dimid[1]);
+  nc_def_var(object.nc_id(), "packed", NC_SHORT, shape.size(), &dimid[0],
+             &varid[0]);
+  nc_def_var(object.nc_id(), "copy", NC_SHORT, shape.size(), &dimid[0],
+             &varid[1]);
+  nc_def_var(object.nc_id(), "repacked", NC_INT, shape.size(), &dimid[0],
+             &varid[2]);
+  nc_def_var(object.nc_id(), "refilled", NC_SHORT, shape.size(), &dimid[0],
+             &varid[3]);
+  nc_def_var(object.nc_id(), "clipped", NC_BYTE, shape.size(), &dimid[0],
+             &varid[4]);
+
+  netcdf::type::Double type(object);
+  netcdf::type::Short short_type(object);
+  netcdf::Variable packed_var(object, varid[0]);
+  netcdf::Variable copy_var(object, varid[1]);
+  netcdf::Variable repacked_var(object, varid[2]);
+  netcdf::Variable refilled_var(object, varid[3]);
+  netcdf::Variable clipped_var(object, varid[4]);
+  for (auto& item : {packed_var, copy_var}) {
+    item.AddAttribute("scale_factor").Write(type, std::vector<double>{0.01});
+    item.AddAttribute("add_offset").Write(type, std::vector<double>{-5});
+    item.AddAttribute("_FillValue")
+        .Write(short_type, std::vector<short>{-32767});
+  }
+  repacked_var.AddAttribute("scale_factor")
+      .Write(type, std::vector<double>{0.1});
+  refilled_var.AddAttribute("scale_factor")
+      .Write(type, std::vector<double>{0.01});
+  refilled_var.AddAttribute("add_offset").Write(type, std::vector<double>{-5});
+  refilled_var.AddAttribute("_FillValue")
+      .Write(short_type, std::vector<short>{-1});
+  clipped_var.AddAttribute("scale_factor")
+      .Write(type, std::vector<double>{0.05});
+
+  std::valarray<short> values(shape[0] * shape[1]);
+  for (size_t ix = 0; ix < values.size(); ++ix) {
+    values[ix] = ix % 7 == 0 ? -32767 : static_cast<short>(ix * 5 - 300);
+  }
+  packed_var.Write(netcdf::Hyperslab(shape), values);
+
+  // Values are unpacked on demand
+  netcdf::PackedArray<short> packed = packed_var.ReadPacked<short>();
+  std::valarray<double> reference = packed_var.ReadMaskAndScale<double>();
+  BOOST_REQUIRE_EQUAL(packed.size(), reference.size());
+  for (size_t ix = 0; ix < packed.size(); ++ix) {
+    BOOST_CHECK_EQUAL(packed.raw()[ix], values[ix]);
+    if (ix % 7 == 0)
+      BOOST_CHECK(std::isnan(packed.Get<double>(ix)));
+    else
+      BOOST_CHECK_EQUAL(packed.Get<double>(ix), reference[ix]);
+  }
+  BOOST_CHECK_THROW(packed.Get<double>(packed.size()), std::out_of_range);
+
+  size_t count = 0;
+  packed.ForEachBlock<float>(
+      25,
+      [&](const size_t first, const float* block, const size_t size) {
+        BOOST_CHECK_EQUAL(first, count);
+        for (size_t ix = 0; ix < size; ++ix) {
+          BOOST_CHECK_EQUAL(block[ix],
+                            (first + ix) % 7 == 0
+                                ? -1.0f
+                                : static_cast<float>(reference[first + ix]));
+        }
+        count += size;
+      },
+      -1.0f);
+  BOOST_CHECK_EQUAL(count, packed.size());
+
+  // Same packing: the raw values are written
+  copy_var.Write(netcdf::Hyperslab(shape), packed);
+  std::valarray<short> copy = copy_var.Read<short>();
+  for (size_t ix = 0; ix < copy.size(); ++ix) {
+    BOOST_CHECK_EQUAL(copy[ix], values[ix]);
+  }
+
+  // Different packing: the values are packed again
+  repacked_var.Write(netcdf::Hyperslab(shape), packed);
+  std::valarray<int> repacked = repacked_var.Read<int>();
+  for (size_t ix = 0; ix < repacked.size(); ++ix) {
+    BOOST_CHECK_EQUAL(repacked[ix], ix % 7 == 0
+                                        ? NC_FILL_INT
+                                        : static_cast<int>(std::nearbyint(
+                                              reference[ix] / 0.1)));
+  }
+
+  // Same scale_factor and add_offset, but another _FillValue: the values are
+  // packed again
+  BOOST_CHECK(!refilled_var.GetScaleMissing().HasSamePacking(
+      packed_var.GetScaleMissing()));
+  refilled_var.Write(netcdf::Hyperslab(shape), packed);
+  std::valarray<short> refilled = refilled_var.Read<short>();
+  for (size_t ix = 0; ix < refilled.size(); ++ix) {
+    BOOST_CHECK_EQUAL(refilled[ix], ix % 7 == 0 ? -1 : values[ix]);
+  }
+
+  // The values outside the range of the packed type are clipped
+  clipped_var.Write(netcdf::Hyperslab(shape), packed);
+  std::valarray<int> clipped = clipped_var.Read<int>();
+  for (size_t ix = 0; ix < clipped.size(); ++ix) {
+    BOOST_CHECK_EQUAL(
+        clipped[ix],
+        ix % 7 == 0 ? NC_FILL_BYTE
+                    : std::max(-128, static_cast<int>(std::nearbyint(
+                                         reference[ix] / 0.05))));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_read_strided) {
+  Object object;
+  std::vector<size_t> shape({10, 10});
+  std::vector<int> dimid(shape.size());
+  int varid;
+
+  nc_def_dim(object.nc_id(), "x", shape[0], &dimid[0]);
+  nc_def_dim(object.nc_id(), "y", shape[1], &dimid[1]);
+  nc_def_var(object.nc_id(), "grid", NC_INT, shape.size(), &dimid[0],
+             &varid);
+
+  netcdf::Variable netcdf_var(object, varid);
+  std::valarray<int> values(shape[0] * shape[1]);
+  for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix;
+  netcdf_var.Write(netcdf::Hyperslab(shape), values);
+
+  // The end of the ranges is past the shape, the last value selected is not
+  netcdf::Hyperslab select(std::vector<size_t>({0, 1}),
+                           std::vector<size_t>({12, 11}),
+                           std::vector<ptrdiff_t>({3, 2}));
+  BOOST_REQUIRE(netcdf::ReadEnclosingBox(select));
+  std::valarray<int> result = netcdf_var.Read<int>(select);
+  BOOST_REQUIRE_EQUAL(result.size(), 20);
+  for (size_t i = 0; i < 4; ++i) {
+    for (size_t j = 0; j < 5; ++j) {
+      BOOST_CHECK_EQUAL(result[i * 5 + j], i * 30 + 1 + j * 2);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_read_reversed) {
+  Object object;
+  std::vector<size_t> shape({18, 36});
+  std::vector<int> dimid(shape.size());
+  int varid;
+
+  nc_def_dim(object.nc_id(), "lat", shape[0], &dimid[0]);
+  nc_def_dim(object.nc_id(), "lon", shape[1], &dimid[1]);
+  nc_def_var(object.nc_id(), "grid", NC_FLOAT, shape.size(), &dimid[0],
+             &varid);
+
+  netcdf::Variable netcdf_var(object, varid);
+  std::valarray<float> values(shape[0] * shape[1]);
+  for (size_t ix = 0; ix < values.size(); ++ix) values[ix] = ix;
+  netcdf_var.Write(netcdf::Hyperslab(shape), values);
+
+  // Grid flipped from north to south, and a strided reversed region
+  std::vector<netcdf::Hyperslab> hyperslabs;
+  hyperslabs.emplace_back(std::vector<netcdf::Range>(
+      {netcdf::Range(0, shape[0]).Reversed(), netcdf::Range(shape[1])}));
+  hyperslabs.emplace_back(std::vector<size_t>({15, 33}),
+                          std::vector<size_t>({2, 1}),
+                          std::vector<ptrdiff_t>({-2, -5}));
+
+  for (auto& select : hyperslabs) {
+    std::valarray<double> result = netcdf_var.Read<double>(select);
+    BOOST_REQUIRE_EQUAL(result.size(), select.GetSize());
+    netcdf::Range rx = select.GetRange(0);
+    netcdf::Range ry = select.GetRange(1);
+    for (size_t i = 0; i < select.GetSize(0); ++i) {
+      for (size_t j = 0; j < select.GetSize(1); ++j) {
+        BOOST_CHECK_EQUAL(result[i * select.GetSize(1) + j],
+                          rx[i] * shape[1] + ry[j]);
+      }
+    }
+  }
+  std::valarray<float> flipped = netcdf_var.Read<float>(hyperslabs[0]);
+  BOOST_CHECK_EQUAL(flipped[0], (shape[0] - 1) * shape[1]);
+
+  auto many = netcdf_var.ReadMany<double>(hyperslabs);
+  BOOST_REQUIRE_EQUAL(many.size(), 2);
+  BOOST_CHECK_EQUAL(many[1][0], 15 * shape[1] + 33);
+  BOOST_CHECK_EQUAL(many[1][many[1].size() - 1], 3 * shape[1] + 3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()